@@ -45,7 +45,17 @@
 #include "lima/Timestamp.h"
 #include "lima/HwEventCtrlObj.h"
 
+#include "HamamatsuFrameCopy.h"
+#include "HamamatsuFrameCopyPool.h"
+#include "HamamatsuLatencyRecorder.h"
+#include "HamamatsuRawWriter.h"
+#include "HamamatsuFrameSnapshot.h"
+#include "HamamatsuRollingMetrics.h"
+#include "HamamatsuSystemTuning.h"
+
 #include <ostream>
+#include <deque>
+#include <atomic>
 
 using namespace std;
 
@@ -63,7 +73,7 @@ namespace lima
  * \class Camera
  * \brief object controlling the Hamamatsu camera via DCAM-SDK
  *******************************************************************/
-	class LIBHAMAMATSU_API Camera
+	class LIBHAMAMATSU_API Camera : public HwMaxImageSizeCallbackGen
 	{
 	    DEB_CLASS_NAMESPC(DebModCamera, "Camera", "Hamamatsu");
 	    friend class Interface;
@@ -143,6 +153,64 @@ namespace lima
             Output_Trigger_Polarity_Positive, // DCAMPROP_OUTPUTTRIGGER_POLARITY__POSITIVE
         };
 
+        // relative to DCAM_IDPROP_SUBTRACT_DATASTATUS and DCAM_IDPROP_SHADINGCALIB_DATASTATUS
+        enum Calibration_Status
+        {
+            Calibration_Status_Not_Supported,
+            Calibration_Status_None         , // DCAMPROP_CALIBDATASTATUS__NONE
+            Calibration_Status_Forward      , // DCAMPROP_CALIBDATASTATUS__FORWARD
+            Calibration_Status_Backward     , // DCAMPROP_CALIBDATASTATUS__BACKWARD
+            Calibration_Status_Both         , // DCAMPROP_CALIBDATASTATUS__BOTH
+        };
+
+        // behaviour when hardware frames are lost (ring overrun or frames dropped before the ring)
+        enum Overrun_Policy
+        {
+            Overrun_Policy_Stop       , // stop the acquisition with an error
+            Overrun_Policy_Skip       , // keep the lima numbering consecutive, the gaps are recorded (see getFrameGaps)
+            Overrun_Policy_Placeholder, // give a zero filled frame to lima for each lost frame (lima frame n is hardware frame n)
+        };
+
+        // use of the DCAM exposure end events to drive the status
+        enum Exposure_Events_Mode
+        {
+            Exposure_Events_Auto, // in the trigger per frame modes without frame bundle
+            Exposure_Events_On  , // always (the thread wakes up at each exposure)
+            Exposure_Events_Off , // never
+        };
+
+        // lost hardware frames
+        struct FrameGap
+        {
+            int first_hw_frame ; // number of the first lost hardware frame (images in frame bundle mode)
+            int nb_frames      ; // number of lost frames
+            int next_lima_frame; // lima number of the first frame given after the gap
+        };
+
+        // state of the DCAM recorder (see setRecordingEnabled)
+        struct RecordingStatus
+        {
+            bool        recording        ; // a recorder file is open
+            std::string file_name        ; // path of the latest recorder file (without extension)
+            int         nb_frames        ; // DCAM frames written in the file
+            int         nb_missed        ; // DCAM frames the recorder could not write
+            int         nb_missed_events ; // DCAMWAIT_RECEVENT_MISSED events received
+            int         nb_skipped_events; // DCAMWAIT_RECEVENT_SKIPPED events received
+            double      throughput       ; // MB/s written since the start of the recording
+            std::string error            ; // disk full or write fault description (empty if none)
+        };
+
+        // software trigger to frame latencies of the current (or latest) IntTrigMult acquisition
+        struct TriggerLatency
+        {
+            int    nb_triggers; // software triggers fired since the acquisition start
+            int    nb_frames  ; // frames received for these triggers
+            double last       ; // latency of the latest frame (s)
+            double min        ; // minimum latency (s)
+            double mean       ; // mean latency (s)
+            double max        ; // maximum latency (s)
+        };
+
 	//-----------------------------------------------------------------------------
 	public:
 	    Camera(const std::string& config_path,int camera_number=0, int frame_buffer_size=10);
@@ -204,7 +272,168 @@ namespace lima
 	    void setFastExtTrigger(bool flag);
 	    void getFastExtTrigger(bool& flag);
 		void getLostFrames(unsigned long int& lost_frames);	///< [out] current lost frames
-		void getFPS(double& fps);							///< [out] last computed fps
+		void getFPS(double& fps);							///< [out] frame rate over the metrics window
+
+        void setZeroCopyEnabled(const bool & in_enabled); ///< [in] true to attach the lima buffers as DCAM ring
+        bool getZeroCopyEnabled(void);
+        bool getZeroCopyActive (void);
+
+        bool isFrameBundleSupported     (void);
+        void setFrameBundleNumber       (const int in_bundle_number); ///< [in] frames per bundle (1: disabled, 0: automatic)
+        int  getFrameBundleNumber       (void);
+        int  getFrameBundleActiveNumber (void);
+
+        void setCopyThreadsNumber(const int in_nb_threads); ///< [in] number of copy threads (0: copy in the acquisition thread)
+        int  getCopyThreadsNumber(void);
+
+        void        setCopyNonTemporalThreshold(const long in_threshold); ///< [in] frame size (bytes) from which streaming stores are used (0: cache size)
+        long        getCopyNonTemporalThreshold(void);
+        void        setCopySplitThreshold      (const long in_threshold); ///< [in] frame size (bytes) from which a frame is copied by several threads (0: never)
+        long        getCopySplitThreshold      (void);
+        std::string getCopyKernelName          (void);
+        void        benchmarkFrameCopy         (const int in_nb_iterations, ///< [in]  number of copies to time
+                                                double &  out_memcpy_rate , ///< [out] line by line memcpy rate (MB/s)
+                                                double &  out_kernel_rate); ///< [out] copy kernel rate (MB/s)
+        void        benchmarkFrameUnpack       (const int in_nb_iterations, ///< [in]  number of unpacks to time
+                                                double &  out_scalar_rate , ///< [out] scalar unpack rate (MB/s of 16 bits pixels)
+                                                double &  out_kernel_rate); ///< [out] unpack kernel rate (MB/s of 16 bits pixels)
+
+        void   setRingAutoSizeEnabled  (const bool   in_enabled ); ///< [in] true to compute the DCAM ring depth at each acquisition
+        bool   getRingAutoSizeEnabled  (void);
+        void   setRingDepth            (const int    in_depth   ); ///< [in] DCAM ring depth used when the automatic size is disabled
+        void   setRingMemoryBudget     (const double in_budget  ); ///< [in] maximum memory of the DCAM ring (MB)
+        double getRingMemoryBudget     (void);
+        void   setRingLatencyTolerance (const double in_latency ); ///< [in] acquisition thread stall the DCAM ring must absorb (s)
+        double getRingLatencyTolerance (void);
+        int    getRingDepth            (void);
+        int    getRingHighWaterMark    (void);
+
+        void   getAcqTimings           (double & out_prepare_time, ///< [out] duration of the latest prepareAcq (s)
+                                        double & out_start_time  , ///< [out] duration of the latest startAcq until the capture start (s)
+                                        double & out_stop_time   ); ///< [out] duration of the latest stopAcq (s)
+
+        bool   getHwTimestampSupported (void);
+        bool   getHwFramestampSupported(void);
+        void   setHwTimestampEnabled   (const bool in_enabled); ///< [in] true to timestamp the frames with the DCAM timestamps
+        bool   getHwTimestampEnabled   (void);
+        double getHwClockOffset        (void);
+        void   getFrameStamps          (const int in_frame_nb     , ///< [in]  lima frame number
+                                        int &     out_framestamp  , ///< [out] DCAM framestamp of the frame
+                                        double &  out_hw_timestamp); ///< [out] DCAM timestamp of the frame, in host clock (s)
+
+        void   setOverrunPolicy        (const Overrun_Policy in_policy); ///< [in] behaviour when hardware frames are lost
+        enum Overrun_Policy getOverrunPolicy(void);
+        void   getFrameGaps            (std::vector<FrameGap> & out_gaps); ///< [out] lost hardware frames of the current (or latest) acquisition
+
+        void   getTriggerLatency       (TriggerLatency & out_latency); ///< [out] software trigger to frame latencies of the current (or latest) acquisition
+
+        void   setAccumulationNbFrames (const int in_nb_frames); ///< [in] hardware images summed in each Bpp32/Bpp32F frame
+        int    getAccumulationNbFrames (void);
+        void   getAccumulationInfo     (const int in_frame_nb     , ///< [in]  lima frame number
+                                        int &     out_nb_images   , ///< [out] hardware images summed in the frame
+                                        long &    out_nb_saturated, ///< [out] saturated pixels found in these images
+                                        double &  out_exposure    ); ///< [out] total exposure time of the frame (s)
+
+        bool   getExposureEventsSupported(void);
+        void   setExposureEventsMode   (const Exposure_Events_Mode in_mode); ///< [in] use of the DCAM exposure end events
+        enum Exposure_Events_Mode getExposureEventsMode(void);
+        void   getLastExposureEnd      (double & out_timestamp   , ///< [out] host time of the latest exposure end (s, 0 if none)
+                                        int &    out_nb_exposures); ///< [out] number of exposure ends since the acquisition start
+
+        void   setLatencyRecordEnabled (const bool in_enabled   ); ///< [in] true to record the per-frame latencies of the next acquisitions
+        bool   getLatencyRecordEnabled (void);
+        void   setLatencyRecordSize    (const int  in_nb_records); ///< [in] number of frames kept (rounded up to a power of two)
+        int    getLatencyRecordSize    (void);
+        void   getLatencyStatistics    (const LatencyRecorder::Stage in_from, ///< [in]  first stage
+                                        const LatencyRecorder::Stage in_to  , ///< [in]  last stage
+                                        int &    out_nb ,                     ///< [out] number of frames used
+                                        double & out_p50,                     ///< [out] median latency (s)
+                                        double & out_p99,                     ///< [out] 99th percentile latency (s)
+                                        double & out_max);                    ///< [out] maximum latency (s)
+        void   getQueueDepthStatistics (int & out_p50,  ///< [out] median number of DCAM frames waiting when a frame is found
+                                        int & out_p99,  ///< [out] 99th percentile
+                                        int & out_max); ///< [out] maximum
+        void   dumpLatencyRecords      (const std::string & in_file_name); ///< [in] path of the CSV file to write
+
+        void   setMetricsWindow        (const double in_window); ///< [in] time covered by the rolling metrics (s)
+        double getMetricsWindow        (void);
+        void   getRollingMetrics       (RollingMetrics::Values & out_metrics); ///< [out] metrics of the latest window
+
+        void   setAcqThreadPriority    (const SystemTuning::Priority in_priority); ///< [in] scheduling priority of the acquisition thread
+        SystemTuning::Priority getAcqThreadPriority(void);
+        void   setAcqThreadCpus        (const std::vector<int> & in_cpus); ///< [in] cpus of the acquisition thread (empty: all, or the NUMA node cpus)
+        void   getAcqThreadCpus        (std::vector<int> & out_cpus);      ///< [out] cpus of the acquisition thread set by setAcqThreadCpus
+        void   setNumaNode             (const int in_node); ///< [in] NUMA node of the frame grabber (-1: none)
+        int    getNumaNode             (void);
+        std::string getAcqThreadSettings(void);
+
+        void   setBufferPrefaultEnabled (const bool in_enabled); ///< [in] true to touch the lima buffers in prepareAcq
+        bool   getBufferPrefaultEnabled (void);
+        void   setBufferLockEnabled     (const bool in_enabled); ///< [in] true to lock the lima buffers in physical memory
+        bool   getBufferLockEnabled     (void);
+        void   setBufferHugePagesEnabled(const bool in_enabled); ///< [in] true to ask for huge pages behind the lima buffers
+        bool   getBufferHugePagesEnabled(void);
+        double getBufferLockedSize      (void);
+        int    getBufferNumaNode        (void);
+
+        void   setPackedTransferEnabled (const bool in_enabled); ///< [in] true to transfer 12 bits packed pixels (unpacked to 16 bits)
+        bool   getPackedTransferEnabled (void);
+
+        void   setBitWindow             (const int in_shift); ///< [in] lowest bit of the 8 bits window in Bpp8 (-1: selected by the camera)
+        int    getBitWindow             (void);
+        bool   getBitWindowInSoftware   (void);
+
+        void   setRecordingEnabled      (const bool in_enabled); ///< [in] true to record the next acquisitions with the DCAM recorder
+        bool   getRecordingEnabled      (void);
+        void   setRecordingPath         (const std::string & in_path); ///< [in] recorder files path, without extension
+        std::string getRecordingPath    (void);
+        void   setRecordingMaxFrames    (const int in_nb_frames); ///< [in] recorder file size in DCAM frames for the continuous acquisitions
+        int    getRecordingMaxFrames    (void);
+        void   setRecordingLiveDecimation(const int in_decimation); ///< [in] one image out of in_decimation given to lima while recording (0: none)
+        int    getRecordingLiveDecimation(void);
+
+        void   setLiveDecimation        (const int in_decimation); ///< [in] one hardware image out of in_decimation given to lima (1: all)
+        int    getLiveDecimation        (void);
+        void   setLiveMaxFrameRate      (const double in_rate); ///< [in] maximum number of images given to lima per second (0: no limit)
+        double getLiveMaxFrameRate      (void);
+        void   getRecordingStatus       (RecordingStatus & out_status); ///< [out] recorder state of the current (or latest) acquisition
+
+        void   setRawWriterEnabled      (const bool in_enabled); ///< [in] true to stream the raw frames of the next acquisitions to disk
+        bool   getRawWriterEnabled      (void);
+        void   setRawWriterPath         (const std::string & in_path); ///< [in] raw stream files path, without extension
+        std::string getRawWriterPath    (void);
+        void   setRawWriterFileSize     (const long long in_size); ///< [in] size of a raw data file (bytes)
+        long long getRawWriterFileSize  (void);
+        void   setRawWriterSlots        (const int in_nb_slots); ///< [in] number of frames the raw writer can hold
+        int    getRawWriterSlots        (void);
+        void   setRawWriterDirectIo     (const bool in_enabled); ///< [in] true to bypass the system cache for the raw data files
+        bool   getRawWriterDirectIo     (void);
+        void   getRawWriterStatus       (RawWriter::Status & out_status); ///< [out] raw stream state of the current (or latest) acquisition
+
+        void   setSnapshotEnabled       (const bool in_enabled); ///< [in] true to keep the latest frame of the next acquisitions out of the lima buffers
+        bool   getSnapshotEnabled       (void);
+        void   setSnapshotMaxRate       (const double in_rate); ///< [in] maximum number of snapshot updates per second (0: every frame)
+        double getSnapshotMaxRate       (void);
+        bool   getLatestFrame           (FrameSnapshot::Info & out_info,  ///< [out] stamps of the latest frame
+                                         std::vector<char>   & out_data); ///< [out] pixels of the latest frame
+
+        void   captureDarkCalibration     (const int in_page); ///< [in] camera memory page receiving the dark image
+        void   captureShadingCalibration  (const int in_page); ///< [in] camera memory page receiving the shading data
+        void   setDarkSubtractionEnabled  (const bool in_enabled); ///< [in] true to subtract the dark image during the acquisitions
+        bool   getDarkSubtractionEnabled  (void);
+        void   setDarkSubtractionPage     (const int in_page); ///< [in] camera memory page of the subtracted dark image
+        int    getDarkSubtractionPage     (void);
+        void   setShadingCorrectionEnabled(const bool in_enabled); ///< [in] true to correct the shading during the acquisitions
+        bool   getShadingCorrectionEnabled(void);
+        void   setShadingCorrectionPage   (const int in_page); ///< [in] camera memory page of the shading correction data
+        int    getShadingCorrectionPage   (void);
+        enum Calibration_Status getDarkCalibrationStatus   (void);
+        enum Calibration_Status getShadingCalibrationStatus(void);
+
+        void   setRegions               (const std::vector<Roi> & in_regions); ///< [in] sensor regions given to lima, packed in one frame (empty: none)
+        void   getRegions               (std::vector<Roi> & out_regions); ///< [out] sensor regions of the acquisitions
+        void   getRegionsLayout         (std::vector<Roi> & out_layout);  ///< [out] position of each region in the lima frame
+        bool   getRegionsInHardware     (void);
    
         void setSyncReadoutBlankMode(enum SyncReadOut_BlankMode in_sync_read_out_mode); ///< [in] type of sync-readout trigger's blank
 
@@ -229,6 +458,13 @@ namespace lima
         void setViewMode(bool in_view_mode_activated,  ///< [in] view mode activation or not
                          int  in_views_number       ); ///< [in] number of views if view mode activated
 
+        void setViewSplitEnabled(const bool in_enabled); ///< [in] true to give each view of the two W-Views as its own lima frame
+        bool getViewSplitEnabled(void);
+        int  getFrameView       (const int in_frame_nb); ///< [in] lima frame number
+
+        void setViewRois(const std::vector<Roi> & in_view_rois); ///< [in] subarray of each of the two W-Views (empty: whole views)
+        void getViewRois(std::vector<Roi> & out_view_rois);      ///< [out] subarray of each of the two W-Views (empty: whole views)
+
         //-- Output Triggers  control
         void setOutputTriggerKind    (int channel,                                                   ///< [in] channel to set
                                       enum Camera::Output_Trigger_Kind in_output_trig_kind);                 ///< [in] kind of the channel to set
@@ -315,6 +551,27 @@ namespace lima
         **/
         void getPropertyData(int32 property, int32 & array_base, int32 & step_element);
 
+        double getPredictedFrameRate(void);
+        int    computeAutoFrameBundleNumber(void);
+
+        void   runCalibrationCapture   (const int32  in_capture_mode, ///< [in] DCAMPROP_CAPTUREMODE__DARKCALIB or DCAMPROP_CAPTUREMODE__SHADINGCALIB
+                                        const int32  in_samples_id  , ///< [in] property giving the number of averaged images
+                                        const int32  in_store_id    , ///< [in] property storing the result in the camera memory
+                                        const int    in_page        , ///< [in] camera memory page receiving the result
+                                        const char * in_name        ); ///< [in] calibration name for the traces
+        double getCalibrationProperty  (const int32  in_id          , ///< [in] property to read
+                                        const char * in_name        ); ///< [in] property name for the traces
+        void   setCalibrationProperty  (const int32  in_id          , ///< [in] property to write
+                                        const double in_value       , ///< [in] new value
+                                        const char * in_name        ); ///< [in] property name for the traces
+        enum Calibration_Status getCalibrationStatus(const int32  in_id  , ///< [in] DCAM_IDPROP_SUBTRACT_DATASTATUS or DCAM_IDPROP_SHADINGCALIB_DATASTATUS
+                                                     const char * in_name); ///< [in] property name for the traces
+
+        bool   setHardwareRegions      (const std::vector<Roi> & in_regions); ///< [in] sensor regions read by the camera (empty: whole sensor)
+
+        bool   isViewSplitActive       (void) const;
+        void   updateMaxImageSize      (void);
+
         
 
 	//-----------------------------------------------------------------------------
@@ -322,7 +579,7 @@ namespace lima
 		//-----------------------------------------------------------------------------
         // CameraThread class
 		//-----------------------------------------------------------------------------
-        class CameraThread: public CmdThread
+        class CameraThread: public CmdThread, public FrameCopyPool::Callback
 		{
 			DEB_CLASS_NAMESPC(DebModCamera, "CameraThread", "Hamamatsu");
 		public:
@@ -353,28 +610,242 @@ namespace lima
             void abortCapture(void);
 			volatile bool m_force_stop;
 
+            void prepareCapture        (void);
+            void releasePreparedBuffers(void);
+            void getRecordingStatus    (RecordingStatus & out_status); ///< [out] recorder state of the current (or latest) acquisition
+            void getRawWriterStatus    (RawWriter::Status & out_status); ///< [out] raw stream state of the current (or latest) acquisition
+            void fireSoftwareTrigger   (void);
+
+            // hardware stamps of a frame
+            struct FrameStamps
+            {
+                int    frame_nb    ; // lima frame number (-1: unused)
+                int    framestamp  ; // DCAM framestamp (first image of an accumulated frame)
+                double timestamp   ; // DCAM timestamp in host clock (s)
+                int    nb_images   ; // hardware images summed in the frame (1 without accumulation)
+                long   nb_saturated; // saturated pixels found in these images
+                int    view        ; // W-View of the frame in split mode (0: first view, 1: second view)
+            };
+
+            // acquisition state, can be read during the capture
+            bool   isBuffersAllocated(void) const;
+            bool   isZeroCopy        (void) const;
+            int    getBundleNumber   (void) const;
+            int    getRingSize       (void) const;
+            int    getRingHighWater  (void) const;
+            double getAccExposure    (void) const;
+            bool   getExposureEvents (void) const;
+            double getLockedSize     (void) const;
+            int    getBuffersNode    (void) const;
+            bool   getClockOffset    (double & out_offset); ///< [out] host clock minus DCAM clock (s)
+            bool   getFrameStamps    (const int     in_frame_nb,  ///< [in]  lima frame number
+                                      FrameStamps & out_stamps ); ///< [out] hardware stamps of the frame
+            void   getFrameGaps      (std::vector<FrameGap> & out_gaps); ///< [out] lost hardware frames of the current (or latest) acquisition
+            void   getTriggerLatency (TriggerLatency & out_latency);     ///< [out] software trigger to frame latencies
+            void   getExposureEnds   (double & out_timestamp   ,  ///< [out] host time of the latest exposure end (s, 0 if none)
+                                      int &    out_nb_exposures); ///< [out] number of exposure ends since the acquisition start
+
+            // acquisition thread settings
+            void   setThreadSettingsChanged(void);
+            void   getThreadSettings       (std::string & out_settings); ///< [out] effective priority and cpus of the thread
+
+            // latency records
+            void   setLatencyRecordEnabled(const bool in_enabled);   ///< [in] true to record the frames of the next acquisitions
+            bool   getLatencyRecordEnabled(void) const;
+            void   setLatencyRecordSize   (const int in_nb_records); ///< [in] number of frames kept
+            int    getLatencyRecordSize   (void) const;
+            void   getLatencyStatistics   (const LatencyRecorder::Stage in_from, ///< [in]  first stage
+                                           const LatencyRecorder::Stage in_to  , ///< [in]  last stage
+                                           int &    out_nb ,                     ///< [out] number of frames used
+                                           double & out_p50,                     ///< [out] median latency (s)
+                                           double & out_p99,                     ///< [out] 99th percentile latency (s)
+                                           double & out_max);                    ///< [out] maximum latency (s)
+            void   getQueueDepthStatistics(int & out_p50,  ///< [out] median queue depth
+                                           int & out_p99,  ///< [out] 99th percentile
+                                           int & out_max); ///< [out] maximum
+            void   dumpLatencyRecords     (const std::string & in_file_name); ///< [in] path of the CSV file to write
+
+            // rolling metrics
+            void   setMetricsWindow(const double in_window); ///< [in] time covered by the metrics (s)
+            double getMetricsWindow(void) const;
+            void   getMetrics      (RollingMetrics::Values & out_metrics); ///< [out] metrics of the latest window
+
+            // copy threads
+            void   setCopyThreads       (const int in_nb_threads);      ///< [in] number of copy threads (0: no thread)
+            int    getCopyThreads       (void) const;
+            void   setCopySplitThreshold(const size_t in_threshold);    ///< [in] frame size from which a frame is copied by several threads (0: never)
+            size_t getCopySplitThreshold(void) const;
+
+            // raw writer and snapshot
+            void   getRawWriterDefaults(long long & out_file_size,  ///< [out] default size of the raw files (bytes)
+                                        int &       out_nb_slots ,  ///< [out] default number of frame slots of the writer
+                                        bool &      out_direct_io) const; ///< [out] default use of the direct I/O
+            bool   readSnapshot        (FrameSnapshot::Info & out_info,  ///< [out] stamps of the latest frame
+                                        std::vector<char>   & out_data); ///< [out] pixels of the latest frame
+
+            virtual void frameCopied (HwFrameInfoType & frame_info); ///< [in] informations of the copied frame
+            virtual void frameCopyEnd(const int frame_nb);           ///< [in] number of a frame fully copied
+
 		protected:
 			virtual void init   ();
 			virtual void execCmd(int cmd);
             
 		private:
 			void execStartAcq();
+            void execPrepareCapture(void);
 
             bool copyFrames(const int index_frame_begin,	///< [in] index of the frame where to begin copy
 							const int nb_frames_count  ,	///< [in] number of frames to copy
+                            const int first_dcam_frame ,    ///< [in] DCAM number (count - 1) of the first frame to copy
 							StdBufferCbMgr& buffer_mgr );	///< [in] buffer manager object
 
+            void recordExposureEnd  (void);
+            void updateCaptureStatus(const int32 frame_count); ///< [in] number of DCAM frames transferred since the capture start
+            void recordTriggerLatency(const int hw_frame); ///< [in] hardware number of the DCAM frame received
+
+            bool manageFrameGap(const int        hw_frame  , ///< [in] hardware number of the DCAM frame received
+                                StdBufferCbMgr & buffer_mgr); ///< [in] buffer manager object
+            void manageCopyOverrun(const int last_ring_frame); ///< [in] last DCAM frame whose slot can be reused by DCAM
+
             void checkStatusBeforeCapturing() const;
 
-            void createWaitHandle (HDCAMWAIT & wait_handle) const;
+            void createWaitHandle (HDCAMWAIT & wait_handle);
             void releaseWaitHandle(HDCAMWAIT & wait_handle) const;
 
             void getTransfertInfo(int32 & frame_index,
                                   int32 & frame_count);
 
+            bool canAttachBuffers(StdBufferCbMgr & buffer_mgr) const; ///< [in] buffer manager object
+            void allocBuffers    (StdBufferCbMgr & buffer_mgr);       ///< [in] buffer manager object
+            bool releaseBuffers  (void);
+            int  computeRingDepth(void);
+            long long getNbHardwareImages(void) const;
+            bool buffersMatch    (StdBufferCbMgr & buffer_mgr) const; ///< [in] buffer manager object
+
+            void setupFrameBundle(void);
+
+            double correlateTimestamp(const DCAM_TIMESTAMP & hw_timestamp); ///< [in] DCAM timestamp of a frame
+            void   storeFrameStamps  (const int    frame_nb         ,  ///< [in] lima frame number
+                                      const int    framestamp       ,  ///< [in] DCAM framestamp
+                                      const double timestamp        ,  ///< [in] DCAM timestamp in host clock (s)
+                                      const int    nb_images    = 1 ,  ///< [in] hardware images summed in the frame
+                                      const long   nb_saturated = 0 ,  ///< [in] saturated pixels found in these images
+                                      const int    view         = 0 ); ///< [in] W-View of the frame in split mode
+
+            bool accumulateImage (const long long hw_image    ,  ///< [in] hardware number of the image
+                                  const char    * src         ,  ///< [in] top of the 16 bits image
+                                  const long      src_rowbytes,  ///< [in] bytes between two source lines
+                                  const int       framestamp  ,  ///< [in] DCAM framestamp
+                                  const double    timestamp   ,  ///< [in] DCAM timestamp in host clock (s)
+                                  StdBufferCbMgr & buffer_mgr ); ///< [in] buffer manager object
+            bool deliverAccumulation(void);
+
+            void buildRegionJobs(const FrameCopyPool::Job & in_job); ///< [in] copy of the bounding box of the regions to the lima frame
+
+            bool deliverFrame(HwFrameInfoType & frame_info); ///< [in] informations of the frame to give to lima
+
+            void applyThreadSettings(void);
+            void prefaultBuffers    (StdBufferCbMgr & buffer_mgr); ///< [in] buffer manager object
+            void unlockBuffers      (void);
+
+            void openRecorder         (void);
+            void openStreams          (void);
+            void closeRecorder        (void);
+            void updateRecorderStatus (void);
+            bool manageRecorderEvents (const int32 events); ///< [in] DCAMWAIT_RECEVENT_* events received
+
 			Camera*   m_cam        ;
             HDCAMWAIT m_wait_handle;
 
+            int           m_ring_size      ; // number of frames in the DCAM ring buffer of the current acquisition
+            int           m_ring_high_water; // maximum number of DCAM frames waiting to be copied during the current acquisition
+            bool          m_zero_copy      ; // true if the DCAM ring is made of the lima buffers (no frame copy)
+            vector<void*> m_attached_frames; // lima frame pointers attached to the DCAM ring
+            int           m_bundle_number  ; // number of images in each DCAM frame (1 if frame bundle is disabled)
+            long          m_bundle_rowbytes; // row bytes of each image in a bundle
+            long          m_bundle_step    ; // bytes between the top of two consecutive images in a bundle
+            FrameCopyPool m_copy_pool      ; // threads copying the frames from the DCAM ring to the lima buffers
+            int           m_frame_number   ; // number of the next frame to copy (frames are given to lima in m_cam->m_image_number)
+            volatile bool m_delivery_ok    ; // false if lima refused a frame
+            bool          m_buffers_allocated; // true if the DCAM ring is allocated (or attached)
+            double        m_alloc_frame_bytes; // DCAM frame bytes when the ring was allocated
+            double        m_alloc_row_bytes  ; // DCAM row bytes when the ring was allocated
+            bool          m_alloc_zero_copy  ; // zero-copy request when the ring was allocated
+            bool          m_prepared         ; // ring and wait handle are ready for the next capture
+            Mutex         m_prepare_mutex    ; // protects the preparation (m_prepared, DCAM ring, wait handle, streams)
+            Timestamp     m_start_timestamp  ; // host time of the acquisition start (lima frame timestamps are relative to it)
+            double        m_clock_offset     ; // host clock minus DCAM clock, going to the minimum seen during the acquisition (s)
+            bool          m_clock_offset_valid; // m_clock_offset was measured
+            double        m_last_timestamp   ; // latest DCAM timestamp converted to the host clock (s)
+            double        m_frame_period     ; // predicted frame period of the acquisition (s), used to stamp the images of a bundle
+            vector<FrameStamps> m_frame_stamps; // hardware stamps of the latest frames (indexed by frame number modulo size)
+            Mutex         m_frame_stamps_mutex; // protects m_frame_stamps
+            int           m_next_hw_frame     ; // hardware number of the next expected DCAM frame
+            int           m_framestamp_base   ; // framestamp of the hardware DCAM frame 0
+            bool          m_framestamp_base_valid; // m_framestamp_base was measured
+            vector<Camera::FrameGap> m_frame_gaps; // lost hardware frames of the acquisition
+            Mutex         m_frame_gaps_mutex  ; // protects m_frame_gaps
+            int32         m_wait_events       ; // capture events supported by the wait handle
+            bool          m_exposure_events   ; // the status is driven by the DCAM exposure end events
+            int           m_nb_exposure_ends  ; // number of exposure end events of the acquisition
+            Timestamp     m_last_exposure_end ; // host time of the latest exposure end event
+            Mutex         m_exposure_end_mutex; // protects m_nb_exposure_ends and m_last_exposure_end
+            LatencyRecorder m_latency         ; // per-frame timing records (only filled when enabled)
+            double        m_wait_time         ; // time of the latest dcamwait_start return (LatencyRecorder::now())
+            double        m_info_time         ; // latency record: time of the latest transfer info
+            int           m_queue_depth       ; // latency record: DCAM frames found by the latest transfer info
+            RollingMetrics m_metrics          ; // frame rate, throughput, ring occupancy... over a sliding window
+            volatile bool m_thread_settings_changed; // priority or cpus to apply at the next acquisition start
+            std::string   m_thread_settings   ; // effective priority and cpus of the acquisition thread
+            Mutex         m_thread_settings_mutex; // protects m_thread_settings
+            void        * m_prefaulted_buffer ; // first lima buffer when the buffers were prefaulted (NULL: not done)
+            int           m_prefaulted_nb     ; // number of lima buffers prefaulted
+            int           m_prefaulted_size   ; // size of the lima buffers prefaulted
+            int           m_prefaulted_node   ; // NUMA node asked for the prefaulted buffers
+            int           m_buffers_node      ; // NUMA node actually holding most of the prefaulted buffers (-1: unknown)
+            bool          m_prefaulted_lock   ; // the prefaulted buffers were locked
+            bool          m_prefaulted_huge   ; // huge pages were asked for the prefaulted buffers
+            double        m_locked_size       ; // memory of the lima buffers locked by the latest prefault (MB)
+            std::vector<std::pair<char *, size_t> > m_locked_ranges; // lima buffers locked by the latest prefault
+            size_t        m_locked_reserved   ; // memory reserved for the locked buffers (Windows working set)
+            FrameCopy::Conversion m_conversion; // transformation of the DCAM pixels by the copy
+            int           m_bit_shift         ; // lowest bit of the 8 bits window of the copy (Conversion_Window8)
+            HDCAMREC      m_rec_handle        ; // DCAM recorder of the current acquisition (NULL: no recording)
+            Mutex         m_rec_mutex         ; // protects the recorder handle and status
+            RecordingStatus m_rec_status      ; // recorder state of the current (or latest) acquisition
+            double        m_rec_start_time    ; // start of the recording (LatencyRecorder clock)
+            double        m_rec_frame_bytes   ; // size of a recorded DCAM frame
+            int           m_rec_index         ; // number added to the recorder file name of each acquisition
+            int           m_decimation        ; // one image out of m_decimation given to lima (1: all, 0: none)
+            bool          m_hw_images_done    ; // all the hardware images were received (decimated delivery)
+            long long     m_nb_hw_images      ; // hardware images of the acquisition (0: continuous or unknown)
+            double        m_max_delivery_rate ; // maximum number of images given to lima per second (0: no limit)
+            double        m_next_delivery_time; // earliest time of the next image given to lima (LatencyRecorder::now())
+            bool          m_decimated         ; // lima does not receive all the hardware images
+            RawWriter     m_raw_writer        ; // raw frames streaming to disk (open during the acquisitions when enabled)
+            int           m_raw_index         ; // number added to the raw stream name of each acquisition
+            FrameSnapshot m_snapshot          ; // latest frame for the viewers, out of the lima buffers
+            bool          m_snapshot_active   ; // the snapshot is updated during the current acquisition
+            bool          m_accumulating      ; // 16 bits images summed in 32 bits lima frames (Bpp32, Bpp32F)
+            unsigned short m_saturation_level ; // pixel value counted as saturated in the accumulation
+            int           m_acc_nb_frames     ; // hardware images summed in each lima frame
+            bool          m_acc_average       ; // the sums are divided by the number of images (Bpp32F)
+            long long     m_acc_group         ; // accumulation group of the frame being summed (hardware image / m_acc_nb_frames)
+            int           m_acc_count         ; // images summed in the frame being summed (0: none)
+            long          m_acc_saturated     ; // saturated pixels found in the frame being summed
+            char        * m_acc_dst           ; // lima buffer of the frame being summed
+            int           m_acc_framestamp    ; // DCAM framestamp of the first image of the frame being summed
+            double        m_acc_timestamp     ; // DCAM timestamp of the first image of the frame being summed
+            double        m_acc_exposure      ; // exposure time of a hardware image of the acquisition (s)
+            Mutex         m_trigger_mutex     ; // protects the software trigger times and latencies
+            std::deque<double> m_trigger_times; // software triggers waiting for their frame (LatencyRecorder::now())
+            int           m_trigger_base      ; // hardware frame number of the first waiting trigger
+            TriggerLatency m_trigger_latency  ; // software trigger to frame latencies of the current (or latest) acquisition
+            double        m_trigger_latency_sum; // sum of the latencies (mean computation)
+            vector<FrameCopyPool::Job> m_region_jobs; // copies of the regions of a frame (multi-region readout)
+            int           m_nb_views          ; // lima frames in each hardware image (2 in W-View split mode, 1 otherwise)
+            long          m_view_offset[2]    ; // bytes from the top of the DCAM image to each view (-1: contiguous views)
+
 		};
 		friend class CameraThread;
 
@@ -517,6 +988,8 @@ namespace lima
 
         void setTriggerPolarity(enum Trigger_Polarity in_trigger_polarity) const; ///< [in] type of trigger polarity
 
+        void applyImagePixelType(void);
+
 		// DCAM-SDK Helper end
 		bool  isBinningSupported(const int   bin_value); /// Check if a binning value is supported
         int32 GetBinningMode    (const int   bin_value); ///< [in] binning value to chck for
@@ -530,7 +1003,7 @@ namespace lima
         HwEventCtrlObj              m_event_ctrl_obj ;
 	    int                         m_nb_frames      ;    
 	    Camera::Status              m_status         ;
-	    int                         m_image_number   ;
+	    std::atomic<int>            m_image_number   ; // frames given to lima (incremented by the copy threads)
 	    int                         m_timeout        ;
 	    double                      m_latency_time   ;
 	    Roi                         m_roi            ; /// current roi parameters
@@ -542,7 +1015,6 @@ namespace lima
 
 		// Specific
 		unsigned int long			m_lost_frames_count;
-		double						m_fps              ;
       
 	    //- camera stuff 
 	    string                      m_detector_model;
@@ -558,7 +1030,12 @@ namespace lima
 	    DWORD				        m_camera_capabilities;
 	    string                      m_camera_error_str   ;
 	    int                         m_camera_error       ;
-        int                         m_frame_buffer_size  ; // number of images in the DCAM internal buffer 
+        int                         m_frame_buffer_size  ; // number of images in the DCAM internal buffer when its automatic size is disabled
+        bool                        m_ring_auto_size     ; // compute the DCAM ring depth at each acquisition
+        double                      m_ring_memory_budget ; // maximum memory of the DCAM ring (MB)
+        double                      m_ring_latency       ; // acquisition thread stall the DCAM ring must absorb (s)
+        bool                        m_zero_copy_enabled  ; // zero-copy acquisition requested (lima buffers attached as DCAM ring)
+        int                         m_frame_bundle_number; // requested frames per bundle (1: disabled, 0: automatic)
     	   
 	    bool                        m_fasttrigger        ; // ?
 	    int                         m_temperature_sp     ;   
@@ -571,6 +1048,11 @@ namespace lima
 		CameraThread 				m_thread             ;
 		Mutex						m_mutex_force_stop   ;
 
+        Timestamp                   m_start_acq_request  ; // time of the latest startAcq call
+        double                      m_prepare_acq_time   ; // duration of the latest prepareAcq (s)
+        double                      m_start_acq_time     ; // duration of the latest startAcq until the capture start (s)
+        double                      m_stop_acq_time      ; // duration of the latest stopAcq (s)
+
 	    trigOptionsMap              m_map_trig_modes     ;
 
         FeatureInfos                m_feature_pos_x      ; // property data to check the ROI
@@ -585,6 +1067,44 @@ namespace lima
 	    double                    * m_view_exp_time      ; // array of exposure value by view
 
         bool                        m_hdr_enabled        ; // high dynamic range activation latest value
+        bool                        m_view_split         ; // each of the two W-Views is given as its own lima frame
+        std::vector<Roi>            m_view_rois          ; // subarray of each of the two W-Views (empty: whole views)
+
+        bool                        m_hw_timestamp_supported ; // DCAMDEV_CAPFLAG_TIMESTAMP
+        bool                        m_hw_framestamp_supported; // DCAMDEV_CAPFLAG_FRAMESTAMP
+        bool                        m_hw_timestamp_enabled   ; // lima frames are timestamped with the DCAM timestamps
+        Overrun_Policy              m_overrun_policy         ; // behaviour when hardware frames are lost
+        Exposure_Events_Mode        m_exposure_events_mode   ; // use of the DCAM exposure end events to drive the status
+        SystemTuning::Priority      m_acq_thread_priority    ; // scheduling priority of the acquisition thread
+        std::vector<int>            m_acq_thread_cpus        ; // cpus of the acquisition thread (empty: all, or the NUMA node cpus)
+        int                         m_numa_node              ; // NUMA node of the frame grabber (-1: none)
+        bool                        m_buffer_prefault        ; // lima buffers touched in prepareAcq
+        bool                        m_buffer_lock            ; // lima buffers locked in physical memory in prepareAcq
+        bool                        m_buffer_huge_pages      ; // huge pages asked for the lima buffers in prepareAcq
+        bool                        m_packed_transfer        ; // pixels transferred as DCAM_PIXELTYPE_MONO12P
+        bool                        m_mono8_supported        ; // DCAM_PIXELTYPE_MONO8 offered by the camera
+        int                         m_bit_window             ; // lowest bit of the 8 bits window asked in Bpp8 (-1: camera choice)
+        int                         m_soft_bit_shift         ; // lowest bit of the 8 bits window applied by the copy (-1: none)
+        bool                        m_recording_enabled      ; // acquisitions recorded by the DCAM recorder
+        std::string                 m_recording_path         ; // recorder files path, without extension
+        int                         m_recording_max_frames   ; // recorder file size for the continuous acquisitions
+        int                         m_recording_decimation   ; // one image out of m_recording_decimation given to lima while recording (0: none)
+        int                         m_live_decimation        ; // one hardware image out of m_live_decimation given to lima (no recording)
+        double                      m_live_max_rate          ; // maximum number of images given to lima per second (0: no limit)
+        bool                        m_raw_writer_enabled     ; // raw frames of the acquisitions streamed to disk
+        std::string                 m_raw_writer_path        ; // raw stream files path, without extension
+        long long                   m_raw_writer_file_size   ; // size of a raw data file
+        int                         m_raw_writer_slots       ; // number of frames the raw writer can hold
+        bool                        m_raw_writer_direct_io   ; // system cache bypassed for the raw data files
+        bool                        m_snapshot_enabled       ; // latest frame of the acquisitions kept out of the lima buffers
+        double                      m_snapshot_max_rate      ; // maximum number of snapshot updates per second (0: every frame)
+        int                         m_accumulation_nb_frames ; // hardware images summed in each lima frame (Bpp32, Bpp32F)
+        bool                        m_accumulation_average   ; // the sums are divided by the number of images (Bpp32F)
+        std::vector<Roi>            m_regions                ; // sensor regions given to lima (empty: the roi is used)
+        std::vector<Roi>            m_regions_layout         ; // position of each region in the lima frame
+        Roi                         m_regions_bbox           ; // subarray read by the camera (bounding box of the regions)
+        Size                        m_regions_frame_size     ; // size of the lima frame holding the packed regions
+        bool                        m_hw_regions             ; // the camera only reads the regions (DCAM region data)
 
 		//-----------------------------------------------------------------------------
         // Constants
@@ -592,6 +1112,17 @@ namespace lima
         static const double g_orca_pixel_size              ;
         static const int    g_dcam_str_msg_size            ;
         static const int    g_get_sub_array_do_not_use_view;
+        static const double g_frame_bundle_auto_wakeup_rate;
+        static const int    g_ring_min_depth               ;
+        static const int    g_frame_stamps_size            ;
+        static const int    g_frame_gaps_max               ;
+        static const int    g_recording_default_max_frames ;
+        static const double g_snapshot_default_max_rate    ;
+        static const int    g_accumulation_max_frames      ;
+        static const int    g_calibration_nb_buffers       ;
+        static const double g_calibration_timeout          ;
+        static const int    g_regions_max                  ;
+        static const int32  g_recorder_events              ;
 
         static const string g_trace_line_separator       ;
         static const string g_trace_little_line_separator;
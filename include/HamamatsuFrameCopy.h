@@ -0,0 +1,138 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSUFRAMECOPY_H
+#define HAMAMATSUFRAMECOPY_H
+
+#include <stddef.h>
+#include <string>
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class FrameCopy
+ * \brief image copy kernels used to transfer the frames from the
+ *        DCAM ring buffer to the lima buffers.
+ *        The source lines can be padded (row stride). The frames
+ *        bigger than the non-temporal threshold (last level cache 
+ *        size by default) are copied with streaming stores to keep
+ *        the cache for the lima processing. The 12 bits packed frames
+ *        are unpacked to 16 bits and the 16 bits frames can be reduced
+ *        to an 8 bits window or summed in 32 bits. The kernel (AVX-512, AVX2, SSSE3 
+ *        or scalar) is chosen at run time from the cpu features.
+ *******************************************************************/
+    class FrameCopy
+    {
+    public:
+        enum Kernel
+        {
+            Kernel_Scalar,
+            Kernel_SSSE3 ,
+            Kernel_AVX2  ,
+            Kernel_AVX512,
+        };
+
+        // transformation of the DCAM pixels into the lima pixels
+        enum Conversion
+        {
+            Conversion_None   , // same pixel format
+            Conversion_Mono12 , // DCAM_PIXELTYPE_MONO12 unpacked to 16 bits
+            Conversion_Mono12P, // DCAM_PIXELTYPE_MONO12P unpacked to 16 bits
+            Conversion_Window8, // DCAM_PIXELTYPE_MONO16 reduced to 8 bits (bit window)
+        };
+
+        static void copy(char       * dst         ,  ///< [in] top of the destination image
+                         long         dst_rowbytes,  ///< [in] bytes between two destination lines
+                         const char * src         ,  ///< [in] top of the source image
+                         long         src_rowbytes,  ///< [in] bytes between two source lines
+                         long         line_size   ,  ///< [in] useful bytes of a line
+                         int          height      ,  ///< [in] number of lines
+                         size_t       frame_size = 0); ///< [in] size of the whole frame if only a part of it is copied (0: same as the copy)
+
+        static void unpack12(char       * dst         ,  ///< [in] top of the 16 bits destination image
+                             long         dst_rowbytes,  ///< [in] bytes between two destination lines
+                             const char * src         ,  ///< [in] top of the 12 bits packed source image
+                             long         src_rowbytes,  ///< [in] bytes between two source lines
+                             int          width       ,  ///< [in] number of pixels of a line
+                             int          height      ,  ///< [in] number of lines
+                             Conversion   conversion  ); ///< [in] packing of the source (Conversion_Mono12 or Conversion_Mono12P)
+
+        static long getPackedLineSize(int width); ///< [in] number of pixels of a line
+
+        static void window8(char       * dst         ,  ///< [in] top of the 8 bits destination image
+                            long         dst_rowbytes,  ///< [in] bytes between two destination lines
+                            const char * src         ,  ///< [in] top of the 16 bits source image
+                            long         src_rowbytes,  ///< [in] bytes between two source lines
+                            int          width       ,  ///< [in] number of pixels of a line
+                            int          height      ,  ///< [in] number of lines
+                            int          shift       ); ///< [in] lowest bit of the window (0 to 8), upper values saturate to 255
+
+        static long accumulate16(char         * dst         ,  ///< [in] top of the 32 bits sums
+                                 long           dst_rowbytes,  ///< [in] bytes between two sum lines
+                                 const char   * src         ,  ///< [in] top of the 16 bits source image
+                                 long           src_rowbytes,  ///< [in] bytes between two source lines
+                                 int            width       ,  ///< [in] number of pixels of a line
+                                 int            height      ,  ///< [in] number of lines
+                                 bool           first       ,  ///< [in] true to start the sums with this image
+                                 unsigned short saturation  ); ///< [in] pixel value counted as saturated
+
+        static void average32(char * data     ,  ///< [in] 32 bits sums, replaced by their float means
+                              size_t nb_pixels,  ///< [in] number of pixels
+                              int    nb_images); ///< [in] number of images summed
+
+        static Kernel      getKernel    (void);
+        static std::string getKernelName(void);
+        static void        setKernel    (Kernel in_kernel); ///< [in] kernel to use (limited to the cpu features)
+
+        static size_t getNonTemporalThreshold(void);
+        static void   setNonTemporalThreshold(size_t in_threshold); ///< [in] frame size in bytes from which streaming stores are used
+
+        static void benchmark(long     line_size     ,  ///< [in]  useful bytes of a line
+                              long     src_rowbytes  ,  ///< [in]  bytes between two source lines
+                              int      height        ,  ///< [in]  number of lines
+                              int      nb_iterations ,  ///< [in]  number of copies to time
+                              double & reference_rate,  ///< [out] line by line memcpy rate (MB/s)
+                              double & kernel_rate   ); ///< [out] current kernel rate (MB/s)
+
+        static bool benchmarkUnpack(int        width        ,  ///< [in]  number of pixels of a line
+                                    int        height       ,  ///< [in]  number of lines
+                                    int        nb_iterations,  ///< [in]  number of unpacks to time
+                                    Conversion conversion   ,  ///< [in]  packing of the source
+                                    double &   scalar_rate  ,  ///< [out] scalar unpack rate (MB/s of 16 bits pixels)
+                                    double &   kernel_rate  ); ///< [out] current kernel rate (MB/s of 16 bits pixels)
+
+    private:
+        static void   init(void);
+        static size_t getLastLevelCacheSize(void);
+
+        static Kernel s_kernel          ; // kernel used for the big frames
+        static Kernel s_best_kernel     ; // best kernel supported by the cpu
+        static size_t s_nt_threshold    ; // frame size from which the streaming stores are used
+        static bool   s_initialized     ;
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSUFRAMECOPY_H
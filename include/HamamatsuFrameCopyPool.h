@@ -0,0 +1,158 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSUFRAMECOPYPOOL_H
+#define HAMAMATSUFRAMECOPYPOOL_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "lima/Debug.h"
+#include "lima/HwBufferMgr.h"
+#include "lima/ThreadUtils.h"
+
+#include "HamamatsuFrameCopy.h"
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class FrameCopyPool
+ * \brief pool of threads copying the frames from the DCAM ring buffer
+ *        to the lima buffers. The copied frames are given back in the
+ *        frame number order (reorder stage). The very large frames are
+ *        split in bands of lines copied by several threads.
+ *******************************************************************/
+    class FrameCopyPool
+    {
+        DEB_CLASS_NAMESPC(DebModCamera, "FrameCopyPool", "Hamamatsu");
+
+    public:
+        //-----------------------------------------------------------------------------
+        // Interface called (in frame number order) when the frames are copied
+        //-----------------------------------------------------------------------------
+        class Callback
+        {
+        public:
+            virtual ~Callback() {}
+            virtual void frameCopied(HwFrameInfoType & frame_info) = 0; ///< [in] informations of the copied frame
+            virtual void frameCopyEnd(const int /*frame_nb*/) {}         ///< [in] number of a frame fully copied (any order, pool lock held)
+        };
+
+        //-----------------------------------------------------------------------------
+        // Interface of the copies out of the lima frames (raw writer...): called by a 
+        // copy thread (any order) when a copy to one of its slots is done. These 
+        // copies do not go through the reorder stage.
+        //-----------------------------------------------------------------------------
+        class Sink
+        {
+        public:
+            virtual ~Sink() {}
+            virtual void slotCopied(const int  slot_index,  ///< [in] slot filled by the copy
+                                    const bool copied    ) = 0; ///< [in] false if the copy was dropped (DCAM ring overrun)
+        };
+
+        //-----------------------------------------------------------------------------
+        // Copy of one image
+        //-----------------------------------------------------------------------------
+        struct Job
+        {
+            HwFrameInfoType frame_info  ; ///< frame to give back once copied (acq_frame_nb gives the order)
+            const char    * src         ; ///< top of the source image (NULL: the destination is filled with zeros)
+            char          * dst         ; ///< top of the destination image
+            long            src_rowbytes; ///< bytes between two source lines
+            long            line_size   ; ///< useful bytes of a line
+            long            dst_rowbytes; ///< bytes between two destination lines (0: contiguous lines)
+            int             height      ; ///< number of lines
+            size_t          frame_size  ; ///< size of the whole frame (a job can be a part of a frame, 0: same as the job)
+            FrameCopy::Conversion conversion; ///< transformation of the source pixels (the line size is the destination one)
+            int             bit_shift   ; ///< lowest bit of the 8 bits window (Conversion_Window8)
+            int             ring_frame  ; ///< DCAM frame count of the ring slot read by the job (-1: not a ring slot)
+            long            src_half_offset; ///< bytes from src to the second half of the lines (two W-View views, 0: contiguous lines)
+            Sink          * sink        ; ///< receiver of a copy out of the lima frames (NULL: lima frame)
+            int             sink_slot   ; ///< slot of the sink filled by the copy
+
+            Job() : src(NULL), dst(NULL), src_rowbytes(0), line_size(0), dst_rowbytes(0), height(0), frame_size(0),
+                    conversion(FrameCopy::Conversion_None), bit_shift(0), ring_frame(-1), src_half_offset(0), sink(NULL), sink_slot(-1) {}
+        };
+
+        FrameCopyPool();
+        ~FrameCopyPool();
+
+        void setNbThreads(const int nb_threads); ///< [in] number of copy threads (0: no thread)
+        int  getNbThreads(void) const;
+
+        void start(Callback * callback      ,  ///< [in] object which receives the copied frames
+                   const int  first_frame_nb); ///< [in] number of the first frame of the acquisition
+        void push(const Job & job);            ///< [in] copy to do
+        void push(const std::vector<Job> & parts); ///< [in] copies of the parts of one frame
+        void waitIdle(void);
+        int  getNbPending(void);
+        int  getOldestRingFrame(void);
+        int  dropRingFrames(const int last_ring_frame); ///< [in] last DCAM frame which can be reused by DCAM
+
+        void   setSplitThreshold(const size_t split_threshold); ///< [in] frame size from which a frame is copied by several threads (0: never)
+        size_t getSplitThreshold(void) const;
+
+        static void copy(const Job & job);     ///< [in] copy to do
+
+    private:
+        class WorkerThread : public Thread
+        {
+            DEB_CLASS_NAMESPC(DebModCamera, "FrameCopyPool::WorkerThread", "Hamamatsu");
+        public:
+            WorkerThread(FrameCopyPool & pool);
+        protected:
+            virtual void threadFunction();
+        private:
+            FrameCopyPool & m_pool;
+        };
+        friend class WorkerThread;
+
+        void stopThreads   (void);
+        void workerLoop    (void);
+        void releaseRingJob(const int ring_frame); ///< [in] DCAM frame read by the job
+
+        Cond                           m_cond         ;
+        std::deque<Job>                m_jobs         ; // copies to do
+        std::map<int, HwFrameInfoType> m_copied       ; // copied frames waiting for a previous frame
+        std::map<int, int>             m_parts_left   ; // number of parts still to copy for each frame being copied
+        std::map<int, int>             m_ring_jobs    ; // number of jobs still reading each DCAM ring frame
+        std::multimap<int, int>        m_running_ring_jobs; // DCAM ring frame -> lima frame (-1: sink) of the copies running
+        int                            m_dropped_ring_frame; // newest DCAM frame dropped (the copies of it still running are torn)
+        std::vector<WorkerThread *>    m_threads      ;
+        Callback                     * m_callback     ;
+        int                            m_next_frame_nb; // next frame to give back
+        int                            m_nb_pending   ; // frames pushed but not given back
+        int                            m_nb_sink_jobs ; // copies to a sink pushed but not done
+        bool                           m_delivering   ; // a thread is giving back the copied frames
+        bool                           m_quit         ;
+        size_t                         m_split_threshold; // frame size from which a frame is split between the threads
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSUFRAMECOPYPOOL_H
@@ -0,0 +1,122 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSUFRAMESNAPSHOT_H
+#define HAMAMATSUFRAMESNAPSHOT_H
+
+#include <atomic>
+#include <vector>
+
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+
+#include "HamamatsuFrameCopyPool.h"
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class FrameSnapshot
+ * \brief latest frame of the acquisition, out of the lima buffers.
+ *        Triple buffer: the acquisition thread gives its back slot to
+ *        a copy thread which fills it and swaps it with the middle one
+ *        (one atomic exchange, frames skipped meanwhile), a 
+ *        reader takes the middle slot only if it is newer than its
+ *        front slot. The acquisition thread never waits, the readers
+ *        only wait for each other.
+ *******************************************************************/
+    class FrameSnapshot : public FrameCopyPool::Sink
+    {
+        DEB_CLASS_NAMESPC(DebModCamera, "FrameSnapshot", "Hamamatsu");
+
+    public:
+        struct Info
+        {
+            long long seq       ; ///< number of the update since the snapshot configuration (0: no frame yet)
+            long long frame_nb  ; ///< hardware image number since the acquisition start
+            double    timestamp ; ///< hardware timestamp in host clock (s, 0: unknown)
+            int       framestamp; ///< DCAM framestamp
+            int       width     ; ///< pixels of a line
+            int       height    ; ///< lines of the frame
+            int       depth     ; ///< bytes of a pixel
+        };
+
+        FrameSnapshot();
+        ~FrameSnapshot();
+
+        void   setMaxRate(const double in_rate); ///< [in] maximum number of updates per second (0: every frame)
+        double getMaxRate(void) const;
+
+        // acquisition thread
+        void configure(const int in_width ,  ///< [in] pixels of a line
+                       const int in_height,  ///< [in] lines of a frame
+                       const int in_depth ); ///< [in] bytes of a pixel
+        bool isConfigured(void) const { return (m_frame_size != 0); }
+
+        bool update(FrameCopyPool           * io_pool      ,  ///< [in] copy threads doing the copy (NULL: copied by the caller)
+                    const FrameCopyPool::Job & in_job       ,  ///< [in] copy of the frame (its destination is replaced by the back slot)
+                    const long long           in_frame_nb  ,  ///< [in] hardware image number
+                    const int                 in_framestamp,  ///< [in] DCAM framestamp
+                    const double              in_timestamp ,  ///< [in] hardware timestamp in host clock (s)
+                    const double              in_now       ); ///< [in] arrival time of the frame (s)
+
+        // copy threads
+        virtual void slotCopied(const int  slot_index,  ///< [in] back slot filled by the copy
+                                const bool copied    ); ///< [in] false if the copy was dropped
+
+        // readers
+        bool read(Info              & out_info,  ///< [out] stamps of the latest frame
+                  std::vector<char> & out_data); ///< [out] pixels of the latest frame
+
+    private:
+        struct Slot
+        {
+            char * buffer;
+            Info   info  ;
+        };
+
+        void releaseSlots(void);
+        void takeLatest  (void);
+
+        static const int g_nb_slots  = 3   ;
+        static const int g_fresh_bit = 0x4 ; // set in m_middle when the middle slot was not read yet
+
+        Slot             m_slots[g_nb_slots]; // frames of the triple buffer
+        std::atomic<int> m_middle         ; // index of the shared slot (| g_fresh_bit if not read yet)
+        int              m_back           ; // slot filled for the acquisition thread
+        std::atomic<bool> m_copying       ; // a copy thread is filling the back slot
+        int              m_front          ; // slot read by the readers
+        Mutex            m_read_mutex     ; // serializes the readers and the configuration
+        size_t           m_frame_size     ; // bytes of a frame (0: not configured)
+        int              m_width          ; // pixels of a line
+        int              m_height         ; // lines of a frame
+        int              m_depth          ; // bytes of a pixel
+        long long        m_seq            ; // updates since the configuration
+        double           m_max_rate       ; // maximum number of updates per second (0: every frame)
+        double           m_next_time      ; // earliest time of the next update (s)
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSUFRAMESNAPSHOT_H
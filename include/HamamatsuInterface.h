@@ -62,6 +62,11 @@ namespace lima
 		//! get the camera object to access it directly from client
 		Camera& getCamera() { return m_cam;}
 
+	    //- rolling metrics of the acquisition
+	    void    setMetricsWindow(const double window);
+	    double  getMetricsWindow();
+	    void    getRollingMetrics(RollingMetrics::Values& metrics);
+
 	private:
 	    Camera&          m_cam     ;
 	    CapList          m_cap_list;
@@ -0,0 +1,113 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSULATENCYRECORDER_H
+#define HAMAMATSULATENCYRECORDER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "lima/Debug.h"
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class LatencyRecorder
+ * \brief preallocated ring of per-frame timing records filled by the
+ *        acquisition and copy threads. Each stage of a frame is 
+ *        written by one thread only, so no lock is taken in the 
+ *        acquisition loop. Disabled, it only costs a flag test.
+ *******************************************************************/
+    class LatencyRecorder
+    {
+        DEB_CLASS_NAMESPC(DebModCamera, "LatencyRecorder", "Hamamatsu");
+
+    public:
+        // stages of a frame in the acquisition
+        enum Stage
+        {
+            Stage_WaitReturn  , // dcamwait_start returned
+            Stage_TransferInfo, // dcamcap_transferinfo returned
+            Stage_Lock        , // dcambuf_lockframe returned
+            Stage_CopyEnd     , // frame copied in the lima buffer
+            Stage_Delivered   , // newFrameReady returned
+            Stage_Nb          ,
+        };
+
+        struct Record
+        {
+            int    frame_nb       ; ///< lima frame number (-1: unused record)
+            int    queue_depth    ; ///< DCAM frames waiting in the ring when the frame was found
+            double times[Stage_Nb]; ///< time of each stage (s, see now(), 0: not reached)
+        };
+
+        LatencyRecorder();
+
+        void setEnabled (const bool in_enabled); ///< [in] true to record the frames of the next acquisitions
+        bool isEnabled  (void) const { return m_enabled.load(std::memory_order_acquire); }
+        void setNbRecords(const int in_nb_records); ///< [in] number of records (rounded up to a power of two)
+        int  getNbRecords(void) const;
+
+        void start(void);
+
+        // acquisition thread: new frame found in the DCAM ring
+        void begin(const int    frame_nb   ,  ///< [in] lima frame number
+                   const int    queue_depth,  ///< [in] DCAM frames waiting in the ring
+                   const double wait_time  ,  ///< [in] time of Stage_WaitReturn
+                   const double info_time  ,  ///< [in] time of Stage_TransferInfo
+                   const double lock_time  ); ///< [in] time of Stage_Lock
+
+        // acquisition or copy thread: next stage of a frame
+        void mark(const int    frame_nb,  ///< [in] lima frame number
+                  const Stage  stage   ,  ///< [in] stage reached
+                  const double time    ); ///< [in] time of the stage
+
+        void getLatencyStatistics(const Stage in_from ,  ///< [in]  first stage
+                                  const Stage in_to   ,  ///< [in]  last stage
+                                  int &       out_nb  ,  ///< [out] number of frames used
+                                  double &    out_p50 ,  ///< [out] median latency (s)
+                                  double &    out_p99 ,  ///< [out] 99th percentile latency (s)
+                                  double &    out_max ); ///< [out] maximum latency (s)
+
+        void getQueueDepthStatistics(int & out_p50,  ///< [out] median queue depth
+                                     int & out_p99,  ///< [out] 99th percentile queue depth
+                                     int & out_max); ///< [out] maximum queue depth
+
+        void dump(const std::string & in_file_name); ///< [in] path of the CSV file to write
+
+        static double now(void);
+        static std::string getStageName(const Stage in_stage); ///< [in] stage
+
+    private:
+        std::atomic<bool>   m_enabled   ; // records filled during the acquisition
+        std::vector<Record> m_records   ; // ring of records, indexed by frame number & m_mask
+        int                 m_mask      ; // number of records - 1
+        double              m_start_time; // time of the acquisition start
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSULATENCYRECORDER_H
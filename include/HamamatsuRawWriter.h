@@ -0,0 +1,190 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSURAWWRITER_H
+#define HAMAMATSURAWWRITER_H
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+
+#include "HamamatsuFrameCopyPool.h"
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class RawWriter
+ * \brief streaming writer of the raw frames, out of the lima saving
+ *        chain. The acquisition thread gives each frame to a free
+ *        aligned slot (the frame is dropped if none is free, the 
+ *        acquisition is never blocked) and the copy threads fill the
+ *        slot, a writer thread appends the
+ *        slots to large preallocated data files (direct I/O if 
+ *        possible, rollover when a file is full) and fills a fixed
+ *        record index file that readers can map.
+ *
+ *        Files of a stream <base>:
+ *        - <base>.idx        : IndexHeader, then one IndexRecord per frame
+ *        - <base>_<nnnn>.raw : frames, each one at a multiple of 
+ *                              frame_stride (lines are contiguous)
+ *******************************************************************/
+    class RawWriter : public FrameCopyPool::Sink
+    {
+        DEB_CLASS_NAMESPC(DebModCamera, "RawWriter", "Hamamatsu");
+
+    public:
+        // first bytes of the index file (64 bytes)
+        struct IndexHeader
+        {
+            char      magic[8]       ; ///< "HAMRAW1"
+            int       header_size    ; ///< size of this header
+            int       record_size    ; ///< size of an IndexRecord
+            int       width          ; ///< pixels of a line
+            int       height         ; ///< lines of a frame
+            int       depth          ; ///< bytes of a pixel
+            int       frames_per_file; ///< frames in a data file
+            long long frame_size     ; ///< useful bytes of a frame
+            long long frame_stride   ; ///< bytes between two frames in a data file
+            long long file_size      ; ///< size of a data file
+            long long reserved       ;
+        };
+
+        // index entry of a written frame (32 bytes)
+        struct IndexRecord
+        {
+            long long frame_nb  ; ///< hardware image number since the acquisition start
+            double    timestamp ; ///< hardware timestamp in host clock (s, 0: unknown)
+            long long offset    ; ///< offset of the frame in its data file
+            int       file_index; ///< number of the data file
+            int       framestamp; ///< DCAM framestamp
+        };
+
+        struct Status
+        {
+            bool        open          ; ///< a stream is open
+            std::string base_name     ; ///< path of the latest stream (without extension)
+            long long   nb_written    ; ///< frames written
+            long long   nb_dropped    ; ///< frames dropped (no free slot or write error)
+            int         nb_files      ; ///< data files created
+            int         queue_max     ; ///< maximum number of slots waiting to be written
+            double      throughput    ; ///< MB/s written since the stream opening
+            std::string error         ; ///< latest write error (empty if none)
+        };
+
+        RawWriter();
+        ~RawWriter();
+
+        void      setFileSize(const long long in_size); ///< [in] size of a data file (bytes, rounded to the frame stride)
+        long long getFileSize(void) const;
+        void      setNbSlots (const int in_nb_slots); ///< [in] number of frames the writer can hold
+        int       getNbSlots (void) const;
+        void      setDirectIoEnabled(const bool in_enabled); ///< [in] true to bypass the system cache (O_DIRECT, FILE_FLAG_NO_BUFFERING)
+        bool      getDirectIoEnabled(void) const;
+
+        void open (const std::string & in_base_name,  ///< [in] path of the stream files, without extension
+                   const int           in_width    ,  ///< [in] pixels of a line
+                   const int           in_height   ,  ///< [in] lines of a frame
+                   const int           in_depth    ); ///< [in] bytes of a pixel
+        void close(void);
+        bool isOpen(void) const { return m_open; }
+
+        bool push(FrameCopyPool           * io_pool      ,  ///< [in] copy threads doing the copy (NULL: copied by the caller)
+                  const FrameCopyPool::Job & in_job       ,  ///< [in] copy of the frame (its destination is replaced by a slot)
+                  const long long           in_frame_nb  ,  ///< [in] hardware image number
+                  const int                 in_framestamp,  ///< [in] DCAM framestamp
+                  const double              in_timestamp ); ///< [in] hardware timestamp in host clock (s)
+
+        virtual void slotCopied(const int  slot_index,  ///< [in] slot filled by the copy
+                                const bool copied    ); ///< [in] false if the copy was dropped
+
+        void getStatus(Status & out_status); ///< [out] state of the current (or latest) stream
+
+    private:
+        class WriterThread : public Thread
+        {
+            DEB_CLASS_NAMESPC(DebModCamera, "RawWriter::WriterThread", "Hamamatsu");
+        public:
+            WriterThread(RawWriter & writer);
+        protected:
+            virtual void threadFunction();
+        private:
+            RawWriter & m_writer;
+        };
+        friend class WriterThread;
+
+        enum Slot_State
+        {
+            Slot_Copying, // the copy threads are filling the slot
+            Slot_Copied , // the slot can be written
+            Slot_Dropped  // the copy was dropped, the slot is given back
+        };
+
+        struct Slot
+        {
+            char        * buffer;
+            IndexRecord   record;
+            Slot_State    state ;
+        };
+
+        void writerLoop  (void);
+        bool writeSlot   (Slot & slot); ///< [in] frame to write
+        bool openDataFile(const int in_file_index); ///< [in] number of the data file
+        void closeFiles  (void);
+
+        static void * allocAligned(size_t in_size);  ///< [in] bytes to allocate
+        static void   freeAligned (void * in_buffer); ///< [in] memory of allocAligned
+
+        Cond                m_cond           ;
+        std::vector<Slot>   m_slots          ;
+        std::deque<int>     m_free           ; // slots ready to receive a frame
+        std::deque<int>     m_copying        ; // slots given to the copy threads, in frame order
+        std::deque<int>     m_filled         ; // slots waiting to be written, in frame order
+        WriterThread      * m_thread         ;
+        bool                m_open           ;
+        bool                m_quit           ;
+        bool                m_writing        ; // the writer thread is writing a slot
+
+        long long           m_file_size      ; // size of a data file asked
+        int                 m_nb_slots       ;
+        bool                m_direct_io      ;
+        size_t              m_slot_size      ; // bytes of a slot (frame stride)
+
+        IndexHeader         m_header         ;
+        intptr_t            m_data_file      ; // handle or descriptor of the current data file (-1: none)
+        intptr_t            m_index_file     ; // handle or descriptor of the index file (-1: none)
+        int                 m_file_index     ; // number of the current data file
+        long long           m_file_offset    ; // next frame offset in the current data file
+        long long           m_nb_records     ; // records written in the index
+        double              m_open_time      ;
+        Status              m_status         ;
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSURAWWRITER_H
@@ -0,0 +1,113 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSUROLLINGMETRICS_H
+#define HAMAMATSUROLLINGMETRICS_H
+
+#include <atomic>
+#include <vector>
+
+#include "lima/Debug.h"
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class RollingMetrics
+ * \brief acquisition metrics over a sliding time window. 
+ *        The acquisition thread accumulates each wake-up in a 
+ *        preallocated ring of time buckets, the readers sum the 
+ *        buckets of the window. Nothing is locked: each bucket is a
+ *        seqlock, a bucket changed by the writer during a read is 
+ *        detected and skipped.
+ *******************************************************************/
+    class RollingMetrics
+    {
+        DEB_CLASS_NAMESPC(DebModCamera, "RollingMetrics", "Hamamatsu");
+
+    public:
+        struct Values
+        {
+            double window            ; ///< time covered by the values (s)
+            double frame_rate        ; ///< frames given to lima per second
+            double throughput        ; ///< frame data given to lima (MB/s)
+            double ring_occupancy    ; ///< mean number of DCAM frames waiting to be copied at each wake-up
+            int    ring_occupancy_max; ///< maximum number of DCAM frames waiting to be copied
+            double wait_jitter       ; ///< standard deviation of the time between two frame wake-ups (s)
+            double lost_frame_rate   ; ///< frames lost per second
+        };
+
+        RollingMetrics();
+
+        void   setWindow(const double in_window); ///< [in] time covered by the metrics (s)
+        double getWindow(void) const;
+
+        // acquisition thread
+        void start (const double time); ///< [in] time of the acquisition start (s)
+        void stop  (const double time); ///< [in] time of the acquisition end (s)
+        void update(const double time       ,  ///< [in] time of the wake-up (s)
+                    const int    nb_frames  ,  ///< [in] frames given to lima (or to the copy threads)
+                    const double nb_bytes   ,  ///< [in] bytes of these frames
+                    const int    nb_lost    ,  ///< [in] frames lost since the previous wake-up
+                    const int    occupancy  ); ///< [in] DCAM frames waiting to be copied
+
+        void get(const double in_now    ,  ///< [in]  current time (s)
+                 Values &     out_values); ///< [out] metrics of the window ending now (or at the acquisition end)
+
+    private:
+        // accumulation of the wake-ups of a time slice
+        struct BucketData
+        {
+            long long id           ; // time slice of the bucket (time / resolution), -1: unused
+            int       nb_frames    ;
+            double    nb_bytes     ;
+            int       nb_lost      ;
+            int       nb_wakeups   ;
+            double    occupancy_sum;
+            int       occupancy_max;
+            int       nb_intervals ;
+            double    interval_sum ;
+            double    interval_square_sum;
+        };
+
+        struct Bucket
+        {
+            std::atomic<long long> seq ; // odd while the writer changes the data
+            BucketData             data;
+        };
+
+        void beginWrite(Bucket & bucket); ///< [in] bucket changed by the writer
+        void endWrite  (Bucket & bucket); ///< [in] bucket changed by the writer
+
+        std::vector<Bucket>    m_buckets    ; // ring of time slices, indexed by id modulo size
+        double                 m_window     ; // time covered by the metrics (s)
+        std::atomic<bool>      m_running    ; // an acquisition is running
+        std::atomic<double>    m_start_time ; // time of the acquisition start (s)
+        std::atomic<double>    m_stop_time  ; // time of the acquisition end (s)
+        double                 m_last_wakeup; // time of the previous frame wake-up (s, 0: none)
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSUROLLINGMETRICS_H
@@ -0,0 +1,86 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#ifndef HAMAMATSUSYSTEMTUNING_H
+#define HAMAMATSUSYSTEMTUNING_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "lima/Debug.h"
+
+namespace lima
+{
+    namespace Hamamatsu
+    {
+
+/*******************************************************************
+ * \class SystemTuning
+ * \brief operating system settings of the acquisition: scheduling 
+ *        priority and cpu set of the calling thread, cpus of a 
+ *        NUMA node, NUMA placement, first touch, huge pages and 
+ *        locking of memory.
+ *        The cpus are numbered across the processor groups 
+ *        (group * 64 + index) on Windows.
+ *******************************************************************/
+    class SystemTuning
+    {
+        DEB_CLASS_NAMESPC(DebModCamera, "SystemTuning", "Hamamatsu");
+
+    public:
+        enum Priority
+        {
+            Priority_Normal  , // default scheduling
+            Priority_High    , // above the other threads of the process (Windows: highest, Linux: SCHED_RR)
+            Priority_Realtime, // time critical (Windows: time critical, Linux: SCHED_FIFO)
+        };
+
+        static void setCurrentThreadPriority(Priority in_priority);            ///< [in] scheduling priority of the calling thread
+        static void setCurrentThreadCpus    (const std::vector<int> & in_cpus); ///< [in] cpus allowed for the calling thread (empty: all)
+        static std::vector<int> getCurrentThreadCpus(void);
+        static std::string      getCurrentThreadSettings(void);
+
+        static std::vector<int> getNumaNodeCpus(int in_node); ///< [in] NUMA node
+
+        static size_t getPageSize(void);
+        static void   touchPages (char * in_address,  ///< [in] first byte of the memory
+                                  size_t in_size   ); ///< [in] size of the memory
+        static bool   adviseHugePages(char * in_address,  ///< [in] first byte of the memory
+                                      size_t in_size   ); ///< [in] size of the memory
+        static bool   bindMemoryToNode(char * in_address,  ///< [in] first byte of the memory
+                                       size_t in_size   ,  ///< [in] size of the memory
+                                       int    in_node   ); ///< [in] NUMA node
+        static int    getMemoryNode(const char * in_address); ///< [in] byte of a mapped page
+        static bool   reserveLockedMemory(size_t in_size); ///< [in] memory which will be locked
+        static void   releaseLockedMemory(size_t in_size); ///< [in] memory which is no longer locked
+        static bool   lockMemory (char * in_address,  ///< [in] first byte of the memory
+                                  size_t in_size   ); ///< [in] size of the memory
+        static bool   unlockMemory(char * in_address,  ///< [in] first byte of the memory
+                                   size_t in_size   ); ///< [in] size of the memory
+
+        static std::string getCpusText(const std::vector<int> & in_cpus); ///< [in] cpus to describe
+    };
+
+    } // namespace Hamamatsu
+} // namespace lima
+
+#endif // HAMAMATSUSYSTEMTUNING_H
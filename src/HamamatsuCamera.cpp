@@ -37,6 +37,19 @@ using namespace std;
 const double Camera::g_orca_pixel_size              = 6.5e-6;
 const int    Camera::g_dcam_str_msg_size            = 256   ;
 const int    Camera::g_get_sub_array_do_not_use_view= -1    ;
+const double Camera::g_frame_bundle_auto_wakeup_rate= 500.0 ; // maximum acquisition thread wake-ups per second in automatic frame bundle mode
+const int    Camera::g_ring_min_depth               = 3     ; // minimum DCAM ring depth in automatic size mode
+const int    Camera::g_frame_stamps_size            = 4096  ; // number of frames whose hardware stamps are kept
+const int    Camera::g_frame_gaps_max               = 1024  ; // maximum number of frame gaps kept for an acquisition
+const int    Camera::g_recording_default_max_frames = 100000; // recorder file size (DCAM frames) for the continuous acquisitions
+const double Camera::g_snapshot_default_max_rate    = 25.0  ; // snapshot updates per second (viewers)
+const int    Camera::g_accumulation_max_frames      = 32768 ; // 16 bits images summed without 32 bits overflow (and exact float conversion)
+const int    Camera::g_calibration_nb_buffers       = 10    ; // DCAM frames allocated for a calibration capture
+const double Camera::g_calibration_timeout          = 10.0  ; // calibration capture timeout (s), added to the exposure of the averaged images
+const int    Camera::g_regions_max                  = 16    ; // maximum number of regions of the multi-region readout
+const int32  Camera::g_recorder_events              = DCAMWAIT_RECEVENT_STOPPED  | DCAMWAIT_RECEVENT_MISSED     | 
+                                                      DCAMWAIT_RECEVENT_DISKFULL | DCAMWAIT_RECEVENT_WRITEFAULT | 
+                                                      DCAMWAIT_RECEVENT_SKIPPED;
 
 const string Camera::g_trace_line_separator       = "--------------------------------------------------------------";
 const string Camera::g_trace_little_line_separator = "--------------------------------";
@@ -102,7 +115,6 @@ Camera::Camera(const std::string& config_path, int camera_number, int frame_buff
       m_read_mode      (2)    ,
       m_sensor_mode    (1)    ,
       m_lost_frames_count(0)  ,
-      m_fps            (0.0)  ,
       m_hdr_enabled    (false),
       m_view_exp_time  (NULL)   // array of exposure value by view
 
@@ -113,6 +125,42 @@ Camera::Camera(const std::string& config_path, int camera_number, int frame_buff
     m_config_path       = config_path  ;
     m_camera_number     = camera_number;
     m_frame_buffer_size = frame_buffer_size;
+    m_zero_copy_enabled = false;
+    m_frame_bundle_number = 1; // frame bundle disabled by default
+    m_ring_auto_size      = false ; // the depth given to the constructor is used by default
+    m_ring_memory_budget  = 1024.0; // MB
+    m_ring_latency        = 0.5   ; // s
+    m_prepare_acq_time    = 0.0   ;
+    m_start_acq_time      = 0.0   ;
+    m_stop_acq_time       = 0.0   ;
+    m_hw_timestamp_supported  = false;
+    m_hw_framestamp_supported = false;
+    m_hw_timestamp_enabled    = true ;
+    m_overrun_policy          = Overrun_Policy_Skip;
+    m_exposure_events_mode    = Exposure_Events_Auto;
+    m_acq_thread_priority     = SystemTuning::Priority_Normal;
+    m_numa_node               = -1   ;
+    m_buffer_prefault         = false;
+    m_buffer_lock             = false;
+    m_buffer_huge_pages       = false;
+    m_packed_transfer         = false;
+    m_mono8_supported         = false;
+    m_bit_window              = -1   ;
+    m_soft_bit_shift          = -1   ;
+    m_recording_enabled       = false;
+    m_recording_path          = "hamamatsu_rec";
+    m_recording_max_frames    = g_recording_default_max_frames;
+    m_recording_decimation    = 0    ;
+    m_live_decimation         = 1    ;
+    m_live_max_rate           = 0.0  ;
+    m_raw_writer_enabled      = false;
+    m_raw_writer_path         = "hamamatsu_raw";
+    m_thread.getRawWriterDefaults(m_raw_writer_file_size, m_raw_writer_slots, m_raw_writer_direct_io);
+    m_snapshot_enabled        = false;
+    m_snapshot_max_rate       = g_snapshot_default_max_rate;
+    m_accumulation_nb_frames  = 1    ;
+    m_accumulation_average    = false;
+    m_hw_regions              = false;
   
     m_map_triggerMode[IntTrig       ] = "IntTrig"       ;
     m_map_triggerMode[IntTrigMult   ] = "IntTrigMult"   ;
@@ -166,6 +214,7 @@ Camera::Camera(const std::string& config_path, int camera_number, int frame_buff
         // sets no view mode by default
         m_view_mode_enabled = false; // W-View mode with splitting image
         m_view_number      = 0    ; // number of W-Views
+        m_view_split       = false; // one lima frame per W-View
 
         setViewMode(false, 0);
 
@@ -204,6 +253,9 @@ Camera::~Camera()
     DCAMERR err;
 
     stopAcq();
+
+    // the DCAM ring is kept allocated between the acquisitions
+    m_thread.releasePreparedBuffers();
                
     // Close camera
     DEB_TRACE() << "Shutdown camera";
@@ -238,6 +290,29 @@ Camera::~Camera()
 void Camera::getDetectorMaxImageSize(Size& size) ///< [out] image dimensions
 {
     DEB_MEMBER_FUNCT();
+
+    // the lima frame holds the packed regions
+    if(!m_regions.empty())
+    {
+        size = m_regions_frame_size;
+        return;
+    }
+
+    // the lima frame holds the subarray of one view or the subarrays of the two views
+    if(!m_view_rois.empty())
+    {
+        Size view_size = m_view_rois[0].getSize();
+        size = (isViewSplitActive()) ? view_size : Size(view_size.getWidth(), view_size.getHeight() * 2);
+        return;
+    }
+
+    // the lima frame holds one of the two views
+    if(isViewSplitActive())
+    {
+        size = Size(m_max_image_width, m_max_image_height / 2);
+        return;
+    }
+
     size = Size(m_max_image_width, m_max_image_height);
 }
 
@@ -278,6 +353,20 @@ void Camera::getImageType(ImageType& type)
 
     type = Bpp16;
 
+    // 16 bits DCAM pixels summed in 32 bits by the acquisition thread
+    if(m_depth == 32)
+    {
+        type = (m_accumulation_average) ? Bpp32F : Bpp32;
+        return;
+    }
+
+    // 16 bits DCAM pixels reduced to 8 bits by the copy
+    if(m_soft_bit_shift >= 0)
+    {
+        type = Bpp8;
+        return;
+    }
+
     long bits_type =  dcamex_getbitsperchannel(m_camera_handle);
     
     if (0 != bits_type )
@@ -285,6 +374,7 @@ void Camera::getImageType(ImageType& type)
         switch( bits_type )
         {
             case 8 :  type = Bpp8 ; break;
+            case 12:  type = Bpp16; break; // 12 bits packed pixels are unpacked to 16 bits
             case 16:  type = Bpp16; break;
             case 32:  type = Bpp32; break;
             default:
@@ -308,21 +398,123 @@ void Camera::setImageType(ImageType type)
 {
     DEB_MEMBER_FUNCT();
     DEB_TRACE() << "Camera::setImageType - " << DEB_VAR1(type);
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the image type during an acquisition!";
+    }
+
     switch(type)
     {
+        case Bpp8:
+        {
+            if(m_hdr_enabled)
+            {
+                manage_error( deb, "8 bits pixels are not possible in high dynamic range mode!");
+                THROW_HW_ERROR(Error) << "8 bits pixels are not possible in high dynamic range mode!";
+            }
+
+            if(m_packed_transfer)
+            {
+                manage_error( deb, "8 bits pixels are not possible with the packed transfer!");
+                THROW_HW_ERROR(Error) << "8 bits pixels are not possible with the packed transfer!";
+            }
+
+            m_depth = 8;
+            break;
+        }
         case Bpp16:
         {
-            m_depth    = 16;
+            m_depth = 16;
+            break;
+        }
+        case Bpp32 :
+        case Bpp32F:
+        {
+            if(m_hdr_enabled)
+            {
+                manage_error( deb, "Accumulated images are not possible in high dynamic range mode!");
+                THROW_HW_ERROR(Error) << "Accumulated images are not possible in high dynamic range mode!";
+            }
+
+            if(m_packed_transfer)
+            {
+                manage_error( deb, "Accumulated images are not possible with the packed transfer!");
+                THROW_HW_ERROR(Error) << "Accumulated images are not possible with the packed transfer!";
+            }
+
+            // sums (Bpp32) or means (Bpp32F) of setAccumulationNbFrames images
+            m_depth                = 32;
+            m_accumulation_average = (type == Bpp32F);
             break;
         }
         default:
-            manage_error( deb, "This pixel format of the camera is not managed, only 16 bits cameras are already managed!");
-            THROW_HW_ERROR(Error) << "This pixel format of the camera is not managed, only 16 bits cameras are already managed!";
+            manage_error( deb, "This pixel format of the camera is not managed, only 8, 16 and 32 bits are managed!");
+            THROW_HW_ERROR(Error) << "This pixel format of the camera is not managed, only 8, 16 and 32 bits are managed!";
             break;
     }
 
     DEB_TRACE() << "SetImageType: " << m_depth;
     m_bytes_per_pixel = m_depth / 8;
+
+    m_thread.releasePreparedBuffers(); // the image layout changes
+    applyImagePixelType();
+
+    // lima reallocates its buffers with the new depth
+    Size max_image_size;
+    getDetectorMaxImageSize(max_image_size);
+    maxImageSizeChanged(max_image_size, type);
+}
+
+//-----------------------------------------------------------------------------
+/// Set the DCAM pixel type from the lima depth, the packed transfer and the
+/// bit window. In 8 bits, the camera gives the pixels if it can and if no 
+/// window is asked, otherwise the 16 bits pixels are reduced by the copy.
+/// In 32 bits, the 16 bits pixels are summed by the acquisition thread.
+//-----------------------------------------------------------------------------
+void Camera::applyImagePixelType(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    m_soft_bit_shift = -1;
+
+    if(m_depth == 8)
+    {
+        if((m_bit_window < 0) && m_mono8_supported)
+        {
+            dcamex_setimagepixeltype( m_camera_handle, DCAM_PIXELTYPE_MONO8);
+        }
+        else
+        {
+            dcamex_setimagepixeltype( m_camera_handle, DCAM_PIXELTYPE_MONO16);
+
+            if(m_bit_window >= 0)
+            {
+                m_soft_bit_shift = m_bit_window;
+            }
+            else
+            {
+                // no choice from the user: the 8 most significant bits of the sensor
+                double bits = 16.0;
+
+                if( failed( dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_BITSPERCHANNEL, &bits ) ) || (bits < 8.0) )
+                    bits = 16.0;
+
+                m_soft_bit_shift = static_cast<int>(bits) - 8;
+            }
+        }
+    }
+    else
+    if(m_depth == 32)
+    {
+        dcamex_setimagepixeltype( m_camera_handle, DCAM_PIXELTYPE_MONO16);
+    }
+    else
+    {
+        dcamex_setimagepixeltype( m_camera_handle, (m_packed_transfer) ? DCAM_PIXELTYPE_MONO12P : DCAM_PIXELTYPE_MONO16);
+    }
+
+    DEB_TRACE() << "Image pixel type applied: " << DEB_VAR3(m_depth, m_packed_transfer, m_soft_bit_shift);
 }
 
 //-----------------------------------------------------------------------------
@@ -394,7 +586,8 @@ void Camera::setTrigMode(TrigMode mode) ///< [in] trigger mode to set
         else
         if(mode == IntTrigMult)
         {
-            trigger_source = DCAMPROP_TRIGGERSOURCE__INTERNAL;
+            // each lima startAcq call fires a frame (see startAcq)
+            trigger_source = DCAMPROP_TRIGGERSOURCE__SOFTWARE;
             trigger_active = DCAMPROP_TRIGGERACTIVE__EDGE    ;
             trigger_mode   = DCAMPROP_TRIGGER_MODE__NORMAL   ;
         }
@@ -702,6 +895,20 @@ void Camera::checkRoi(const Roi & set_roi, ///< [in]  Roi values to set
     int   width    = size.getWidth () * m_bin.getX();
     int   height   = size.getHeight() * m_bin.getY();
 
+    // the multi-region frame is only given as a whole
+    if (!m_regions.empty())
+    {
+        Roi regions_roi(Point(0, 0), m_regions_frame_size);
+
+        if (((width != 0) || (height != 0)) && (set_roi != regions_roi))
+        {
+            THROW_HW_ERROR(Error) << "Cannot change the ROI with the multi-region readout! Only (0, 0, " 
+                                  << m_regions_frame_size.getWidth() << ", " << m_regions_frame_size.getHeight() << ") is supported.";
+        }
+
+        hw_roi = regions_roi;
+    }
+    else
     if ((width == 0) && (height == 0))
     {
         DEB_TRACE() << "Ignore 0x0 roi";
@@ -753,6 +960,14 @@ void Camera::setRoi(const Roi & set_roi) ///< [in] New Roi values
                 << set_roi.getSize   ().getWidth () << ", " 
                 << set_roi.getSize   ().getHeight();
 
+    // the subarray is the bounding box of the regions (see setRegions)
+    if (!m_regions.empty())
+    {
+        Roi checked_roi;
+        checkRoi(set_roi, checked_roi);
+        return;
+    }
+
     Point set_roi_topleft(set_roi.getTopLeft().x       * m_bin.getX(), set_roi.getTopLeft().y        * m_bin.getY());
     Size  set_roi_size   (set_roi.getSize().getWidth() * m_bin.getX(), set_roi.getSize().getHeight() * m_bin.getY());
 
@@ -760,7 +975,7 @@ void Camera::setRoi(const Roi & set_roi) ///< [in] New Roi values
     if ((set_roi_size.getWidth() == 0) && (set_roi_size.getHeight() == 0))
     {
         DEB_TRACE() << "Correcting 0x0 roi...";
-        set_roi_size = Size(m_max_image_width, m_max_image_height);
+        getDetectorMaxImageSize(set_roi_size);
     }
 
     Roi new_roi(set_roi_topleft, set_roi_size);
@@ -773,7 +988,10 @@ void Camera::setRoi(const Roi & set_roi) ///< [in] New Roi values
     // Changing the ROI is not allowed in W-VIEW mode except for full frame
     if(m_view_mode_enabled)
     {
-        Roi FullFrameRoi(Point(0, 0), Size(m_max_image_width, m_max_image_height));
+        Size max_image_size;
+        getDetectorMaxImageSize(max_image_size);
+
+        Roi FullFrameRoi(Point(0, 0), max_image_size);
         if(new_roi != FullFrameRoi)
         {
             manage_error( deb, "Cannot change ROI in W-VIEW mode! Only full frame is supported.", DCAMERR_NONE, "setRoi");
@@ -781,12 +999,25 @@ void Camera::setRoi(const Roi & set_roi) ///< [in] New Roi values
         }
     }
 
-    // view mode activated and two views 
+    // the DCAM ring kept from the previous acquisition already uses this subarray,
+    // otherwise it must be released before changing the subarray
+    if((new_roi == m_roi) && m_thread.isBuffersAllocated())
+        return;
+
+    m_thread.releasePreparedBuffers();
+
+    // view mode activated and two views (the lima roi is one view in split mode, both views otherwise)
     if((m_view_mode_enabled) && (m_view_number == 2))
     {
+        int view_height = (isViewSplitActive()) ? set_roi_size.getHeight() : set_roi_size.getHeight() / 2;
+
+        // each view has its own position when the view subarrays are set (the size is common)
+        Point view1_topleft = (m_view_rois.empty()) ? set_roi_topleft : m_view_rois[0].getTopLeft();
+        Point view2_topleft = (m_view_rois.empty()) ? set_roi_topleft : m_view_rois[1].getTopLeft();
+
         if (!dcamex_setsubarrayrect(m_camera_handle, 
-                                    set_roi_topleft.x      , set_roi_topleft.y         ,
-                                    set_roi_size.getWidth(), set_roi_size.getHeight()/2,
+                                    view1_topleft.x        , view1_topleft.y,
+                                    set_roi_size.getWidth(), view_height    ,
                                     0))
         {
             manage_error( deb, "Cannot set detector ROI for View1 !");
@@ -794,8 +1025,8 @@ void Camera::setRoi(const Roi & set_roi) ///< [in] New Roi values
         }
 
         if (!dcamex_setsubarrayrect(m_camera_handle, 
-                                    set_roi_topleft.x      , set_roi_topleft.y         ,
-                                    set_roi_size.getWidth(), set_roi_size.getHeight()/2,
+                                    view2_topleft.x        , view2_topleft.y,
+                                    set_roi_size.getWidth(), view_height    ,
                                     1))
         {
             manage_error( deb, "Cannot set detector ROI for View2 !");
@@ -824,6 +1055,25 @@ void Camera::getRoi(Roi & hw_roi) ///< [out] Roi values
 {
     DEB_MEMBER_FUNCT();
 
+    // lima sees the frame of the packed regions
+    if (!m_regions.empty())
+    {
+        hw_roi = Roi(Point(0, 0), m_regions_frame_size);
+        DEB_RETURN() << DEB_VAR1(hw_roi);
+        return;
+    }
+
+    // lima sees the subarrays of the views, stacked when not split
+    if (!m_view_rois.empty())
+    {
+        Size max_image_size;
+        getDetectorMaxImageSize(max_image_size);
+
+        hw_roi = Roi(0, 0, max_image_size.getWidth() / m_bin.getX(), max_image_size.getHeight() / m_bin.getY());
+        DEB_RETURN() << DEB_VAR1(hw_roi);
+        return;
+    }
+
     int32 left, top, width, height;
 
     if (!dcamex_getsubarrayrect( m_camera_handle, left, top, width,    height, GET_SUBARRAY_RECT_DO_NOT_USE_VIEW ) )
@@ -832,8 +1082,8 @@ void Camera::getRoi(Roi & hw_roi) ///< [out] Roi values
         THROW_HW_ERROR(Error) << "Cannot get detector ROI";
     }    
 
-    // view mode activated and two views 
-    if((m_view_mode_enabled) && (m_view_number == 2))
+    // view mode activated and two views (not in split mode: the lima frame is one view)
+    if((m_view_mode_enabled) && (m_view_number == 2) && (!isViewSplitActive()))
     {
         height *= 2; // height correction to get the global ROI (two views height)
     }
@@ -899,6 +1149,12 @@ void Camera::checkBin(Bin & hw_bin) ///< [out] binning values to update
         THROW_HW_ERROR(Error) << "Binning values not supported";
     }
 
+    if ( (!m_regions.empty()) && (hw_bin.getX() != 1) )
+    {
+        DEB_ERROR() << "The multi-region readout needs a 1x1 binning";
+        THROW_HW_ERROR(Error) << "The multi-region readout needs a 1x1 binning";
+    }
+
     DEB_RETURN() << DEB_VAR1(hw_bin);
 }
 
@@ -913,6 +1169,12 @@ void Camera::setBin(const Bin & set_bin) ///< [in] binning values objects
     // Binning values have been checked by checkBin()
     DCAMERR err;
 
+    // the DCAM ring kept from the previous acquisition already uses this binning
+    if((set_bin == m_bin) && m_thread.isBuffersAllocated())
+        return;
+
+    m_thread.releasePreparedBuffers();
+
     // set the binning
     err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_BINNING, static_cast<double>(GetBinningMode(set_bin.getX())));
 
@@ -1083,8 +1345,10 @@ void Camera::initialiseController()
         THROW_HW_ERROR(Error) << "Failed to get capabilities";
     }
 
-    BOOL bTimestamp  = (devcap.capflag & DCAMDEV_CAPFLAG_TIMESTAMP ) ? TRUE : FALSE;
-    BOOL bFramestamp = (devcap.capflag & DCAMDEV_CAPFLAG_FRAMESTAMP) ? TRUE : FALSE;
+    m_hw_timestamp_supported  = (devcap.capflag & DCAMDEV_CAPFLAG_TIMESTAMP ) ? true : false;
+    m_hw_framestamp_supported = (devcap.capflag & DCAMDEV_CAPFLAG_FRAMESTAMP) ? true : false;
+
+    DEB_TRACE() << "Hardware timestamp: " << m_hw_timestamp_supported << ", hardware framestamp: " << m_hw_framestamp_supported;
 
     //---------------------------------------------------------------------
     // Create the list of available binning modes from camera capabilities
@@ -1127,6 +1391,19 @@ void Camera::initialiseController()
         ++iterBinningMode;
     }
 
+    //---------------------------------------------------------------------
+    // Check if the camera can give 8 bits pixels (Bpp8 is done by the copy otherwise)
+    {
+        FeatureInfos feature_obj;
+
+        if( dcamex_getfeatureinq( m_camera_handle, "DCAM_IDPROP_IMAGE_PIXELTYPE", DCAM_IDPROP_IMAGE_PIXELTYPE, feature_obj ) )
+        {
+            m_mono8_supported = feature_obj.checkifValueExists(static_cast<double>(DCAM_PIXELTYPE_MONO8));
+        }
+
+        DEB_TRACE() << "DCAM_PIXELTYPE_MONO8 supported: " << m_mono8_supported;
+    }
+
     //---------------------------------------------------------------------
     // Create the list of available trigger modes from camera capabilities
     FeatureInfos trigger_source_feature_obj;
@@ -1170,7 +1447,7 @@ void Camera::initialiseController()
         m_map_trig_modes[IntTrig] = true;
 
     // IntTrigMult
-    if((trigger_source_feature_obj.checkifValueExists(static_cast<double>(DCAMPROP_TRIGGERSOURCE__INTERNAL ))) &&
+    if((trigger_source_feature_obj.checkifValueExists(static_cast<double>(DCAMPROP_TRIGGERSOURCE__SOFTWARE ))) &&
        (trigger_active_feature_obj.checkifValueExists(static_cast<double>(DCAMPROP_TRIGGERACTIVE__EDGE     ))) &&
        (trigger_mode_feature_obj.checkifValueExists  (static_cast<double>(DCAMPROP_TRIGGER_MODE__NORMAL    ))))
         m_map_trig_modes[IntTrigMult] = true;
@@ -1315,6 +1592,8 @@ void Camera::setReadoutSpeed(const short int readout_speed) ///< [in] new readou
     DEB_MEMBER_FUNCT();
     DEB_PARAM() << DEB_VAR1(readout_speed);
 
+    m_thread.releasePreparedBuffers(); // the image layout can change
+
     if( getSensorModeLabelFromValue(m_sensor_mode) != SENSORMODE_AREA_NAME )
     {
         THROW_HW_ERROR(Error) << "readoutSpeed can only be changed if sensorMode is AREA";
@@ -1491,6 +1770,8 @@ void Camera::setSensorMode(const short int sensor_mode) ///< [in] new sensor mod
     DEB_MEMBER_FUNCT();
     DEB_PARAM() << DEB_VAR1(sensor_mode);
 
+    m_thread.releasePreparedBuffers(); // the image layout can change
+
     DCAMERR err;
 
     // set the sensor mode
@@ -1613,1571 +1894,6297 @@ void Camera::getLostFrames(unsigned long int& lost_frames) ///< [out] current lo
 // LOST FRAMES
 //=============================================================================
 //-----------------------------------------------------------------------------
-/// Get the frame rate
+/// Get the frame rate over the metrics window (see getRollingMetrics())
 //-----------------------------------------------------------------------------
-void Camera::getFPS(double& fps) ///< [out] last computed fps
+void Camera::getFPS(double& fps) ///< [out] frame rate over the metrics window
 {
     DEB_MEMBER_FUNCT();
 
-    fps = m_fps;
+    RollingMetrics::Values metrics;
+    m_thread.getMetrics(metrics);
+
+    fps = metrics.frame_rate;
 }
 
+//=============================================================================
+// ZERO-COPY ACQUISITION
+//=============================================================================
 //-----------------------------------------------------------------------------
-/// CAPTURE
+/// Enable or disable the zero-copy acquisition.
+/// When enabled, the lima frame buffers are attached as the DCAM ring buffer
+/// (dcambuf_attach) so the driver writes directly into the lima frames.
+/// If the buffer geometry does not allow it, the acquisition falls back to
+/// the classic copy of the frames.
 //-----------------------------------------------------------------------------
+void Camera::setZeroCopyEnabled(const bool & in_enabled) ///< [in] true to attach the lima buffers as DCAM ring
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the zero-copy mode during an acquisition!";
+    }
+
+    m_zero_copy_enabled = in_enabled;
+    DEB_TRACE() << DEB_VAR1(m_zero_copy_enabled);
+}
+
 //-----------------------------------------------------------------------------
-/// Set detector for single image acquisition
+/// Get the zero-copy acquisition request state
 //-----------------------------------------------------------------------------
-void Camera::prepareAcq()
+bool Camera::getZeroCopyEnabled(void)
 {
     DEB_MEMBER_FUNCT();
+    return m_zero_copy_enabled;
 }
 
 //-----------------------------------------------------------------------------
-///  start the acquistion
+/// Return true if the current (or latest) acquisition really uses zero-copy
 //-----------------------------------------------------------------------------
-void Camera::startAcq()
+bool Camera::getZeroCopyActive(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_TRACE() << g_trace_line_separator.c_str();
+    return m_thread.isZeroCopy();
+}
 
-    traceAllRoi();
+//=============================================================================
+// FRAME BUNDLE
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Return the frame bundle support by the current detector
+//-----------------------------------------------------------------------------
+bool Camera::isFrameBundleSupported(void)
+{
+    DEB_MEMBER_FUNCT();
 
-    m_image_number = 0;
-    m_fps          = 0;
+    DCAMERR err;
+    double  temp;
 
-    // init force stop flag before starting acq thread
-    m_thread.m_force_stop = false;
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_MODE, &temp );
 
-    m_thread.sendCmd      (CameraThread::StartAcq);
-    m_thread.waitNotStatus(CameraThread::Ready   );
+    return !failed(err);
 }
 
 //-----------------------------------------------------------------------------
-/// stop the acquisition
+/// Set the number of frames per bundle.
+/// With a bundle, the camera transfers several images in one DCAM frame which
+/// reduces the per frame overhead at high frame rates (small subarrays).
+/// 1 disables the frame bundle, 0 lets the plugin choose the number from the
+/// predicted frame rate at each acquisition start.
 //-----------------------------------------------------------------------------
-void Camera::stopAcq()
+void Camera::setFrameBundleNumber(const int in_bundle_number) ///< [in] frames per bundle (1: disabled, 0: automatic)
 {
     DEB_MEMBER_FUNCT();
-    DEB_TRACE() << g_trace_line_separator.c_str();
 
-    execStopAcq();
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the frame bundle during an acquisition!";
+    }
 
-    if(m_thread.getStatus() != CameraThread::Fault)
+    if(in_bundle_number < 0)
     {
-        // Wait for thread to finish
-        m_thread.waitStatus(CameraThread::Ready);
+        THROW_HW_ERROR(Error) << "Incorrect frame bundle number: " << in_bundle_number;
     }
-    else
+
+    if((in_bundle_number != 1) && (!isFrameBundleSupported()))
     {
-        // aborting the thread
-        m_thread.abort();
+        THROW_HW_ERROR(NotSupported) << "Frame bundle is not supported by this camera!";
+    }
+
+    if(in_bundle_number > 1)
+    {
+        DCAMPROP_ATTR attr;
+        memset( &attr, 0, sizeof(attr) );
+        attr.cbSize = sizeof(attr);
+        attr.iProp  = DCAM_IDPROP_FRAMEBUNDLE_NUMBER;
+
+        if( !failed( dcamprop_getattr( m_camera_handle, &attr ) ) && (attr.attribute & DCAMPROP_ATTR_HASRANGE) )
+        {
+            if((in_bundle_number < static_cast<int>(attr.valuemin)) || (in_bundle_number > static_cast<int>(attr.valuemax)))
+            {
+                THROW_HW_ERROR(Error) << "Frame bundle number out of range [" << attr.valuemin << ", " << attr.valuemax << "]";
+            }
+        }
     }
+
+    m_frame_bundle_number = in_bundle_number;
+    DEB_TRACE() << DEB_VAR1(m_frame_bundle_number);
 }
 
 //-----------------------------------------------------------------------------
-/// utility thread
+/// Get the requested number of frames per bundle (1: disabled, 0: automatic)
 //-----------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::CameraThread()
-//---------------------------------------------------------------------------------------
-Camera::CameraThread::CameraThread(Camera * cam)
-: m_cam(cam)
+int Camera::getFrameBundleNumber(void)
 {
     DEB_MEMBER_FUNCT();
-    m_force_stop = false;
-    m_wait_handle = NULL ;
-    DEB_TRACE() << "DONE";
+    return m_frame_bundle_number;
 }
 
-/************************************************************************
- * \brief destructor
- ************************************************************************/
-Camera::CameraThread::~CameraThread()
+//-----------------------------------------------------------------------------
+/// Get the number of frames per bundle used by the current (or latest) acquisition
+//-----------------------------------------------------------------------------
+int Camera::getFrameBundleActiveNumber(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_TRACE() << "CameraThread::~CameraThread";
-    abort();
+    return m_thread.getBundleNumber();
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::start()
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::start()
+//-----------------------------------------------------------------------------
+/// Return the frame rate expected with the current settings
+//-----------------------------------------------------------------------------
+double Camera::getPredictedFrameRate(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_TRACE() << "BEGIN";
-    CmdThread::start();
-    waitStatus(Ready);
-    DEB_TRACE() << "END";
-}
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::init()
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::init()
-{
-    DEB_MEMBER_FUNCT();
-    setStatus(CameraThread::Ready);
-    DEB_TRACE() << "CameraThread::init DONE";
+    DCAMERR err;
+    double  frame_rate = 0.0;
+
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_INTERNALFRAMERATE, &frame_rate );
+
+    if( failed(err) || (frame_rate <= 0.0) )
+    {
+        // use the exposure time if the camera cannot give its internal frame rate
+        double exposure;
+        getExpTime(exposure);
+
+        frame_rate = (exposure > 0.0) ? (1.0 / exposure) : 0.0;
+    }
+
+    DEB_RETURN() << DEB_VAR1(frame_rate);
+    return frame_rate;
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::abort()
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::abort()
+//-----------------------------------------------------------------------------
+/// Compute the frames per bundle in automatic mode.
+/// The bundle is chosen so the acquisition thread wakes up at most
+/// g_frame_bundle_auto_wakeup_rate times per second.
+//-----------------------------------------------------------------------------
+int Camera::computeAutoFrameBundleNumber(void)
 {
     DEB_MEMBER_FUNCT();
-    CmdThread::abort();
-    DEB_TRACE() << "CameraThread::abort DONE";
+
+    // frames only come with the triggers in external modes: a partial bundle would never be transferred
+    if((m_trig_mode != IntTrig) || (!isFrameBundleSupported()))
+        return 1;
+
+    int bundle_number = static_cast<int>(ceil(getPredictedFrameRate() / g_frame_bundle_auto_wakeup_rate));
+
+    DCAMPROP_ATTR attr;
+    memset( &attr, 0, sizeof(attr) );
+    attr.cbSize = sizeof(attr);
+    attr.iProp  = DCAM_IDPROP_FRAMEBUNDLE_NUMBER;
+
+    if( failed( dcamprop_getattr( m_camera_handle, &attr ) ) )
+        return 1;
+
+    if((attr.attribute & DCAMPROP_ATTR_HASRANGE) && (bundle_number > static_cast<int>(attr.valuemax)))
+        bundle_number = static_cast<int>(attr.valuemax);
+
+    // no need to bundle more frames than requested
+    if((m_nb_frames > 0) && (bundle_number > m_nb_frames))
+        bundle_number = m_nb_frames;
+
+    if(bundle_number < 1)
+        bundle_number = 1;
+
+    DEB_RETURN() << DEB_VAR1(bundle_number);
+    return bundle_number;
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::execCmd()
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::execCmd(int cmd)
+//=============================================================================
+// FRAME COPY
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Set the number of threads copying the frames from the DCAM ring buffer.
+/// With 0, the frames are copied by the acquisition thread itself. Otherwise
+/// the acquisition thread only waits for the DCAM events and dispatches the
+/// copies to the pool, the frames are given to lima in order.
+//-----------------------------------------------------------------------------
+void Camera::setCopyThreadsNumber(const int in_nb_threads) ///< [in] number of copy threads (0: copy in the acquisition thread)
 {
     DEB_MEMBER_FUNCT();
 
-    int status = getStatus();
-
-    try
-    {
-        switch (cmd)
-        {
-            case StartAcq:
-                if (status != Ready)
-                    throw LIMA_HW_EXC(InvalidValue, "Not Ready to StartAcq");
-                execStartAcq();
-                break;
-        }
-    }
-    catch (...)
+    if(m_thread.getStatus() != CameraThread::Ready)
     {
+        THROW_HW_ERROR(Error) << "Cannot change the number of copy threads during an acquisition!";
     }
+
+    m_thread.setCopyThreads(in_nb_threads);
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::execStopAcq()
-//---------------------------------------------------------------------------------------
-void Camera::execStopAcq()
+//-----------------------------------------------------------------------------
+/// Get the number of threads copying the frames
+//-----------------------------------------------------------------------------
+int Camera::getCopyThreadsNumber(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_TRACE() << "executing StopAcq command...";
-
-    if((getStatus() != Camera::Exposure) && (getStatus() != Camera::Readout))
-        DEB_WARNING() << "Execute a stop acq command but not in [exposure,Readout] status. ThreadStatus=" << m_thread.getStatus();
-
-    m_thread.abortCapture();
+    return m_thread.getCopyThreads();
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::checkStatusBeforeCapturing()
-// throws an exception if the status is incorrect
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::checkStatusBeforeCapturing() const
+//-----------------------------------------------------------------------------
+/// Set the frame size from which the frames are copied with streaming stores
+/// (bypassing the cache). 0 restores the default value: the last level cache size.
+//-----------------------------------------------------------------------------
+void Camera::setCopyNonTemporalThreshold(const long in_threshold) ///< [in] frame size (bytes) from which streaming stores are used (0: cache size)
 {
     DEB_MEMBER_FUNCT();
 
-    long    status;
-    DCAMERR err   ;
-
-    // Check the status and stop capturing if capturing is already started.
-    err = dcamcap_status( m_cam->m_camera_handle, &status );
-
-    if( failed(err) )
+    if(in_threshold < 0)
     {
-        static_manage_error( m_cam, deb, "Cannot get status", err, "dcamcap_status");
-        THROW_HW_ERROR(Error) << "Cannot get status";
+        THROW_HW_ERROR(Error) << "Incorrect non-temporal threshold: " << in_threshold;
     }
 
-    if (DCAMCAP_STATUS_READY != status) // After allocframe, the camera status should be READY
-    {
-        DEB_ERROR() << "Camera could not be set in the proper state for image capture";
-        THROW_HW_ERROR(Error) << "Camera could not be set in the proper state for image capture";
-    }
+    FrameCopy::setNonTemporalThreshold(static_cast<size_t>(in_threshold));
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::createWaitHandle()
-// throws an exception in case of problem
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::createWaitHandle(HDCAMWAIT & wait_handle) const
+//-----------------------------------------------------------------------------
+/// Get the frame size from which the frames are copied with streaming stores
+//-----------------------------------------------------------------------------
+long Camera::getCopyNonTemporalThreshold(void)
+{
+    DEB_MEMBER_FUNCT();
+    return static_cast<long>(FrameCopy::getNonTemporalThreshold());
+}
+
+//-----------------------------------------------------------------------------
+/// Set the frame size from which a frame is split between the copy threads
+//-----------------------------------------------------------------------------
+void Camera::setCopySplitThreshold(const long in_threshold) ///< [in] frame size (bytes) from which a frame is copied by several threads (0: never)
 {
     DEB_MEMBER_FUNCT();
 
-    DCAMERR err;
+    if(in_threshold < 0)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect split threshold: " << in_threshold;
+    }
 
-    wait_handle = NULL;
+    m_thread.setCopySplitThreshold(static_cast<size_t>(in_threshold));
+}
 
-    // open wait handle
-    DCAMWAIT_OPEN waitOpenHandle;
+//-----------------------------------------------------------------------------
+/// Get the frame size from which a frame is split between the copy threads
+//-----------------------------------------------------------------------------
+long Camera::getCopySplitThreshold(void)
+{
+    DEB_MEMBER_FUNCT();
+    return static_cast<long>(m_thread.getCopySplitThreshold());
+}
 
-    memset( &waitOpenHandle, 0, sizeof(DCAMWAIT_OPEN) );
-    waitOpenHandle.size     = sizeof(DCAMWAIT_OPEN) ;
-    waitOpenHandle.hdcam = m_cam->m_camera_handle;
+//-----------------------------------------------------------------------------
+/// Get the name of the copy kernel chosen for the cpu (AVX512, AVX2 or SCALAR)
+//-----------------------------------------------------------------------------
+std::string Camera::getCopyKernelName(void)
+{
+    DEB_MEMBER_FUNCT();
+    return FrameCopy::getKernelName();
+}
 
-    err = dcamwait_open( &waitOpenHandle );
+//-----------------------------------------------------------------------------
+/// Compare the copy kernel with the former line by line memcpy, using the
+/// current frame geometry (lima frame size and DCAM row bytes).
+//-----------------------------------------------------------------------------
+void Camera::benchmarkFrameCopy(const int in_nb_iterations, ///< [in]  number of copies to time
+                                double &  out_memcpy_rate , ///< [out] line by line memcpy rate (MB/s)
+                                double &  out_kernel_rate ) ///< [out] copy kernel rate (MB/s)
+{
+    DEB_MEMBER_FUNCT();
 
-    if( failed(err) )
+    if(m_thread.getStatus() != CameraThread::Ready)
     {
-        static_manage_error( m_cam, deb, "Cannot create the wait handle", err, "dcamwait_open");
-        THROW_HW_ERROR(Error) << "Cannot create the wait handle";
+        THROW_HW_ERROR(Error) << "Cannot run the copy benchmark during an acquisition!";
     }
-    else
+
+    FrameDim frame_dim = m_buffer_ctrl_obj.getBuffer().getFrameDim();
+    long     line_size = frame_dim.getSize().getWidth() * frame_dim.getDepth();
+    int      height    = frame_dim.getSize().getHeight();
+    double   row_bytes = 0.0;
+
+    if( failed( dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_BUFFER_ROWBYTES, &row_bytes ) ) || 
+        (static_cast<long>(row_bytes) < line_size) )
     {
-        wait_handle = waitOpenHandle.hwait; // after this, no need to keep the waitopen structure, freed by the stack
+        row_bytes = static_cast<double>(line_size);
     }
+
+    FrameCopy::benchmark(line_size, static_cast<long>(row_bytes), height, in_nb_iterations, out_memcpy_rate, out_kernel_rate);
+
+    DEB_ALWAYS() << "Frame copy benchmark (" << FrameCopy::getKernelName() << ", " << line_size << "x" << height 
+                 << ", row bytes " << static_cast<long>(row_bytes) << "): memcpy " << out_memcpy_rate 
+                 << " MB/s, kernel " << out_kernel_rate << " MB/s";
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::releaseWaitHandle()
-// does not throw exception in case of problem but trace an error.
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::releaseWaitHandle(HDCAMWAIT & wait_handle) const
+//-----------------------------------------------------------------------------
+/// Compare the 12 bits unpack kernel with the scalar unpack, using the current
+/// lima frame geometry and the DCAM_PIXELTYPE_MONO12P packing.
+/// An error is thrown if the kernel does not give the scalar output.
+//-----------------------------------------------------------------------------
+void Camera::benchmarkFrameUnpack(const int in_nb_iterations, ///< [in]  number of unpacks to time
+                                  double &  out_scalar_rate , ///< [out] scalar unpack rate (MB/s of 16 bits pixels)
+                                  double &  out_kernel_rate ) ///< [out] unpack kernel rate (MB/s of 16 bits pixels)
 {
     DEB_MEMBER_FUNCT();
 
-    DCAMERR err;
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot run the unpack benchmark during an acquisition!";
+    }
 
-    err = dcamwait_close( wait_handle );
+    FrameDim frame_dim = m_buffer_ctrl_obj.getBuffer().getFrameDim();
+    int      width     = frame_dim.getSize().getWidth ();
+    int      height    = frame_dim.getSize().getHeight();
 
-    if( failed(err) )
+    bool same_output = FrameCopy::benchmarkUnpack(width, height, in_nb_iterations, FrameCopy::Conversion_Mono12P, out_scalar_rate, out_kernel_rate);
+
+    DEB_ALWAYS() << "Frame unpack benchmark (" << FrameCopy::getKernelName() << ", " << width << "x" << height 
+                 << "): scalar " << out_scalar_rate << " MB/s, kernel " << out_kernel_rate << " MB/s";
+
+    if(!same_output)
     {
-        static_manage_error( m_cam, deb, "Cannot release the wait handle", err, "dcamwait_close");
+        THROW_HW_ERROR(Error) << "The " << FrameCopy::getKernelName() << " unpack kernel output differs from the scalar unpack!";
     }
-    
-    wait_handle = NULL;
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::abortCapture()
-// Stop the capture, releasing the Wait handle and setting the boolean stop flag.
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::abortCapture(void)
+//=============================================================================
+// DCAM RING BUFFER
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Enable the automatic DCAM ring depth.
+/// The depth is computed at each acquisition from the DCAM frame size, the 
+/// predicted frame rate, the memory budget and the latency tolerance.
+//-----------------------------------------------------------------------------
+void Camera::setRingAutoSizeEnabled(const bool in_enabled) ///< [in] true to compute the DCAM ring depth at each acquisition
 {
     DEB_MEMBER_FUNCT();
+    m_ring_auto_size = in_enabled;
+}
 
-    DCAMERR err = DCAMERR_NONE;
+//-----------------------------------------------------------------------------
+/// Get the automatic DCAM ring depth activation state
+//-----------------------------------------------------------------------------
+bool Camera::getRingAutoSizeEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_ring_auto_size;
+}
 
-    m_cam->m_mutex_force_stop.lock();
+//-----------------------------------------------------------------------------
+/// Set the DCAM ring depth used when the automatic size is disabled
+//-----------------------------------------------------------------------------
+void Camera::setRingDepth(const int in_depth) ///< [in] DCAM ring depth used when the automatic size is disabled
+{
+    DEB_MEMBER_FUNCT();
 
-    if(m_wait_handle != NULL)
+    if(in_depth < 1)
     {
-        err = dcamwait_abort( m_wait_handle );
+        THROW_HW_ERROR(Error) << "Incorrect DCAM ring depth: " << in_depth;
     }
 
-    if( failed(err) )
+    m_frame_buffer_size = in_depth;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the maximum memory of the DCAM ring in automatic size mode
+//-----------------------------------------------------------------------------
+void Camera::setRingMemoryBudget(const double in_budget) ///< [in] maximum memory of the DCAM ring (MB)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(in_budget <= 0.0)
     {
-        static_manage_error( m_cam, deb, "Cannot abort wait handle.", err, "dcamwait_abort");
+        THROW_HW_ERROR(Error) << "Incorrect DCAM ring memory budget: " << in_budget;
     }
 
-    m_force_stop = true;
-    m_cam->m_mutex_force_stop.unlock();
+    m_ring_memory_budget = in_budget;
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::getTransfertInfo()
-// throws an exception in case of problem
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::getTransfertInfo(int32 & frame_index,
-                                            int32 & frame_count)
+//-----------------------------------------------------------------------------
+/// Get the maximum memory of the DCAM ring in automatic size mode (MB)
+//-----------------------------------------------------------------------------
+double Camera::getRingMemoryBudget(void)
 {
     DEB_MEMBER_FUNCT();
+    return m_ring_memory_budget;
+}
 
-    DCAMERR err;
+//-----------------------------------------------------------------------------
+/// Set the duration of acquisition thread stall the DCAM ring must absorb
+/// without losing frames in automatic size mode
+//-----------------------------------------------------------------------------
+void Camera::setRingLatencyTolerance(const double in_latency) ///< [in] acquisition thread stall the DCAM ring must absorb (s)
+{
+    DEB_MEMBER_FUNCT();
 
-    // transferinfo param
-    DCAMCAP_TRANSFERINFO transferinfo;
-    memset( &transferinfo, 0, sizeof(DCAMCAP_TRANSFERINFO) );
-    transferinfo.size = sizeof(DCAMCAP_TRANSFERINFO);
+    if(in_latency <= 0.0)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect DCAM ring latency tolerance: " << in_latency;
+    }
 
-    // get number of captured images
-    err = dcamcap_transferinfo( m_cam->m_camera_handle, &transferinfo );
+    m_ring_latency = in_latency;
+}
 
-    if( failed(err) )
-    {
-        setStatus(CameraThread::Fault);
+//-----------------------------------------------------------------------------
+/// Get the latency tolerance of the DCAM ring in automatic size mode (s)
+//-----------------------------------------------------------------------------
+double Camera::getRingLatencyTolerance(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_ring_latency;
+}
 
-        static_manage_error( m_cam, deb, "Cannot get transfer info.", err, "dcamcap_transferinfo");
-        THROW_HW_ERROR(Error) << "Cannot get transfer info.";
-    }
-    else
-    {
-        frame_index = transferinfo.nNewestFrameIndex;
-        frame_count = transferinfo.nFrameCount      ;
-    }
+//-----------------------------------------------------------------------------
+/// Get the DCAM ring depth of the current (or latest) acquisition
+//-----------------------------------------------------------------------------
+int Camera::getRingDepth(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getRingSize();
 }
 
-//---------------------------------------------------------------------------------------
-//! Camera::CameraThread::execStartAcq()
-//---------------------------------------------------------------------------------------
-void Camera::CameraThread::execStartAcq()
+//-----------------------------------------------------------------------------
+/// Get the maximum number of DCAM frames waiting to be copied during the 
+/// current (or latest) acquisition
+//-----------------------------------------------------------------------------
+int Camera::getRingHighWaterMark(void)
 {
     DEB_MEMBER_FUNCT();
+    return m_thread.getRingHighWater();
+}
 
-    DCAMERR   err          = DCAMERR_NONE;
-    bool      continue_acq = true        ;
-    Timestamp T0    = Timestamp::now();
-    Timestamp T1    = Timestamp::now();
-    Timestamp DeltaT;
-    long      status;
+//=============================================================================
+// HARDWARE STAMPS
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Check if the camera gives a timestamp with each frame
+//-----------------------------------------------------------------------------
+bool Camera::getHwTimestampSupported(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_hw_timestamp_supported;
+}
 
-    DEB_TRACE() << m_cam->g_trace_line_separator.c_str();
-    DEB_TRACE() << "CameraThread::execStartAcq - BEGIN";
-    setStatus(CameraThread::Exposure);
+//-----------------------------------------------------------------------------
+/// Check if the camera gives a framestamp with each frame
+//-----------------------------------------------------------------------------
+bool Camera::getHwFramestampSupported(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_hw_framestamp_supported;
+}
 
-    // Allocate frames to capture
-    err = dcambuf_alloc( m_cam->m_camera_handle, m_cam->m_frame_buffer_size );
+//-----------------------------------------------------------------------------
+/// Timestamp the lima frames with the DCAM timestamps (converted to the host
+/// clock) instead of the time the acquisition thread processes them.
+//-----------------------------------------------------------------------------
+void Camera::setHwTimestampEnabled(const bool in_enabled) ///< [in] true to timestamp the frames with the DCAM timestamps
+{
+    DEB_MEMBER_FUNCT();
+    m_hw_timestamp_enabled = in_enabled;
+}
 
-    if( failed(err) )
-    {
-        std::string errorText = static_manage_error( m_cam, deb, "Failed to allocate frames for the capture", err, 
-                                                     "dcambuf_alloc", "number_of_buffer=%d",m_cam->m_frame_buffer_size);
-        REPORT_EVENT(errorText);
-        THROW_HW_ERROR(Error) << "Cannot allocate frame for capturing (dcam_allocframe()).";
-    }
-    else
-    {
-        DEB_ALWAYS() << "Allocated frames: " << m_cam->m_frame_buffer_size;
-    }
+//-----------------------------------------------------------------------------
+/// Get the hardware timestamp activation state
+//-----------------------------------------------------------------------------
+bool Camera::getHwTimestampEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_hw_timestamp_enabled;
+}
 
-    // --- check first the acquisition is idle
-    err = dcamcap_status( m_cam->m_camera_handle, &status );
-    if( failed(err) )
-    {
-        std::string errorText = static_manage_error( m_cam, deb, "Cannot get camera status", err, "dcamcap_status");
-        REPORT_EVENT(errorText);
-        THROW_HW_ERROR(Error) << "Cannot get camera status!";
-    }
+//-----------------------------------------------------------------------------
+/// Get the offset between the host clock and the DCAM clock measured during
+/// the current (or latest) acquisition (s)
+//-----------------------------------------------------------------------------
+double Camera::getHwClockOffset(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    double offset;
 
-    if (DCAMCAP_STATUS_READY != status)
+    if(!m_thread.getClockOffset(offset))
     {
-        DEB_ERROR() << "Cannot start acquisition, camera is not ready";
-        THROW_HW_ERROR(Error) << "Cannot start acquisition, camera is not ready";
+        THROW_HW_ERROR(Error) << "The clock offset was not measured yet";
     }
 
-    StdBufferCbMgr& buffer_mgr = m_cam->m_buffer_ctrl_obj.getBuffer();
-    buffer_mgr.setStartTimestamp(Timestamp::now());
-
-    DEB_TRACE() << "Run";
+    return offset;
+}
 
-    // Write some informations about the camera before the acquisition
-    bool ViewModeEnabled;
-    m_cam->getViewMode(ViewModeEnabled);
+//-----------------------------------------------------------------------------
+/// Get the hardware stamps of one of the latest frames
+//-----------------------------------------------------------------------------
+void Camera::getFrameStamps(const int in_frame_nb     , ///< [in]  lima frame number
+                            int &     out_framestamp  , ///< [out] DCAM framestamp of the frame
+                            double &  out_hw_timestamp) ///< [out] DCAM timestamp of the frame, in host clock (s)
+{
+    DEB_MEMBER_FUNCT();
 
-    if(ViewModeEnabled)
+    if(in_frame_nb < 0)
     {
-        DEB_TRACE() << "View mode activated";
+        THROW_HW_ERROR(Error) << "Incorrect frame number: " << in_frame_nb;
+    }
 
-        int    view_index   = 0;
-        double view_exposure;
+    CameraThread::FrameStamps stamps;
 
-        while(view_index < m_cam->m_max_views)
-        {
-            m_cam->getViewExpTime(view_index, view_exposure);
-            DEB_TRACE() << "View " << (view_index+1) << " exposure : " << view_exposure;
-            view_index++;
-        }
-    }
-    else
+    if(!m_thread.getFrameStamps(in_frame_nb, stamps))
     {
-        DEB_TRACE() << "View mode unactivated";
-        double exposure;
-
-        m_cam->getExpTime(exposure);
-        DEB_TRACE() << "exposure : " << exposure;
+        THROW_HW_ERROR(Error) << "No hardware stamps for the frame " << in_frame_nb << " (too old or not acquired yet)";
     }
 
-    // Check the status and stop capturing if capturing is already started.
-    checkStatusBeforeCapturing();
+    out_framestamp   = stamps.framestamp;
+    out_hw_timestamp = stamps.timestamp ;
+}
 
-    // Create the wait handle
-    createWaitHandle(m_wait_handle);
+//-----------------------------------------------------------------------------
+/// Set the behaviour when hardware frames are lost. 
+/// The placeholder policy is not possible in zero-copy mode (the copy mode is used).
+//-----------------------------------------------------------------------------
+void Camera::setOverrunPolicy(const Overrun_Policy in_policy) ///< [in] behaviour when hardware frames are lost
+{
+    DEB_MEMBER_FUNCT();
+
+    if((in_policy != Overrun_Policy_Stop) && (in_policy != Overrun_Policy_Skip) && (in_policy != Overrun_Policy_Placeholder))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect overrun policy: " << static_cast<int>(in_policy);
+    }
+
+    m_overrun_policy = in_policy;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the behaviour when hardware frames are lost
+//-----------------------------------------------------------------------------
+enum Camera::Overrun_Policy Camera::getOverrunPolicy(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_overrun_policy;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the hardware frames lost during the current (or latest) acquisition.
+/// The lost frames are found from the framestamps if the camera gives them,
+/// from the DCAM frame count otherwise (only the ring overruns are seen).
+//-----------------------------------------------------------------------------
+void Camera::getFrameGaps(std::vector<FrameGap> & out_gaps) ///< [out] lost hardware frames of the current (or latest) acquisition
+{
+    DEB_MEMBER_FUNCT();
+
+    m_thread.getFrameGaps(out_gaps);
+}
+
+//-----------------------------------------------------------------------------
+/// Get the software trigger to frame latencies of the current (or latest)
+/// IntTrigMult acquisition: time between the dcamcap_firetrigger call and the
+/// return of the wait which gave the frame.
+//-----------------------------------------------------------------------------
+void Camera::getTriggerLatency(TriggerLatency & out_latency) ///< [out] software trigger to frame latencies of the current (or latest) acquisition
+{
+    DEB_MEMBER_FUNCT();
+
+    m_thread.getTriggerLatency(out_latency);
+}
+
+//=============================================================================
+// ACCUMULATION
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Set the number of consecutive hardware images summed by the acquisition 
+/// thread in each lima frame, when the image type is Bpp32 (sums) or Bpp32F
+/// (means). The lima frames count the accumulated frames. The images of a
+/// frame are the hardware images [n * nb_frames, (n + 1) * nb_frames[: a frame
+/// with lost images has less images (see getAccumulationInfo), a frame 
+/// partially summed at the acquisition stop is not given.
+//-----------------------------------------------------------------------------
+void Camera::setAccumulationNbFrames(const int in_nb_frames) ///< [in] hardware images summed in each Bpp32/Bpp32F frame
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_nb_frames);
+
+    if((in_nb_frames < 1) || (in_nb_frames > g_accumulation_max_frames))
+    {
+        THROW_HW_ERROR(Error) << "Invalid number of accumulated frames " << in_nb_frames << " (1 to " << g_accumulation_max_frames << ")";
+    }
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the accumulation during an acquisition!";
+    }
+
+    m_accumulation_nb_frames = in_nb_frames;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of hardware images summed in each Bpp32/Bpp32F frame
+//-----------------------------------------------------------------------------
+int Camera::getAccumulationNbFrames(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_accumulation_nb_frames;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the content of a recent lima frame: number of hardware images summed
+/// in it, saturated pixels found in these images and total exposure time.
+//-----------------------------------------------------------------------------
+void Camera::getAccumulationInfo(const int in_frame_nb     , ///< [in]  lima frame number
+                                 int &     out_nb_images   , ///< [out] hardware images summed in the frame
+                                 long &    out_nb_saturated, ///< [out] saturated pixels found in these images
+                                 double &  out_exposure    ) ///< [out] total exposure time of the frame (s)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(in_frame_nb < 0)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect frame number: " << in_frame_nb;
+    }
+
+    CameraThread::FrameStamps stamps;
+
+    if(!m_thread.getFrameStamps(in_frame_nb, stamps))
+    {
+        THROW_HW_ERROR(Error) << "No information for the frame " << in_frame_nb << " (too old or not acquired yet)";
+    }
+
+    out_nb_images    = stamps.nb_images   ;
+    out_nb_saturated = stamps.nb_saturated;
+    out_exposure     = stamps.nb_images * m_thread.getAccExposure();
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the status of the latest acquisition was driven by the DCAM 
+/// exposure end events (the status is only an approximation otherwise)
+//-----------------------------------------------------------------------------
+bool Camera::getExposureEventsSupported(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getExposureEvents();
+}
+
+//-----------------------------------------------------------------------------
+/// Set the use of the DCAM exposure end events. The events wake the thread up
+/// at each exposure, so by default they are only used in the trigger per frame 
+/// modes without frame bundle (the status is only an approximation otherwise).
+//-----------------------------------------------------------------------------
+void Camera::setExposureEventsMode(const Exposure_Events_Mode in_mode) ///< [in] use of the DCAM exposure end events
+{
+    DEB_MEMBER_FUNCT();
+
+    if((in_mode != Exposure_Events_Auto) && (in_mode != Exposure_Events_On) && (in_mode != Exposure_Events_Off))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect exposure events mode: " << static_cast<int>(in_mode);
+    }
+
+    m_exposure_events_mode = in_mode;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the use of the DCAM exposure end events
+//-----------------------------------------------------------------------------
+enum Camera::Exposure_Events_Mode Camera::getExposureEventsMode(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_exposure_events_mode;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the host time of the latest exposure end of the acquisition 
+/// (see Timestamp::now()) and the number of exposure ends.
+//-----------------------------------------------------------------------------
+void Camera::getLastExposureEnd(double & out_timestamp   , ///< [out] host time of the latest exposure end (s, 0 if none)
+                                int &    out_nb_exposures) ///< [out] number of exposure ends since the acquisition start
+{
+    DEB_MEMBER_FUNCT();
+
+    m_thread.getExposureEnds(out_timestamp, out_nb_exposures);
+}
+
+//=============================================================================
+// LATENCY RECORDS
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Enable the per-frame latency records of the next acquisitions.
+/// Disabled, the acquisition loop only tests a flag.
+//-----------------------------------------------------------------------------
+void Camera::setLatencyRecordEnabled(const bool in_enabled) ///< [in] true to record the per-frame latencies of the next acquisitions
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the latency records during an acquisition!";
+    }
+
+    m_thread.setLatencyRecordEnabled(in_enabled);
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the per-frame latencies are recorded
+//-----------------------------------------------------------------------------
+bool Camera::getLatencyRecordEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getLatencyRecordEnabled();
+}
+
+//-----------------------------------------------------------------------------
+/// Set the number of latency records (the latest frames of the acquisition are kept).
+/// The records are allocated here, never during an acquisition.
+//-----------------------------------------------------------------------------
+void Camera::setLatencyRecordSize(const int in_nb_records) ///< [in] number of frames kept (rounded up to a power of two)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the latency records during an acquisition!";
+    }
+
+    m_thread.setLatencyRecordSize(in_nb_records);
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of latency records
+//-----------------------------------------------------------------------------
+int Camera::getLatencyRecordSize(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getLatencyRecordSize();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the latency between two stages of the frames of the latest acquisition
+/// (e.g. Stage_WaitReturn to Stage_Delivered for the whole plugin latency).
+/// During an acquisition, the result is only indicative.
+//-----------------------------------------------------------------------------
+void Camera::getLatencyStatistics(const LatencyRecorder::Stage in_from, ///< [in]  first stage
+                                  const LatencyRecorder::Stage in_to  , ///< [in]  last stage
+                                  int &    out_nb ,                     ///< [out] number of frames used
+                                  double & out_p50,                     ///< [out] median latency (s)
+                                  double & out_p99,                     ///< [out] 99th percentile latency (s)
+                                  double & out_max)                     ///< [out] maximum latency (s)
+{
+    DEB_MEMBER_FUNCT();
+
+    if((in_from < 0) || (in_to >= LatencyRecorder::Stage_Nb) || (in_from >= in_to))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect latency stages: " << in_from << " to " << in_to;
+    }
+
+    m_thread.getLatencyStatistics(in_from, in_to, out_nb, out_p50, out_p99, out_max);
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of DCAM frames waiting in the ring each time the acquisition
+/// thread found new frames, over the frames of the latest acquisition
+//-----------------------------------------------------------------------------
+void Camera::getQueueDepthStatistics(int & out_p50, ///< [out] median number of DCAM frames waiting when a frame is found
+                                     int & out_p99, ///< [out] 99th percentile
+                                     int & out_max) ///< [out] maximum
+{
+    DEB_MEMBER_FUNCT();
+    m_thread.getQueueDepthStatistics(out_p50, out_p99, out_max);
+}
+
+//-----------------------------------------------------------------------------
+/// Write the latency records of the latest acquisition in a CSV file
+//-----------------------------------------------------------------------------
+void Camera::dumpLatencyRecords(const std::string & in_file_name) ///< [in] path of the CSV file to write
+{
+    DEB_MEMBER_FUNCT();
+    m_thread.dumpLatencyRecords(in_file_name);
+}
+
+//=============================================================================
+// ROLLING METRICS
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Set the time covered by the rolling metrics (0.1 to 60 s)
+//-----------------------------------------------------------------------------
+void Camera::setMetricsWindow(const double in_window) ///< [in] time covered by the rolling metrics (s)
+{
+    DEB_MEMBER_FUNCT();
+    m_thread.setMetricsWindow(in_window);
+}
+
+//-----------------------------------------------------------------------------
+/// Get the time covered by the rolling metrics
+//-----------------------------------------------------------------------------
+double Camera::getMetricsWindow(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getMetricsWindow();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the frame rate, throughput, DCAM ring occupancy, wake-up jitter and 
+/// lost frame rate over the latest window. During an acquisition the window
+/// ends now, so a stall of the acquisition is visible. Afterwards it ends at
+/// the end of the latest acquisition.
+//-----------------------------------------------------------------------------
+void Camera::getRollingMetrics(RollingMetrics::Values & out_metrics) ///< [out] metrics of the latest window
+{
+    DEB_MEMBER_FUNCT();
+    m_thread.getMetrics(out_metrics);
+}
+
+//=============================================================================
+// ACQUISITION THREAD SETTINGS
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Set the scheduling priority of the acquisition thread (applied at the next 
+/// acquisition start)
+//-----------------------------------------------------------------------------
+void Camera::setAcqThreadPriority(const SystemTuning::Priority in_priority) ///< [in] scheduling priority of the acquisition thread
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_priority);
+
+    if((in_priority < SystemTuning::Priority_Normal) || (in_priority > SystemTuning::Priority_Realtime))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect acquisition thread priority: " << in_priority;
+    }
+
+    m_acq_thread_priority = in_priority;
+    m_thread.setThreadSettingsChanged();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the scheduling priority requested for the acquisition thread
+//-----------------------------------------------------------------------------
+SystemTuning::Priority Camera::getAcqThreadPriority(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_acq_thread_priority;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the cpus of the acquisition thread (applied at the next acquisition start).
+/// Without cpus, the thread runs on the cpus of the NUMA node if one is set.
+//-----------------------------------------------------------------------------
+void Camera::setAcqThreadCpus(const std::vector<int> & in_cpus) ///< [in] cpus of the acquisition thread (empty: all, or the NUMA node cpus)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(SystemTuning::getCpusText(in_cpus));
+
+    for(size_t cpu_index = 0 ; cpu_index < in_cpus.size() ; cpu_index++)
+    {
+        if(in_cpus[cpu_index] < 0)
+        {
+            THROW_HW_ERROR(Error) << "Incorrect cpu: " << in_cpus[cpu_index];
+        }
+    }
+
+    m_acq_thread_cpus = in_cpus;
+    m_thread.setThreadSettingsChanged();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the cpus set for the acquisition thread
+//-----------------------------------------------------------------------------
+void Camera::getAcqThreadCpus(std::vector<int> & out_cpus) ///< [out] cpus of the acquisition thread set by setAcqThreadCpus
+{
+    DEB_MEMBER_FUNCT();
+    out_cpus = m_acq_thread_cpus;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the NUMA node of the frame grabber. The lima buffers are prefaulted from
+/// the node cpus in prepareAcq, and the acquisition thread runs on the node cpus
+/// (unless setAcqThreadCpus gives other cpus).
+//-----------------------------------------------------------------------------
+void Camera::setNumaNode(const int in_node) ///< [in] NUMA node of the frame grabber (-1: none)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_node);
+
+    // checks the node
+    if(in_node >= 0)
+        SystemTuning::getNumaNodeCpus(in_node);
+
+    m_numa_node = (in_node >= 0) ? in_node : -1;
+    m_thread.setThreadSettingsChanged();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the NUMA node of the frame grabber
+//-----------------------------------------------------------------------------
+int Camera::getNumaNode(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_numa_node;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the effective priority and cpus of the acquisition thread, as reported 
+/// by the system at startup or at the latest change
+//-----------------------------------------------------------------------------
+std::string Camera::getAcqThreadSettings(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    std::string settings;
+    m_thread.getThreadSettings(settings);
+    return settings;
+}
+
+//=============================================================================
+// LIMA BUFFERS PREFAULT
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Enable the prefault of the lima buffers in prepareAcq: every page is 
+/// touched before the first exposure instead of in the copy of its first frame.
+//-----------------------------------------------------------------------------
+void Camera::setBufferPrefaultEnabled(const bool in_enabled) ///< [in] true to touch the lima buffers in prepareAcq
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    m_buffer_prefault = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the lima buffers are prefaulted in prepareAcq
+//-----------------------------------------------------------------------------
+bool Camera::getBufferPrefaultEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_buffer_prefault;
+}
+
+//-----------------------------------------------------------------------------
+/// Enable the lock of the lima buffers in physical memory in prepareAcq 
+/// (implies the prefault). The pages stay locked until lima frees the buffers.
+//-----------------------------------------------------------------------------
+void Camera::setBufferLockEnabled(const bool in_enabled) ///< [in] true to lock the lima buffers in physical memory
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    m_buffer_lock = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the lima buffers are locked in prepareAcq
+//-----------------------------------------------------------------------------
+bool Camera::getBufferLockEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_buffer_lock;
+}
+
+//-----------------------------------------------------------------------------
+/// Ask for huge pages behind the lima buffers in prepareAcq (implies the 
+/// prefault). Only effective with the transparent huge pages of Linux: the
+/// buffers are allocated by lima, and Windows only gives large pages to 
+/// a new allocation.
+//-----------------------------------------------------------------------------
+void Camera::setBufferHugePagesEnabled(const bool in_enabled) ///< [in] true to ask for huge pages behind the lima buffers
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    m_buffer_huge_pages = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if huge pages are asked for the lima buffers
+//-----------------------------------------------------------------------------
+bool Camera::getBufferHugePagesEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_buffer_huge_pages;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the memory of the lima buffers actually locked by the latest prefault
+//-----------------------------------------------------------------------------
+double Camera::getBufferLockedSize(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getLockedSize();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the NUMA node actually holding the lima buffers after the latest 
+/// prefault (-1 if unknown)
+//-----------------------------------------------------------------------------
+int Camera::getBufferNumaNode(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.getBuffersNode();
+}
+
+//=============================================================================
+// PACKED TRANSFER
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Transfer the pixels as 12 bits packed (DCAM_PIXELTYPE_MONO12P), which cuts
+/// the link bandwidth by 25%. The plugin unpacks the frames to 16 bits, lima 
+/// still receives Bpp16 images. Zero-copy is not possible in this mode.
+//-----------------------------------------------------------------------------
+void Camera::setPackedTransferEnabled(const bool in_enabled) ///< [in] true to transfer 12 bits packed pixels
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the pixel transfer during an acquisition!";
+    }
+
+    if(in_enabled && (m_depth != 16))
+    {
+        THROW_HW_ERROR(Error) << "Packed transfer is only possible with 16 bits images!";
+    }
+
+    m_thread.releasePreparedBuffers(); // the image layout changes
+
+    dcamex_setimagepixeltype( m_camera_handle, (in_enabled) ? DCAM_PIXELTYPE_MONO12P : DCAM_PIXELTYPE_MONO16);
+    m_packed_transfer = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the pixels are transferred as 12 bits packed
+//-----------------------------------------------------------------------------
+bool Camera::getPackedTransferEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_packed_transfer;
+}
+
+//=============================================================================
+// 8 BITS WINDOW
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Select which 8 of the 16 bits are kept in Bpp8: bits [shift, shift + 7], 
+/// the pixels above the window are saturated to 255. With -1 (default), the 
+/// camera gives its own 8 bits pixels (DCAM_PIXELTYPE_MONO8), or the 8 most
+/// significant bits of the sensor if it cannot. A window is applied by the
+/// copy on 16 bits transfers, so zero-copy is not possible with it.
+//-----------------------------------------------------------------------------
+void Camera::setBitWindow(const int in_shift) ///< [in] lowest bit of the 8 bits window in Bpp8 (-1: selected by the camera)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_shift);
+
+    if((in_shift < -1) || (in_shift > 8))
+    {
+        THROW_HW_ERROR(Error) << "Invalid bit window " << in_shift << ", the lowest bit must be in [0...8] (or -1 for the camera choice)";
+    }
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the bit window during an acquisition!";
+    }
+
+    m_bit_window = in_shift;
+
+    if(m_depth == 8)
+    {
+        m_thread.releasePreparedBuffers(); // the image layout changes
+        applyImagePixelType();
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Get the lowest bit of the 8 bits window (-1: selected by the camera)
+//-----------------------------------------------------------------------------
+int Camera::getBitWindow(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_bit_window;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the 8 bits pixels are made by the copy from 16 bits transfers
+//-----------------------------------------------------------------------------
+bool Camera::getBitWindowInSoftware(void)
+{
+    DEB_MEMBER_FUNCT();
+    return (m_soft_bit_shift >= 0);
+}
+
+//=============================================================================
+// DCAM RECORDING
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Record the next acquisitions with the DCAM recorder (dcamcap_record): the
+/// driver writes the frames of the DCAM ring in a .dcimg file, without the 
+/// lima saving chain. Lima only receives the live images (see 
+/// setRecordingLiveDecimation). Zero-copy is not possible while recording.
+//-----------------------------------------------------------------------------
+void Camera::setRecordingEnabled(const bool in_enabled) ///< [in] true to record the next acquisitions with the DCAM recorder
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the recording mode during an acquisition!";
+    }
+
+    m_thread.releasePreparedBuffers(); // the DCAM ring can change (zero-copy)
+    m_recording_enabled = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the acquisitions are recorded by the DCAM recorder
+//-----------------------------------------------------------------------------
+bool Camera::getRecordingEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_recording_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the path of the recorder files. Each acquisition creates the file
+/// <path>_<index>.dcimg
+//-----------------------------------------------------------------------------
+void Camera::setRecordingPath(const std::string & in_path) ///< [in] recorder files path, without extension
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_path);
+
+    if(in_path.empty())
+    {
+        THROW_HW_ERROR(Error) << "The recording path cannot be empty!";
+    }
+
+    m_recording_path = in_path;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the path of the recorder files
+//-----------------------------------------------------------------------------
+std::string Camera::getRecordingPath(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_recording_path;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the size of the recorder file of a continuous acquisition (number of
+/// frames = 0). The acquisition stops when the file is full.
+//-----------------------------------------------------------------------------
+void Camera::setRecordingMaxFrames(const int in_nb_frames) ///< [in] recorder file size in DCAM frames for the continuous acquisitions
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_nb_frames);
+
+    if(in_nb_frames < 1)
+    {
+        THROW_HW_ERROR(Error) << "Invalid recorder file size " << in_nb_frames << " (at least one frame)";
+    }
+
+    m_recording_max_frames = in_nb_frames;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the size of the recorder file of a continuous acquisition
+//-----------------------------------------------------------------------------
+int Camera::getRecordingMaxFrames(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_recording_max_frames;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the live images given to lima while recording: one image out of 
+/// in_decimation (1: all the images, 0: none). The lima numbering stays 
+/// consecutive and the number of frames of the acquisition counts the lima 
+/// frames (without live images, only a continuous acquisition is possible).
+//-----------------------------------------------------------------------------
+void Camera::setRecordingLiveDecimation(const int in_decimation) ///< [in] one image out of in_decimation given to lima while recording (0: none)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_decimation);
+
+    if(in_decimation < 0)
+    {
+        THROW_HW_ERROR(Error) << "Invalid live decimation " << in_decimation;
+    }
+
+    m_recording_decimation = in_decimation;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the live images decimation used while recording
+//-----------------------------------------------------------------------------
+int Camera::getRecordingLiveDecimation(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_recording_decimation;
+}
+
+//=============================================================================
+// LIVE DECIMATION
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Give only one hardware image out of in_decimation to lima (used by the 
+/// next acquisitions, without the DCAM recorder which has its own decimation).
+/// Every hardware image is still accounted (numbering, lost frames, stamps,
+/// raw writer), the lima numbering stays consecutive and the number of frames
+/// of the acquisition counts the lima frames: the acquisition ends with the 
+/// hardware image of the last lima frame. Zero-copy is not possible with a
+/// decimated delivery.
+//-----------------------------------------------------------------------------
+void Camera::setLiveDecimation(const int in_decimation) ///< [in] one hardware image out of in_decimation given to lima (1: all)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_decimation);
+
+    if(in_decimation < 1)
+    {
+        THROW_HW_ERROR(Error) << "Invalid live decimation " << in_decimation << " (at least 1)";
+    }
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the live decimation during an acquisition!";
+    }
+
+    m_thread.releasePreparedBuffers(); // the DCAM ring can change (zero-copy)
+    m_live_decimation = in_decimation;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the live decimation (one hardware image out of n given to lima)
+//-----------------------------------------------------------------------------
+int Camera::getLiveDecimation(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_live_decimation;
+}
+
+//-----------------------------------------------------------------------------
+/// Give at most in_rate images per second to lima (used by the next 
+/// acquisitions, also with the DCAM recorder), on top of the decimation.
+/// The images are spaced on the host time of their arrival.
+//-----------------------------------------------------------------------------
+void Camera::setLiveMaxFrameRate(const double in_rate) ///< [in] maximum number of images given to lima per second (0: no limit)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_rate);
+
+    if(in_rate < 0.0)
+    {
+        THROW_HW_ERROR(Error) << "Invalid live frame rate " << in_rate;
+    }
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the live frame rate during an acquisition!";
+    }
+
+    m_thread.releasePreparedBuffers(); // the DCAM ring can change (zero-copy)
+    m_live_max_rate = in_rate;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the maximum number of images given to lima per second (0: no limit)
+//-----------------------------------------------------------------------------
+double Camera::getLiveMaxFrameRate(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_live_max_rate;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the recorder state of the current (or latest) acquisition: written 
+/// and missed frames, throughput and disk errors.
+//-----------------------------------------------------------------------------
+void Camera::getRecordingStatus(RecordingStatus & out_status) ///< [out] recorder state of the current (or latest) acquisition
+{
+    DEB_MEMBER_FUNCT();
+    m_thread.getRecordingStatus(out_status);
+}
+
+//=============================================================================
+// RAW WRITER
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Stream the raw frames of the next acquisitions to disk, out of the lima
+/// saving chain: each hardware image is copied in a writer slot and appended
+/// by a writer thread to <path>_<index>_<nnnn>.raw, with an index file 
+/// <path>_<index>.idx (frame number, timestamp and position of each frame).
+/// The acquisition is never blocked: a frame is dropped if the writer is late.
+//-----------------------------------------------------------------------------
+void Camera::setRawWriterEnabled(const bool in_enabled) ///< [in] true to stream the raw frames of the next acquisitions to disk
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the raw writer mode during an acquisition!";
+    }
+
+    m_raw_writer_enabled = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the raw frames of the acquisitions are streamed to disk
+//-----------------------------------------------------------------------------
+bool Camera::getRawWriterEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_raw_writer_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the path of the raw stream files (used by the next acquisition)
+//-----------------------------------------------------------------------------
+void Camera::setRawWriterPath(const std::string & in_path) ///< [in] raw stream files path, without extension
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_path);
+
+    if(in_path.empty())
+    {
+        THROW_HW_ERROR(Error) << "The raw writer path cannot be empty!";
+    }
+
+    m_raw_writer_path = in_path;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the path of the raw stream files
+//-----------------------------------------------------------------------------
+std::string Camera::getRawWriterPath(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_raw_writer_path;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the size of a raw data file (used by the next acquisition). The 
+/// writer goes to the next file when a file is full.
+//-----------------------------------------------------------------------------
+void Camera::setRawWriterFileSize(const long long in_size) ///< [in] size of a raw data file (bytes)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_size);
+
+    if(in_size <= 0)
+    {
+        THROW_HW_ERROR(Error) << "Invalid raw data file size " << in_size;
+    }
+
+    m_raw_writer_file_size = in_size;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the size of a raw data file
+//-----------------------------------------------------------------------------
+long long Camera::getRawWriterFileSize(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_raw_writer_file_size;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the number of frames the raw writer can hold before dropping frames
+/// (used by the next acquisition)
+//-----------------------------------------------------------------------------
+void Camera::setRawWriterSlots(const int in_nb_slots) ///< [in] number of frames the raw writer can hold
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_nb_slots);
+
+    if(in_nb_slots < 1)
+    {
+        THROW_HW_ERROR(Error) << "Invalid number of raw writer slots " << in_nb_slots;
+    }
+
+    m_raw_writer_slots = in_nb_slots;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of frames the raw writer can hold
+//-----------------------------------------------------------------------------
+int Camera::getRawWriterSlots(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_raw_writer_slots;
+}
+
+//-----------------------------------------------------------------------------
+/// Bypass the system cache for the raw data files (used by the next 
+/// acquisition). Buffered writes are used if the file system refuses it.
+//-----------------------------------------------------------------------------
+void Camera::setRawWriterDirectIo(const bool in_enabled) ///< [in] true to bypass the system cache for the raw data files
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    m_raw_writer_direct_io = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the system cache is bypassed for the raw data files
+//-----------------------------------------------------------------------------
+bool Camera::getRawWriterDirectIo(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_raw_writer_direct_io;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the raw stream state of the current (or latest) acquisition: written
+/// and dropped frames, writer queue high water mark, throughput and errors.
+//-----------------------------------------------------------------------------
+void Camera::getRawWriterStatus(RawWriter::Status & out_status) ///< [out] raw stream state of the current (or latest) acquisition
+{
+    DEB_MEMBER_FUNCT();
+    m_thread.getRawWriterStatus(out_status);
+}
+
+//=============================================================================
+// LATEST FRAME SNAPSHOT
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Keep the latest hardware image of the next acquisitions out of the lima
+/// buffers, for the viewers (see getLatestFrame). The acquisition thread 
+/// copies an image at most setSnapshotMaxRate times per second and never 
+/// waits for the readers.
+//-----------------------------------------------------------------------------
+void Camera::setSnapshotEnabled(const bool in_enabled) ///< [in] true to keep the latest frame of the next acquisitions out of the lima buffers
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the snapshot mode during an acquisition!";
+    }
+
+    m_snapshot_enabled = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the latest frame of the acquisitions is kept out of the lima buffers
+//-----------------------------------------------------------------------------
+bool Camera::getSnapshotEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_snapshot_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the maximum number of snapshot updates per second (used by the next 
+/// acquisition). Each update is a copy of a frame by the acquisition thread.
+//-----------------------------------------------------------------------------
+void Camera::setSnapshotMaxRate(const double in_rate) ///< [in] maximum number of snapshot updates per second (0: every frame)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_rate);
+
+    if(in_rate < 0.0)
+    {
+        THROW_HW_ERROR(Error) << "Invalid snapshot rate " << in_rate;
+    }
+
+    m_snapshot_max_rate = in_rate;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the maximum number of snapshot updates per second
+//-----------------------------------------------------------------------------
+double Camera::getSnapshotMaxRate(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_snapshot_max_rate;
+}
+
+//-----------------------------------------------------------------------------
+/// Get a copy of the latest frame of the current (or latest) acquisition, 
+/// with its hardware image number and timestamp. Can be called at any time
+/// by several clients, the acquisition is never blocked.
+/// @return false if no frame was received yet
+//-----------------------------------------------------------------------------
+bool Camera::getLatestFrame(FrameSnapshot::Info & out_info, ///< [out] stamps of the latest frame
+                            std::vector<char>   & out_data) ///< [out] pixels of the latest frame
+{
+    DEB_MEMBER_FUNCT();
+    return m_thread.readSnapshot(out_info, out_data);
+}
+
+//-----------------------------------------------------------------------------
+/// CAPTURE
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+/// Set detector for single image acquisition
+//-----------------------------------------------------------------------------
+void Camera::prepareAcq()
+{
+    DEB_MEMBER_FUNCT();
+
+    Timestamp t0 = Timestamp::now();
+
+    traceAllRoi();
+
+    // allocation of the DCAM ring and creation of the wait handle, so startAcq only starts the capture
+    m_thread.prepareCapture();
+
+    m_prepare_acq_time = Timestamp::now() - t0;
+    DEB_TRACE() << "prepareAcq time (s): " << m_prepare_acq_time;
+}
+
+//-----------------------------------------------------------------------------
+///  start the acquistion
+//-----------------------------------------------------------------------------
+void Camera::startAcq()
+{
+    DEB_MEMBER_FUNCT();
+    DEB_TRACE() << g_trace_line_separator.c_str();
+
+    // in IntTrigMult, the next startAcq calls of a running acquisition are the software triggers of its frames
+    if((m_trig_mode == IntTrigMult) && (m_thread.getStatus() != CameraThread::Ready) && (m_thread.getStatus() != CameraThread::Fault))
+    {
+        m_thread.fireSoftwareTrigger();
+        return;
+    }
+
+    m_start_acq_request = Timestamp::now();
+
+    m_image_number = 0;
+
+    // init force stop flag before starting acq thread
+    m_thread.m_force_stop = false;
+
+    m_thread.sendCmd      (CameraThread::StartAcq);
+    m_thread.waitNotStatus(CameraThread::Ready   );
+}
+
+//-----------------------------------------------------------------------------
+/// stop the acquisition
+//-----------------------------------------------------------------------------
+void Camera::stopAcq()
+{
+    DEB_MEMBER_FUNCT();
+    DEB_TRACE() << g_trace_line_separator.c_str();
+
+    Timestamp t0 = Timestamp::now();
+
+    execStopAcq();
+
+    if(m_thread.getStatus() != CameraThread::Fault)
+    {
+        // Wait for thread to finish
+        m_thread.waitStatus(CameraThread::Ready);
+    }
+    else
+    {
+        // aborting the thread
+        m_thread.abort();
+    }
+
+    m_stop_acq_time = Timestamp::now() - t0;
+    DEB_TRACE() << "stopAcq time (s): " << m_stop_acq_time;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the durations of the latest prepareAcq, startAcq and stopAcq calls
+//-----------------------------------------------------------------------------
+void Camera::getAcqTimings(double & out_prepare_time, ///< [out] duration of the latest prepareAcq (s)
+                           double & out_start_time  , ///< [out] duration of the latest startAcq until the capture start (s)
+                           double & out_stop_time   ) ///< [out] duration of the latest stopAcq (s)
+{
+    DEB_MEMBER_FUNCT();
+    out_prepare_time = m_prepare_acq_time;
+    out_start_time   = m_start_acq_time  ;
+    out_stop_time    = m_stop_acq_time   ;
+}
+
+//-----------------------------------------------------------------------------
+/// utility thread
+//-----------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::CameraThread()
+//---------------------------------------------------------------------------------------
+Camera::CameraThread::CameraThread(Camera * cam)
+: m_cam(cam)
+{
+    DEB_MEMBER_FUNCT();
+    m_force_stop = false;
+    m_wait_handle = NULL ;
+    m_ring_size   = 0    ;
+    m_ring_high_water = 0;
+    m_zero_copy   = false;
+    m_bundle_number   = 1;
+    m_bundle_rowbytes = 0;
+    m_bundle_step     = 0;
+    m_frame_number    = 0;
+    m_delivery_ok     = true;
+    m_buffers_allocated = false;
+    m_alloc_frame_bytes = 0.0  ;
+    m_alloc_row_bytes   = 0.0  ;
+    m_alloc_zero_copy   = false;
+    m_prepared          = false;
+    m_clock_offset       = 0.0  ;
+    m_clock_offset_valid = false;
+    m_last_timestamp     = 0.0  ;
+    m_frame_period       = 0.0  ;
+    m_next_hw_frame         = 0    ;
+    m_framestamp_base       = 0    ;
+    m_framestamp_base_valid = false;
+    m_wait_events           = 0    ;
+    m_exposure_events       = false;
+    m_nb_exposure_ends      = 0    ;
+    m_wait_time             = 0.0  ;
+    m_info_time             = 0.0  ;
+    m_queue_depth           = 0    ;
+    m_thread_settings_changed = false;
+    m_prefaulted_buffer     = NULL ;
+    m_prefaulted_nb         = 0    ;
+    m_prefaulted_size       = 0    ;
+    m_prefaulted_node       = -1   ;
+    m_buffers_node          = -1   ;
+    m_prefaulted_lock       = false;
+    m_conversion            = FrameCopy::Conversion_None;
+    m_bit_shift             = 0    ;
+    m_rec_handle            = NULL ;
+    m_rec_start_time        = 0.0  ;
+    m_rec_frame_bytes       = 0.0  ;
+    m_rec_index             = 0    ;
+    m_decimation            = 1    ;
+    m_max_delivery_rate     = 0.0  ;
+    m_next_delivery_time    = 0.0  ;
+    m_decimated             = false;
+    m_hw_images_done        = false;
+    m_nb_hw_images          = 0    ;
+    m_raw_index             = 0    ;
+    m_trigger_base          = 0    ;
+    m_snapshot_active       = false;
+    m_accumulating          = false;
+    m_saturation_level      = 0xFFFF;
+    m_acc_nb_frames         = 1    ;
+    m_acc_average           = false;
+    m_acc_group             = -1   ;
+    m_acc_count             = 0    ;
+    m_acc_saturated         = 0    ;
+    m_acc_dst               = NULL ;
+    m_acc_framestamp        = 0    ;
+    m_acc_timestamp         = 0.0  ;
+    m_acc_exposure          = 0.0  ;
+    m_trigger_latency_sum   = 0.0  ;
+
+    m_trigger_latency.nb_triggers = 0  ;
+    m_trigger_latency.nb_frames   = 0  ;
+    m_trigger_latency.last        = 0.0;
+    m_trigger_latency.min         = 0.0;
+    m_trigger_latency.mean        = 0.0;
+    m_trigger_latency.max         = 0.0;
+
+    m_rec_status.recording         = false;
+    m_rec_status.nb_frames         = 0    ;
+    m_rec_status.nb_missed         = 0    ;
+    m_rec_status.nb_missed_events  = 0    ;
+    m_rec_status.nb_skipped_events = 0    ;
+    m_rec_status.throughput        = 0.0  ;
+    m_prefaulted_huge       = false;
+    m_nb_views              = 1    ;
+    m_view_offset[0]        = -1   ;
+    m_view_offset[1]        = -1   ;
+    m_locked_size           = 0.0  ;
+    m_locked_reserved       = 0    ;
+
+    FrameStamps unused_stamps;
+    unused_stamps.frame_nb   = -1 ;
+    unused_stamps.framestamp = 0  ;
+    unused_stamps.timestamp  = 0.0;
+    unused_stamps.nb_images    = 0;
+    unused_stamps.nb_saturated = 0;
+    unused_stamps.view         = 0;
+    m_frame_stamps.assign(g_frame_stamps_size, unused_stamps);
+    DEB_TRACE() << "DONE";
+}
+
+/************************************************************************
+ * \brief destructor
+ ************************************************************************/
+Camera::CameraThread::~CameraThread()
+{
+    DEB_MEMBER_FUNCT();
+    DEB_TRACE() << "CameraThread::~CameraThread";
+    abort();
+    unlockBuffers();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::start()
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::start()
+{
+    DEB_MEMBER_FUNCT();
+    DEB_TRACE() << "BEGIN";
+    CmdThread::start();
+    waitStatus(Ready);
+    DEB_TRACE() << "END";
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::init()
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::init()
+{
+    DEB_MEMBER_FUNCT();
+
+    {
+        AutoMutex lock(m_thread_settings_mutex);
+        m_thread_settings = SystemTuning::getCurrentThreadSettings();
+        DEB_ALWAYS() << "Acquisition thread: " << m_thread_settings;
+    }
+
+    setStatus(CameraThread::Ready);
+    DEB_TRACE() << "CameraThread::init DONE";
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::abort()
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::abort()
+{
+    DEB_MEMBER_FUNCT();
+    CmdThread::abort();
+    DEB_TRACE() << "CameraThread::abort DONE";
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::execCmd()
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::execCmd(int cmd)
+{
+    DEB_MEMBER_FUNCT();
+
+    int status = getStatus();
+
+    try
+    {
+        switch (cmd)
+        {
+            case StartAcq:
+                if (status != Ready)
+                    throw LIMA_HW_EXC(InvalidValue, "Not Ready to StartAcq");
+                execStartAcq();
+                break;
+        }
+    }
+    catch (...)
+    {
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::execStopAcq()
+//---------------------------------------------------------------------------------------
+void Camera::execStopAcq()
+{
+    DEB_MEMBER_FUNCT();
+    DEB_TRACE() << "executing StopAcq command...";
+
+    if((getStatus() != Camera::Exposure) && (getStatus() != Camera::Readout) && (getStatus() != Camera::Latency))
+        DEB_WARNING() << "Execute a stop acq command but not in [exposure,Readout,Latency] status. ThreadStatus=" << m_thread.getStatus();
+
+    m_thread.abortCapture();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::checkStatusBeforeCapturing()
+// throws an exception if the status is incorrect
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::checkStatusBeforeCapturing() const
+{
+    DEB_MEMBER_FUNCT();
+
+    long    status;
+    DCAMERR err   ;
+
+    // Check the status and stop capturing if capturing is already started.
+    err = dcamcap_status( m_cam->m_camera_handle, &status );
+
+    if( failed(err) )
+    {
+        static_manage_error( m_cam, deb, "Cannot get status", err, "dcamcap_status");
+        THROW_HW_ERROR(Error) << "Cannot get status";
+    }
+
+    if (DCAMCAP_STATUS_READY != status) // After allocframe, the camera status should be READY
+    {
+        DEB_ERROR() << "Camera could not be set in the proper state for image capture";
+        THROW_HW_ERROR(Error) << "Camera could not be set in the proper state for image capture";
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::createWaitHandle()
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::createWaitHandle(HDCAMWAIT & wait_handle)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+
+    wait_handle = NULL;
+
+    // open wait handle
+    DCAMWAIT_OPEN waitOpenHandle;
+
+    memset( &waitOpenHandle, 0, sizeof(DCAMWAIT_OPEN) );
+    waitOpenHandle.size     = sizeof(DCAMWAIT_OPEN) ;
+    waitOpenHandle.hdcam = m_cam->m_camera_handle;
+
+    err = dcamwait_open( &waitOpenHandle );
+
+    if( failed(err) )
+    {
+        static_manage_error( m_cam, deb, "Cannot create the wait handle", err, "dcamwait_open");
+        THROW_HW_ERROR(Error) << "Cannot create the wait handle";
+    }
+    else
+    {
+        wait_handle   = waitOpenHandle.hwait; // after this, no need to keep the waitopen structure, freed by the stack
+        m_wait_events = waitOpenHandle.supportevent;
+        DEB_TRACE() << "Supported capture events: " << std::hex << m_wait_events << std::dec;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::releaseWaitHandle()
+// does not throw exception in case of problem but trace an error.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::releaseWaitHandle(HDCAMWAIT & wait_handle) const
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+
+    err = dcamwait_close( wait_handle );
+
+    if( failed(err) )
+    {
+        static_manage_error( m_cam, deb, "Cannot release the wait handle", err, "dcamwait_close");
+    }
+    
+    wait_handle = NULL;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::abortCapture()
+// Stop the capture, releasing the Wait handle and setting the boolean stop flag.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::abortCapture(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err = DCAMERR_NONE;
+
+    m_cam->m_mutex_force_stop.lock();
+
+    // the wait handle is kept between the acquisitions, it is only aborted during a capture
+    int status = getStatus();
+
+    if((m_wait_handle != NULL) && ((status == Exposure) || (status == Readout) || (status == Latency)))
+    {
+        err = dcamwait_abort( m_wait_handle );
+    }
+
+    if( failed(err) )
+    {
+        static_manage_error( m_cam, deb, "Cannot abort wait handle.", err, "dcamwait_abort");
+    }
+
+    m_force_stop = true;
+    m_cam->m_mutex_force_stop.unlock();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getTransfertInfo()
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getTransfertInfo(int32 & frame_index,
+                                            int32 & frame_count)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+
+    // transferinfo param
+    DCAMCAP_TRANSFERINFO transferinfo;
+    memset( &transferinfo, 0, sizeof(DCAMCAP_TRANSFERINFO) );
+    transferinfo.size = sizeof(DCAMCAP_TRANSFERINFO);
+
+    // get number of captured images
+    err = dcamcap_transferinfo( m_cam->m_camera_handle, &transferinfo );
+
+    if( failed(err) )
+    {
+        setStatus(CameraThread::Fault);
+
+        static_manage_error( m_cam, deb, "Cannot get transfer info.", err, "dcamcap_transferinfo");
+        THROW_HW_ERROR(Error) << "Cannot get transfer info.";
+    }
+    else
+    {
+        frame_index = transferinfo.nNewestFrameIndex;
+        frame_count = transferinfo.nFrameCount      ;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setupFrameBundle()
+// Configure the camera frame bundle for the next acquisition and read its layout.
+// Should be done before the allocation of the DCAM ring buffer.
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setupFrameBundle(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+    int     bundle_number = m_cam->m_frame_bundle_number;
+    double  temp;
+
+    if(bundle_number == 0)
+    {
+        bundle_number = m_cam->computeAutoFrameBundleNumber();
+    }
+
+    if(bundle_number < 1)
+    {
+        bundle_number = 1;
+    }
+
+    // a partial bundle is only transferred when the camera runs on its internal trigger 
+    if((bundle_number > 1) && (m_cam->m_trig_mode != IntTrig) && (m_cam->m_nb_frames % bundle_number != 0))
+    {
+        std::string errorText = string_format("The number of frames (%d) must be a multiple of the frame bundle number (%d) with this trigger mode.",
+                                              m_cam->m_nb_frames, bundle_number);
+        DEB_ERROR() << errorText;
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << errorText;
+    }
+
+    // the ring kept from the previous acquisition already has this layout
+    if(m_buffers_allocated && (bundle_number == m_bundle_number))
+        return;
+
+    // the bundle properties cannot be changed while the DCAM ring is allocated
+    if(m_buffers_allocated)
+        releaseBuffers();
+
+    m_bundle_number   = 1;
+    m_bundle_rowbytes = 0;
+    m_bundle_step     = 0;
+
+    if(bundle_number > 1)
+    {
+        err = dcamprop_setvalue( m_cam->m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_NUMBER, static_cast<double>(bundle_number) );
+        if( !failed(err) ) err = dcamprop_setvalue( m_cam->m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_MODE, DCAMPROP_MODE__ON );
+        if( !failed(err) ) err = dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_ROWBYTES, &temp );
+        if( !failed(err) ) 
+        {
+            m_bundle_rowbytes = static_cast<long>(temp);
+            err = dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_FRAMESTEPBYTES, &temp );
+        }
+
+        if( failed(err) )
+        {
+            std::string errorText = static_manage_error( m_cam, deb, "Cannot set the frame bundle", err, 
+                                                         "dcamprop_setvalue", "FRAMEBUNDLE_NUMBER=%d", bundle_number);
+            REPORT_EVENT(errorText);
+            THROW_HW_ERROR(Error) << "Cannot set the frame bundle";
+        }
+
+        m_bundle_step   = static_cast<long>(temp);
+        m_bundle_number = bundle_number;
+
+        DEB_ALWAYS() << "Frame bundle: " << m_bundle_number << " frames (rowbytes:" << m_bundle_rowbytes << ", step:" << m_bundle_step << ")";
+    }
+    else
+    // disable the bundle if the camera supports it
+    if( !failed( dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_MODE, &temp ) ) && 
+        (static_cast<int>(temp) != DCAMPROP_MODE__OFF) )
+    {
+        err = dcamprop_setvalue( m_cam->m_camera_handle, DCAM_IDPROP_FRAMEBUNDLE_MODE, DCAMPROP_MODE__OFF );
+
+        if( failed(err) )
+        {
+            std::string errorText = static_manage_error( m_cam, deb, "Cannot disable the frame bundle", err, 
+                                                         "dcamprop_setvalue", "FRAMEBUNDLE_MODE=OFF");
+            REPORT_EVENT(errorText);
+            THROW_HW_ERROR(Error) << "Cannot disable the frame bundle";
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::canAttachBuffers()
+// Check if the lima buffers can be directly used as the DCAM ring buffer.
+// The DCAM frame layout must be exactly the lima one (same size, no top offset, no padding).
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::canAttachBuffers(StdBufferCbMgr & buffer_mgr) const ///< [in] buffer manager object
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR  err           ;
+    double   frame_bytes   = 0.0;
+    double   row_bytes     = 0.0;
+    double   top_offset    = 0.0;
+    int      nb_buffers    = 0  ;
+    int      nb_concat     = 1  ;
+    FrameDim frame_dim     = buffer_mgr.getFrameDim();
+    int      width         = frame_dim.getSize().getWidth ();
+    int      height        = frame_dim.getSize().getHeight();
+    int      mem_size      = frame_dim.getMemSize();
+
+    buffer_mgr.getNbBuffers     (nb_buffers);
+    buffer_mgr.getNbConcatFrames(nb_concat );
+
+    if((nb_buffers < 1) || (nb_concat != 1) || (m_bundle_number > 1))
+    {
+        DEB_TRACE() << "Zero-copy not possible: " << DEB_VAR3(nb_buffers, nb_concat, m_bundle_number);
+        return false;
+    }
+
+    err = dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_FRAMEBYTES, &frame_bytes );
+    if( !failed(err) ) err = dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_ROWBYTES, &row_bytes );
+    if( !failed(err) ) err = dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_TOPOFFSETBYTES, &top_offset );
+
+    if( failed(err) )
+    {
+        static_manage_trace( m_cam, deb, "Zero-copy not possible: cannot read the DCAM buffer layout", err, "dcamprop_getvalue");
+        return false;
+    }
+
+    if((static_cast<int>(frame_bytes) != mem_size                 ) ||
+       (static_cast<int>(top_offset ) != 0                        ) ||
+       (static_cast<int>(row_bytes  ) * height != mem_size        ) ||
+       (static_cast<int>(row_bytes  ) != width * frame_dim.getDepth()))
+    {
+        static_manage_trace( m_cam, deb, "Zero-copy not possible: incoherent buffer layout", DCAMERR_NONE, "canAttachBuffers",
+                             "frame bytes %d, row bytes %d, top offset %d, lima frame size %d", 
+                             static_cast<int>(frame_bytes), static_cast<int>(row_bytes), static_cast<int>(top_offset), mem_size);
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::allocBuffers()
+// Attach the lima buffers as DCAM ring buffer if zero-copy is requested and possible, 
+// allocate a DCAM internal ring buffer otherwise.
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::allocBuffers(StdBufferCbMgr & buffer_mgr) ///< [in] buffer manager object
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+
+    m_zero_copy = false;
+    m_attached_frames.clear();
+
+    // layout of the ring, to know if it can be kept for the next acquisition
+    m_alloc_zero_copy   = m_cam->m_zero_copy_enabled;
+    m_alloc_frame_bytes = 0.0;
+    m_alloc_row_bytes   = 0.0;
+    dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_FRAMEBYTES, &m_alloc_frame_bytes );
+    dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_ROWBYTES  , &m_alloc_row_bytes   );
+
+    // the placeholder frames and the decimated images would shift the lima numbering relative to the DCAM ring
+    if(m_cam->m_zero_copy_enabled && (m_cam->m_overrun_policy != Overrun_Policy_Placeholder) && 
+       (!m_cam->m_recording_enabled) && (m_cam->m_live_decimation == 1) && (m_cam->m_live_max_rate == 0.0) &&
+       m_cam->m_regions.empty() && (!m_cam->isViewSplitActive()) && canAttachBuffers(buffer_mgr))
+    {
+        int nb_buffers = 0;
+        buffer_mgr.getNbBuffers(nb_buffers);
+
+        // lima frame n is in buffer (n % nb_buffers), so is the DCAM frame n with a ring of nb_buffers frames
+        for(int buffer_index = 0 ; buffer_index < nb_buffers ; buffer_index++)
+        {
+            m_attached_frames.push_back(buffer_mgr.getFrameBufferPtr(buffer_index));
+        }
+
+        DCAMBUF_ATTACH bufattach;
+        memset( &bufattach, 0, sizeof(bufattach) );
+        bufattach.size        = sizeof(bufattach);
+        bufattach.iKind       = DCAMBUF_ATTACHKIND_FRAME;
+        bufattach.buffer      = &m_attached_frames[0];
+        bufattach.buffercount = nb_buffers;
+
+        err = dcambuf_attach( m_cam->m_camera_handle, &bufattach );
+
+        if( failed(err) )
+        {
+            // not fatal, we will use the copy mode
+            static_manage_trace( m_cam, deb, "Failed to attach the lima buffers, using the copy mode", err, 
+                                 "dcambuf_attach", "number_of_buffer=%d", nb_buffers);
+            m_attached_frames.clear();
+        }
+        else
+        {
+            m_zero_copy = true;
+            m_ring_size = nb_buffers;
+            m_buffers_allocated = true;
+            DEB_ALWAYS() << "Attached lima frames (zero-copy): " << m_ring_size;
+            return;
+        }
+    }
+
+    // Allocate frames to capture
+    int ring_depth = computeRingDepth();
+
+    err = dcambuf_alloc( m_cam->m_camera_handle, ring_depth );
+
+    if( failed(err) )
+    {
+        std::string errorText = static_manage_error( m_cam, deb, "Failed to allocate frames for the capture", err, 
+                                                     "dcambuf_alloc", "number_of_buffer=%d", ring_depth);
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << "Cannot allocate frame for capturing (dcam_allocframe()).";
+    }
+    else
+    {
+        m_ring_size = ring_depth;
+        m_buffers_allocated = true;
+        DEB_ALWAYS() << "Allocated frames: " << m_ring_size;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::computeRingDepth()
+// Compute the number of frames of the DCAM ring buffer. 
+// In automatic mode, the ring absorbs m_ring_latency seconds of frames within the memory
+// budget, and is not bigger than the number of DCAM frames of the acquisition (but never
+// smaller than g_ring_min_depth).
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::computeRingDepth(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(!m_cam->m_ring_auto_size)
+        return m_cam->m_frame_buffer_size;
+
+    DCAMERR err;
+    double  frame_bytes = 0.0;
+
+    // the DCAM frame contains the full bundle
+    err = dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_FRAMEBYTES, &frame_bytes );
+
+    if( failed(err) || (frame_bytes <= 0.0) )
+    {
+        static_manage_trace( m_cam, deb, "Cannot compute the DCAM ring depth, using the default depth", err, 
+                             "dcamprop_getvalue", "DCAM_IDPROP_BUFFER_FRAMEBYTES");
+        return m_cam->m_frame_buffer_size;
+    }
+
+    double dcam_frame_rate = m_cam->getPredictedFrameRate() / m_bundle_number;
+    int    depth           = static_cast<int>(ceil(dcam_frame_rate * m_cam->m_ring_latency));
+    int    max_depth       = static_cast<int>((m_cam->m_ring_memory_budget * 1024.0 * 1024.0) / frame_bytes);
+
+    if(depth > max_depth)
+        depth = max_depth;
+
+    // no need to have more frames than the acquisition (a DCAM frame contains m_bundle_number hardware images)
+    long long nb_hw_images = getNbHardwareImages();
+
+    if(nb_hw_images > 0)
+    {
+        long long nb_dcam_frames = (nb_hw_images + m_bundle_number - 1) / m_bundle_number;
+
+        if(depth > nb_dcam_frames)
+            depth = static_cast<int>(nb_dcam_frames);
+    }
+
+    if(depth < g_ring_min_depth)
+        depth = g_ring_min_depth;
+
+    DEB_TRACE() << "DCAM ring depth: " << depth << " (frame bytes:" << static_cast<long>(frame_bytes) 
+                << ", dcam frame rate:" << dcam_frame_rate << ", max depth:" << max_depth << ")";
+    return depth;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getNbHardwareImages()
+// Compute the number of images the camera gives for the lima frames of the acquisition
+// (0 for a continuous acquisition): an accumulated lima frame is the sum of several 
+// images, a W-View image gives a lima frame per view and a decimated delivery gives one
+// image out of n to lima, until the image of the last lima frame. With a maximum delivery
+// rate, the number is unknown (0) and the acquisition ends with the last lima frame.
+//---------------------------------------------------------------------------------------
+long long Camera::CameraThread::getNbHardwareImages(void) const
+{
+    if(m_cam->m_nb_frames <= 0)
+        return 0;
+
+    long long nb_hw_images = m_cam->m_nb_frames;
+
+    if(m_cam->m_depth == 32)
+        nb_hw_images *= m_cam->m_accumulation_nb_frames;
+
+    if(m_cam->isViewSplitActive())
+        nb_hw_images = (nb_hw_images + 1) / 2;
+
+    int decimation = (m_cam->m_recording_enabled) ? m_cam->m_recording_decimation : m_cam->m_live_decimation;
+
+    if((m_cam->m_live_max_rate > 0.0) || (decimation < 1))
+        return 0;
+
+    return (nb_hw_images - 1) * decimation + 1;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::releaseBuffers()
+// Release the DCAM ring buffer (allocated or attached).
+// does not throw exception in case of problem but trace an error and returns false.
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::releaseBuffers(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+
+    // the copy threads can still be reading the DCAM ring
+    m_copy_pool.waitIdle();
+
+    // the recorder is attached to the capture in the DCAM ring (error paths after dcamcap_stop)
+    closeRecorder();
+    m_raw_writer.close();
+
+    m_prepared = false;
+
+    if(!m_buffers_allocated)
+        return true;
+
+    m_buffers_allocated = false;
+
+    err = dcambuf_release( m_cam->m_camera_handle, (m_zero_copy) ? DCAMBUF_ATTACHKIND_FRAME : 0 );
+
+    if( failed(err) )
+    {
+        std::string errorText = static_manage_error( m_cam, deb, "Unable to free capture frame", err, "dcambuf_release");
+        REPORT_EVENT(errorText);
+    }
+    else
+    {
+        DEB_TRACE() << "dcambuf_release success.";
+    }
+
+    m_attached_frames.clear();
+    return !failed(err);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::buffersMatch()
+// Check if the DCAM ring kept from the previous acquisition can be used for the next one:
+// same DCAM frame layout, same zero-copy request, same lima buffers in zero-copy mode and
+// same depth in copy mode.
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::buffersMatch(StdBufferCbMgr & buffer_mgr) const ///< [in] buffer manager object
+{
+    DEB_MEMBER_FUNCT();
+
+    double frame_bytes = 0.0;
+    double row_bytes   = 0.0;
+
+    if(!m_buffers_allocated || (m_alloc_zero_copy != m_cam->m_zero_copy_enabled))
+        return false;
+
+    if( failed( dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_FRAMEBYTES, &frame_bytes ) ) ||
+        failed( dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BUFFER_ROWBYTES  , &row_bytes   ) ) )
+        return false;
+
+    if((frame_bytes != m_alloc_frame_bytes) || (row_bytes != m_alloc_row_bytes))
+        return false;
+
+    if(m_zero_copy)
+    {
+        if(m_cam->m_overrun_policy == Overrun_Policy_Placeholder)
+            return false;
+
+        // lima can reallocate its buffers between two acquisitions
+        int nb_buffers = 0;
+        buffer_mgr.getNbBuffers(nb_buffers);
+
+        if(nb_buffers != static_cast<int>(m_attached_frames.size()))
+            return false;
+
+        for(int buffer_index = 0 ; buffer_index < nb_buffers ; buffer_index++)
+        {
+            if(buffer_mgr.getFrameBufferPtr(buffer_index) != m_attached_frames[buffer_index])
+                return false;
+        }
+
+        return true;
+    }
+
+    return (const_cast<CameraThread *>(this)->computeRingDepth() == m_ring_size);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::prepareCapture()
+// Prepare the next acquisition from the caller thread (prepareAcq), the preparation
+// is protected against the acquisition thread and the other callers.
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::prepareCapture(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    AutoMutex lock(m_prepare_mutex);
+
+    int status = getStatus();
+
+    if((status == Exposure) || (status == Readout) || (status == Latency))
+    {
+        THROW_HW_ERROR(Error) << "Cannot prepare the acquisition during a capture";
+    }
+
+    execPrepareCapture();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::execPrepareCapture()
+// Do all the expensive work of the acquisition start: frame bundle setup, DCAM ring 
+// allocation (kept from the previous acquisition if its layout did not change) and 
+// wait handle creation. After this call, the capture only needs dcamcap_start.
+// Must be called with m_prepare_mutex locked.
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::execPrepareCapture(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    StdBufferCbMgr& buffer_mgr = m_cam->m_buffer_ctrl_obj.getBuffer();
+
+    m_prepared = false;
+
+    // Frame bundle changes the DCAM frame layout, so it is set before the buffers allocation
+    setupFrameBundle();
+
+    // 12 bits packed pixels are unpacked to 16 bits, 16 bits pixels reduced to 8 bits by the copy
+    {
+        double pixel_type = 0.0;
+        dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_IMAGE_PIXELTYPE, &pixel_type );
+
+        switch(static_cast<int32>(pixel_type))
+        {
+            case DCAM_PIXELTYPE_MONO12 : m_conversion = FrameCopy::Conversion_Mono12 ; break;
+            case DCAM_PIXELTYPE_MONO12P: m_conversion = FrameCopy::Conversion_Mono12P; break;
+            default                    : m_conversion = FrameCopy::Conversion_None   ; break;
+        }
+
+        // the unpack writes 16 bits pixels (a pixel type set with setParameter can come with 8 or 32 bits images)
+        if(((m_conversion == FrameCopy::Conversion_Mono12) || (m_conversion == FrameCopy::Conversion_Mono12P)) && (m_cam->m_depth != 16))
+        {
+            THROW_HW_ERROR(Error) << "The 12 bits packed pixels are only possible with 16 bits images!";
+        }
+
+        // 8 bits window of the 16 bits pixels
+        if(m_cam->m_soft_bit_shift >= 0)
+        {
+            m_conversion = FrameCopy::Conversion_Window8;
+            m_bit_shift  = m_cam->m_soft_bit_shift;
+        }
+    }
+
+    // the number of frames of the acquisition counts the lima frames, lima would wait forever without live images
+    if(m_cam->m_recording_enabled && (m_cam->m_recording_decimation == 0) && (m_cam->m_nb_frames != 0))
+    {
+        THROW_HW_ERROR(Error) << "A recording without live images is only possible in a continuous acquisition (0 frames)";
+    }
+
+    // 16 bits pixels summed in 32 bits, a pixel is saturated at the maximum value of the sensor
+    m_accumulating = (m_cam->m_depth == 32);
+
+    if(m_accumulating)
+    {
+        if(m_cam->m_recording_enabled || (m_cam->m_live_decimation != 1) || (m_cam->m_live_max_rate > 0.0))
+        {
+            THROW_HW_ERROR(Error) << "The accumulation is not possible with a decimated delivery (recording or live decimation)";
+        }
+
+        double bits = 16.0;
+
+        if( failed( dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_BITSPERCHANNEL, &bits ) ) || (bits < 1.0) || (bits > 16.0) )
+            bits = 16.0;
+
+        m_saturation_level = static_cast<unsigned short>((1 << static_cast<int>(bits)) - 1);
+    }
+
+    // the copy crops the regions in the 16 or 8 bits pixels of the DCAM frame
+    if(!m_cam->m_regions.empty())
+    {
+        if((m_conversion == FrameCopy::Conversion_Mono12) || (m_conversion == FrameCopy::Conversion_Mono12P) || m_accumulating)
+        {
+            THROW_HW_ERROR(Error) << "The multi-region readout is not possible with the packed transfer or the accumulation";
+        }
+    }
+
+    if(m_cam->isViewSplitActive() && m_accumulating)
+    {
+        THROW_HW_ERROR(Error) << "The accumulation is not possible in W-View split mode";
+    }
+
+    // no page fault on the lima buffers during the acquisition
+    if(m_cam->m_buffer_prefault || m_cam->m_buffer_lock || m_cam->m_buffer_huge_pages || (m_cam->m_numa_node >= 0))
+    {
+        prefaultBuffers(buffer_mgr);
+    }
+    else
+    if(m_prefaulted_buffer != NULL)
+    {
+        unlockBuffers();
+        m_prefaulted_buffer = NULL;
+    }
+
+    // Allocate (or attach) frames to capture
+    if(buffersMatch(buffer_mgr))
+    {
+        DEB_TRACE() << "Keeping the DCAM ring of the previous acquisition (" << m_ring_size << " frames)";
+    }
+    else
+    {
+        if(m_buffers_allocated)
+            releaseBuffers();
+
+        allocBuffers(buffer_mgr);
+    }
+
+    // Check the status and stop capturing if capturing is already started.
+    checkStatusBeforeCapturing();
+
+    // Write some informations about the camera before the acquisition
+    bool ViewModeEnabled;
+    m_cam->getViewMode(ViewModeEnabled);
+
+    if(ViewModeEnabled)
+    {
+        DEB_TRACE() << "View mode activated";
+
+        int    view_index   = 0;
+        double view_exposure;
+
+        while(view_index < m_cam->m_max_views)
+        {
+            m_cam->getViewExpTime(view_index, view_exposure);
+            DEB_TRACE() << "View " << (view_index+1) << " exposure : " << view_exposure;
+            view_index++;
+        }
+    }
+    else
+    {
+        DEB_TRACE() << "View mode unactivated";
+        double exposure;
+
+        m_cam->getExpTime(exposure);
+        DEB_TRACE() << "exposure : " << exposure;
+    }
+
+    // Create the wait handle (kept between the acquisitions)
+    if(m_wait_handle == NULL)
+    {
+        createWaitHandle(m_wait_handle);
+    }
+
+    // used to timestamp the images of a bundle
+    double frame_rate = m_cam->getPredictedFrameRate();
+    m_frame_period = (frame_rate > 0.0) ? (1.0 / frame_rate) : 0.0;
+
+    // in W-View split mode, each hardware image gives a lima frame per view
+    m_nb_views = (m_cam->isViewSplitActive()) ? 2 : 1;
+
+    // the views are not always contiguous in the DCAM image: top of each view given by the camera
+    m_view_offset[0] = -1;
+    m_view_offset[1] = -1;
+
+    if(m_nb_views > 1)
+    {
+        double view_top[2] = {0.0, 0.0};
+
+        if( !failed( dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_BUFFER_TOPOFFSETBYTES), &view_top[0] ) ) &&
+            !failed( dcamprop_getvalue( m_cam->m_camera_handle, DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_BUFFER_TOPOFFSETBYTES), &view_top[1] ) ) &&
+            (view_top[1] >= view_top[0]) )
+        {
+            // the lock gives the top of the first view
+            m_view_offset[0] = 0;
+            m_view_offset[1] = static_cast<long>(view_top[1] - view_top[0]);
+        }
+        else
+        {
+            DEB_TRACE() << "No top offset for each view, the views are contiguous in the DCAM image";
+        }
+
+        DEB_TRACE() << "View offsets: " << DEB_VAR2(m_view_offset[0], m_view_offset[1]);
+    }
+
+    // files and snapshot of the acquisition, so the start only calls dcamcap_start
+    openStreams();
+
+    m_prepared = true;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::openStreams()
+// Create the recorder file (attached to the capture), the raw writer files and the 
+// snapshot slots of the next acquisition. The streams of a previous preparation not 
+// followed by a start are closed first. Must be called after the DCAM ring allocation.
+// The streams are closed with the DCAM ring (releaseBuffers).
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::openStreams(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    closeRecorder();
+    m_raw_writer.close();
+
+    if(m_cam->m_recording_enabled)
+    {
+        openRecorder();
+    }
+
+    // the raw writer and the snapshot take the hardware images, not the accumulated frames
+    int tap_depth = (m_accumulating) ? 2 : m_cam->m_buffer_ctrl_obj.getBuffer().getFrameDim().getDepth();
+
+    // with the multi-region readout, the hardware image is the bounding box of the regions
+    Size tap_size = (m_cam->m_regions.empty()) ? m_cam->m_buffer_ctrl_obj.getBuffer().getFrameDim().getSize() : m_cam->m_regions_bbox.getSize();
+
+    if (m_nb_views > 1)
+        tap_size = Size(tap_size.getWidth(), tap_size.getHeight() * m_nb_views);
+
+    try
+    {
+        if(m_cam->m_raw_writer_enabled)
+        {
+            m_raw_writer.setFileSize       (m_cam->m_raw_writer_file_size);
+            m_raw_writer.setNbSlots        (m_cam->m_raw_writer_slots    );
+            m_raw_writer.setDirectIoEnabled(m_cam->m_raw_writer_direct_io);
+
+            m_raw_writer.open(string_format("%s_%04d", m_cam->m_raw_writer_path.c_str(), m_raw_index++),
+                              tap_size.getWidth(), tap_size.getHeight(), tap_depth);
+        }
+
+        m_snapshot_active = m_cam->m_snapshot_enabled;
+
+        if(m_snapshot_active)
+        {
+            m_snapshot.setMaxRate(m_cam->m_snapshot_max_rate);
+            m_snapshot.configure (tap_size.getWidth(), tap_size.getHeight(), tap_depth);
+        }
+    }
+    catch(Exception &)
+    {
+        closeRecorder();
+        m_raw_writer.close();
+        m_snapshot_active = false;
+        throw;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::applyThreadSettings()
+// Apply the priority and the cpus of the acquisition thread (called by the thread itself).
+// A setting refused by the system only gives a warning, the effective settings are reported.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::applyThreadSettings(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    m_thread_settings_changed = false;
+
+    std::vector<int> cpus = m_cam->m_acq_thread_cpus;
+
+    try
+    {
+        if(cpus.empty() && (m_cam->m_numa_node >= 0))
+            cpus = SystemTuning::getNumaNodeCpus(m_cam->m_numa_node);
+
+        SystemTuning::setCurrentThreadCpus(cpus);
+    }
+    catch(Exception & e)
+    {
+        DEB_WARNING() << "Cannot set the cpus of the acquisition thread: " << e.getErrMsg();
+    }
+
+    try
+    {
+        SystemTuning::setCurrentThreadPriority(m_cam->m_acq_thread_priority);
+    }
+    catch(Exception & e)
+    {
+        DEB_WARNING() << "Cannot set the priority of the acquisition thread: " << e.getErrMsg();
+    }
+
+    AutoMutex lock(m_thread_settings_mutex);
+    m_thread_settings = SystemTuning::getCurrentThreadSettings();
+    DEB_ALWAYS() << "Acquisition thread: " << m_thread_settings;
+}
+
+//-----------------------------------------------------------------------------
+// Prepare the pages of the lima buffers, so no page fault happens during the
+// acquisition: optionally ask for huge pages, touch every page (from the cpus 
+// of the NUMA node if one is set, so the pages not mapped yet are placed on 
+// the node) and lock the pages in physical memory.
+// Done again only if the lima buffers or the options changed.
+//-----------------------------------------------------------------------------
+void Camera::CameraThread::prefaultBuffers(StdBufferCbMgr & buffer_mgr) ///< [in] buffer manager object
+{
+    DEB_MEMBER_FUNCT();
+
+    int    nb_buffers = 0;
+    int    mem_size   = buffer_mgr.getFrameDim().getMemSize();
+    void * first      = buffer_mgr.getFrameBufferPtr(0);
+
+    buffer_mgr.getNbBuffers(nb_buffers);
+
+    if((first == m_prefaulted_buffer) && (nb_buffers == m_prefaulted_nb) && 
+       (mem_size == m_prefaulted_size) && (m_cam->m_numa_node == m_prefaulted_node) &&
+       (m_cam->m_buffer_lock == m_prefaulted_lock) && (m_cam->m_buffer_huge_pages == m_prefaulted_huge))
+    {
+        return;
+    }
+
+    // the lock of the previous buffers (or options) is undone first
+    unlockBuffers();
+
+    Timestamp        t0         = Timestamp::now();
+    std::vector<int> old_cpus   = SystemTuning::getCurrentThreadCpus();
+    size_t           total_size = static_cast<size_t>(mem_size) * nb_buffers;
+    size_t           huge_size  = 0;
+    size_t           lock_size  = 0;
+
+    if(m_cam->m_numa_node >= 0)
+    {
+        try
+        {
+            SystemTuning::setCurrentThreadCpus(SystemTuning::getNumaNodeCpus(m_cam->m_numa_node));
+        }
+        catch(Exception & e)
+        {
+            DEB_WARNING() << "Cannot run on the NUMA node " << m_cam->m_numa_node << " cpus: " << e.getErrMsg();
+        }
+    }
+
+    bool can_lock = m_cam->m_buffer_lock && SystemTuning::reserveLockedMemory(total_size);
+
+    if(can_lock)
+        m_locked_reserved = total_size;
+    bool bound    = (m_cam->m_numa_node >= 0);
+
+    for(int buffer_index = 0 ; buffer_index < nb_buffers ; buffer_index++)
+    {
+        char * buffer = static_cast<char *>(buffer_mgr.getFrameBufferPtr(buffer_index));
+
+        if(m_cam->m_buffer_huge_pages && SystemTuning::adviseHugePages(buffer, static_cast<size_t>(mem_size)))
+            huge_size += mem_size;
+
+        // the pages already touched by the lima allocation are moved to the node
+        if((m_cam->m_numa_node >= 0) && !SystemTuning::bindMemoryToNode(buffer, static_cast<size_t>(mem_size), m_cam->m_numa_node))
+            bound = false;
+
+        SystemTuning::touchPages(buffer, static_cast<size_t>(mem_size));
+
+        if(can_lock && SystemTuning::lockMemory(buffer, static_cast<size_t>(mem_size)))
+        {
+            lock_size += mem_size;
+            m_locked_ranges.push_back(std::make_pair(buffer, static_cast<size_t>(mem_size)));
+        }
+    }
+
+    if(m_cam->m_numa_node >= 0)
+        SystemTuning::setCurrentThreadCpus(old_cpus);
+
+    // node actually holding the buffers: the node of most buffers (first page of each buffer)
+    std::map<int, int> buffers_by_node;
+
+    for(int buffer_index = 0 ; buffer_index < nb_buffers ; buffer_index++)
+        ++buffers_by_node[SystemTuning::getMemoryNode(static_cast<char *>(buffer_mgr.getFrameBufferPtr(buffer_index)))];
+
+    int nb_on_node = 0;
+    m_buffers_node = -1;
+
+    for(std::map<int, int>::const_iterator node = buffers_by_node.begin() ; node != buffers_by_node.end() ; ++node)
+    {
+        if(node->second > nb_on_node)
+        {
+            m_buffers_node = node->first ;
+            nb_on_node     = node->second;
+        }
+    }
+
+    if((m_cam->m_numa_node >= 0) && ((m_buffers_node != m_cam->m_numa_node) || (nb_on_node < nb_buffers)))
+    {
+        DEB_WARNING() << "Lima buffers not placed on the NUMA node " << m_cam->m_numa_node << ": " << nb_on_node << " of " 
+                      << nb_buffers << " buffers on the node " << m_buffers_node << ((bound) ? "" : " (the pages cannot be moved)");
+    }
+
+    m_prefaulted_buffer = first     ;
+    m_prefaulted_nb     = nb_buffers;
+    m_prefaulted_size   = mem_size  ;
+    m_prefaulted_node   = m_cam->m_numa_node;
+    m_prefaulted_lock   = m_cam->m_buffer_lock;
+    m_prefaulted_huge   = m_cam->m_buffer_huge_pages;
+    m_locked_size       = static_cast<double>(lock_size) / (1024.0 * 1024.0);
+
+    DEB_ALWAYS() << "Lima buffers prefaulted: " << nb_buffers << " x " << mem_size << " bytes in " << (Timestamp::now() - t0) << " s"
+                 << " (NUMA node: " << m_buffers_node << ", huge pages: " << huge_size << " bytes, locked: " << lock_size << " bytes)";
+
+    if(m_cam->m_buffer_lock && (lock_size < total_size))
+    {
+        DEB_WARNING() << "Only " << lock_size << " of " << total_size << " bytes of the lima buffers are locked";
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Undo the lock of the latest prefault: unlock the lima buffers and give back
+// the memory reserved for them (the buffers can be already freed by lima, 
+// their lock is then already gone).
+//-----------------------------------------------------------------------------
+void Camera::CameraThread::unlockBuffers(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    for(size_t range_index = 0 ; range_index < m_locked_ranges.size() ; range_index++)
+        SystemTuning::unlockMemory(m_locked_ranges[range_index].first, m_locked_ranges[range_index].second);
+
+    SystemTuning::releaseLockedMemory(m_locked_reserved);
+
+    m_locked_ranges.clear();
+    m_locked_reserved = 0  ;
+    m_locked_size     = 0.0;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::releasePreparedBuffers()
+// Release the DCAM ring and the wait handle kept between the acquisitions.
+// Used before a change of the image layout and at the camera destruction. 
+// Does nothing during a capture.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::releasePreparedBuffers(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    AutoMutex lock(m_prepare_mutex);
+
+    int status = getStatus();
+
+    if((status == Exposure) || (status == Readout) || (status == Latency))
+        return;
+
+    m_prepared = false;
+
+    // the recorder and raw writer files of the preparation are closed with the DCAM ring
+    if(m_buffers_allocated)
+        releaseBuffers();
+
+    m_snapshot_active = false;
+
+    if(m_wait_handle != NULL)
+        releaseWaitHandle(m_wait_handle);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::execStartAcq()
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::execStartAcq()
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR   err          = DCAMERR_NONE;
+    bool      continue_acq = true        ;
+    Timestamp T0    = Timestamp::now();
+    Timestamp T1    = Timestamp::now();
+
+    DEB_TRACE() << m_cam->g_trace_line_separator.c_str();
+    DEB_TRACE() << "CameraThread::execStartAcq - BEGIN";
+
+    {
+        AutoMutex prepare_lock(m_prepare_mutex);
+
+        // a caller can no longer release the preparation (and startAcq stops waiting)
+        setStatus(CameraThread::Exposure);
+
+        // prepareAcq was not called (or its preparation was invalidated by a change of the image layout)
+        try
+        {
+            if(!m_prepared)
+                execPrepareCapture();
+        }
+        catch(Exception & e)
+        {
+            setStatus(CameraThread::Fault);
+
+            std::string errorText = static_manage_error( m_cam, deb, "Cannot prepare the acquisition", DCAMERR_NONE, 
+                                                         "execStartAcq", "%s", e.getErrMsg().c_str());
+            REPORT_EVENT(errorText);
+            throw;
+        }
+
+        m_prepared = false;
+    }
+
+    if(m_thread_settings_changed)
+    {
+        applyThreadSettings();
+    }
+
+    // with the DCAM recorder or a live decimation, lima only receives some of the hardware images
+    m_decimation         = (m_cam->m_recording_enabled) ? m_cam->m_recording_decimation : m_cam->m_live_decimation;
+    m_max_delivery_rate  = m_cam->m_live_max_rate;
+    m_next_delivery_time = 0.0;
+    m_decimated          = (m_decimation != 1) || (m_max_delivery_rate > 0.0);
+    m_hw_images_done     = false;
+    m_nb_hw_images       = getNbHardwareImages();
+
+    m_acc_nb_frames = m_cam->m_accumulation_nb_frames;
+    m_acc_average   = m_cam->m_accumulation_average  ;
+    m_acc_exposure  = m_cam->m_exp_time;
+    m_acc_group     = -1;
+    m_acc_count     = 0 ;
+
+    setStatus(CameraThread::Exposure);
+
+    StdBufferCbMgr& buffer_mgr = m_cam->m_buffer_ctrl_obj.getBuffer();
+
+    m_start_timestamp = Timestamp::now();
+    buffer_mgr.setStartTimestamp(m_start_timestamp);
+
+    {
+        AutoMutex lock(m_trigger_mutex);
+        m_trigger_times.clear();
+        m_trigger_base        = 0  ;
+        m_trigger_latency_sum = 0.0;
+
+        m_trigger_latency.nb_triggers = 0  ;
+        m_trigger_latency.nb_frames   = 0  ;
+        m_trigger_latency.last        = 0.0;
+        m_trigger_latency.min         = 0.0;
+        m_trigger_latency.mean        = 0.0;
+        m_trigger_latency.max         = 0.0;
+    }
+
+    DEB_TRACE() << "Run";
 
     // Start the real capture (this function returns immediately)
     err = dcamcap_start( m_cam->m_camera_handle, DCAMCAP_START_SEQUENCE );
 
     if( failed(err) )
     {
-        dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
-        releaseWaitHandle( m_wait_handle           );        
-        dcambuf_release  ( m_cam->m_camera_handle ); // Release the capture frame
-        setStatus        ( CameraThread::Fault    );
+        dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+        releaseWaitHandle( m_wait_handle           );        
+        releaseBuffers   (                        ); // Release the capture frame
+        setStatus        ( CameraThread::Fault    );
+
+        std::string errorText = static_manage_error( m_cam, deb, "Cannot start the capture", err, "dcamcap_start");
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << "Frame capture failed";
+    }
+
+    // the startAcq call of the first frame is its software trigger
+    if (m_cam->m_trig_mode == IntTrigMult)
+    {
+        err = dcamcap_firetrigger( m_cam->m_camera_handle, 0 );
+
+        if( failed(err) )
+        {
+            dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+            releaseWaitHandle( m_wait_handle           );        
+            releaseBuffers   (                        ); // Release the capture frame
+            setStatus        ( CameraThread::Fault    );
+
+            std::string errorText = static_manage_error( m_cam, deb, "Cannot fire the software trigger", err, "dcamcap_firetrigger");
+            REPORT_EVENT(errorText);
+            THROW_HW_ERROR(Error) << "Cannot fire the software trigger";
+        }
+
+        AutoMutex lock(m_trigger_mutex);
+        m_trigger_times.push_back(LatencyRecorder::now());
+        ++m_trigger_latency.nb_triggers;
+    }
+
+    m_cam->m_start_acq_time = Timestamp::now() - m_cam->m_start_acq_request;
+    DEB_TRACE() << "startAcq time (s): " << m_cam->m_start_acq_time;
+
+    //-----------------------------------------------------------------------------
+    // Transfer the images as they are beeing captured from dcam_sdk buffer to Lima
+    //-----------------------------------------------------------------------------
+    // Timestamp before DCAM "snapshot"
+    T0 = Timestamp::now();
+
+    m_cam->m_lost_frames_count = 0;
+    m_ring_high_water          = 0;
+    m_clock_offset_valid       = false;
+    m_next_hw_frame            = 0;
+    m_framestamp_base_valid    = false;
+
+    // the status follows the DCAM exposure end events if the camera gives them and if they are 
+    // needed: they wake the thread up at each exposure, which cancels the frame bundle benefit
+    m_exposure_events = ((m_wait_events & DCAMWAIT_CAPEVENT_EXPOSUREEND) != 0);
+
+    if (m_cam->m_exposure_events_mode == Exposure_Events_Off)
+    {
+        m_exposure_events = false;
+    }
+    else
+    if (m_cam->m_exposure_events_mode == Exposure_Events_Auto)
+    {
+        bool trigger_per_frame = (m_cam->m_trig_mode == IntTrigMult) || (m_cam->m_trig_mode == ExtTrigMult) || (m_cam->m_trig_mode == ExtGate);
+
+        m_exposure_events = m_exposure_events && trigger_per_frame && (m_bundle_number == 1);
+    }
+
+    {
+        AutoMutex lock(m_exposure_end_mutex);
+        m_nb_exposure_ends  = 0;
+        m_last_exposure_end = m_start_timestamp;
+    }
+
+    updateCaptureStatus(0);
+
+    {
+        AutoMutex lock(m_frame_gaps_mutex);
+        m_frame_gaps.clear();
+    }
+
+    m_frame_number = m_cam->m_image_number;
+    m_delivery_ok  = true;
+    m_copy_pool.start(this, m_frame_number);
+    m_latency.start();
+    m_metrics.start(LatencyRecorder::now());
+
+    double        frame_mem_size = buffer_mgr.getFrameDim().getMemSize();
+    unsigned long metrics_lost   = 0; // lost frames already given to the rolling metrics
+
+    int32 lastFrameCount = 0 ;
+    int32 frame_count     = 0 ;
+    int32 lastFrameIndex = -1;
+    int32 frame_index     = 0 ;
+    
+    // Main acquisition loop
+    while (    ( continue_acq )    && ( !m_hw_images_done ) &&
+            ( (0==m_cam->m_nb_frames) || (m_frame_number < m_cam->m_nb_frames) ) )
+    {
+        if (!m_exposure_events)
+            setStatus(CameraThread::Exposure);
+
+        // Check first if acq. has been stopped
+        if (m_force_stop)
+        {
+            //abort the current acquisition
+            continue_acq  = false;
+            m_force_stop = false;
+            continue;
+        }
+
+        // Wait for the next image to become available or the end of the capture by user
+        // set wait param
+        DCAMWAIT_START waitstart;
+        memset( &waitstart, 0, sizeof(DCAMWAIT_START) );
+        waitstart.size        = sizeof(DCAMWAIT_START);
+        waitstart.eventmask    = DCAMWAIT_CAPEVENT_FRAMEREADY | DCAMWAIT_CAPEVENT_STOPPED;
+
+        if (m_exposure_events)
+            waitstart.eventmask |= (m_wait_events & (DCAMWAIT_CAPEVENT_EXPOSUREEND | DCAMWAIT_CAPEVENT_TRANSFERRED));
+
+        if (m_rec_handle != NULL)
+            waitstart.eventmask |= (m_wait_events & g_recorder_events);
+        waitstart.timeout    = DCAMWAIT_TIMEOUT_INFINITE;
+
+        // wait image
+        err = dcamwait_start( m_wait_handle, &waitstart );
+
+        m_wait_time = LatencyRecorder::now();
+
+        if( failed(err) )
+        {
+            // If capture was aborted (by stopAcq() -> dcam_idle())
+            if (DCAMERR_ABORT == err)
+            {
+                DEB_TRACE() << "DCAMERR_ABORT";
+                continue_acq = false;
+                continue;
+            }
+            else 
+            if (DCAMERR_TIMEOUT == err)
+            {
+                dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+                releaseWaitHandle( m_wait_handle           );        
+                releaseBuffers   (                        ); // Release the capture frame
+                setStatus        ( CameraThread::Fault    );
+
+                std::string errorText = static_manage_error( m_cam, deb, "Error during the frame capture wait", err, "dcamwait_start");
+                REPORT_EVENT(errorText);
+
+                THROW_HW_ERROR(Error) << "DCAMERR_TIMEOUT";
+            }
+            else
+            if(( DCAMERR_LOSTFRAME == err) || (DCAMERR_MISSINGFRAME_TROUBLE == err) )
+            {
+                static_manage_error( m_cam, deb, "Error during the frame capture wait", err, "dcamwait_start");
+
+                // with the framestamps, the lost frames are exactly counted when the next frame is received
+                if (!m_cam->m_hw_framestamp_supported)
+                    ++m_cam->m_lost_frames_count;
+                continue;
+            }
+            else
+            {                    
+                dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+                releaseWaitHandle( m_wait_handle           );        
+                releaseBuffers   (                        ); // Release the capture frame
+                setStatus        ( CameraThread::Fault    );
+
+                std::string errorText = static_manage_error( m_cam, deb, "Error during the frame capture wait", err, "dcamwait_start");
+                REPORT_EVENT(errorText);
+                THROW_HW_ERROR(Error) << "Error during the frame capture wait";
+            }
+        }
+        else
+        // wait succeeded
+        {
+            if (waitstart.eventhappened & DCAMWAIT_CAPEVENT_STOPPED)
+            {
+                DEB_TRACE() << "DCAM_EVENT_CAPTUREEND";
+                continue_acq = false;
+                continue;
+            }
+
+            if (waitstart.eventhappened & g_recorder_events)
+            {
+                if (!manageRecorderEvents(waitstart.eventhappened))
+                {
+                    RecordingStatus rec_status;
+                    getRecordingStatus(rec_status);
+
+                    dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+                    releaseWaitHandle( m_wait_handle           );        
+                    releaseBuffers   (                        ); // Release the capture frame (and the recorder)
+                    setStatus        ( CameraThread::Fault    );
+
+                    DEB_ERROR() << rec_status.error;
+                    REPORT_EVENT(rec_status.error);
+                    THROW_HW_ERROR(Error) << rec_status.error;
+                }
+
+                // the recorder file of a continuous acquisition is full
+                if ((waitstart.eventhappened & DCAMWAIT_RECEVENT_STOPPED) && (0 == m_cam->m_nb_frames))
+                {
+                    DEB_TRACE() << "DCAMWAIT_RECEVENT_STOPPED";
+                    continue_acq = false;
+                    continue;
+                }
+            }
+
+            if (waitstart.eventhappened & DCAMWAIT_CAPEVENT_EXPOSUREEND)
+            {
+                recordExposureEnd();
+            }
+
+            // an exposure end alone, no new frame to transfer
+            if (!(waitstart.eventhappened & (DCAMWAIT_CAPEVENT_FRAMEREADY | DCAMWAIT_CAPEVENT_TRANSFERRED)))
+            {
+                updateCaptureStatus(lastFrameCount);
+                continue;
+            }
+        }
+
+        if (m_force_stop)
+        {
+            //abort the current acqusition
+            continue_acq  = false;
+            m_force_stop = false;
+            break;
+        }
+
+        // Transfert the new images
+        if (!m_exposure_events)
+            setStatus(CameraThread::Readout);
+        
+        int32 deltaFrames = 0;
+        int   occupancy   = 0;
+
+        getTransfertInfo(frame_index, frame_count);
+
+        // manage the frame info
+        {
+            deltaFrames = frame_count-lastFrameCount;
+
+            if (m_latency.isEnabled())
+            {
+                m_info_time   = LatencyRecorder::now();
+                m_queue_depth = deltaFrames;
+            }
+
+            DEB_TRACE() << g_trace_little_line_separator.c_str();
+            DEB_TRACE() << "(m_image_number:"  << m_cam->m_image_number << ")"
+                        << " (lastFrameIndex:" << lastFrameIndex        << ")" 
+                        << " (frame_index:"    << frame_index           << ")" 
+                        << " (frame_count:"    << frame_count           << ")"
+                        << " (deltaFrames:"    << deltaFrames           << ")";
+
+            if (0 == frame_count)
+            {
+                dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+                releaseWaitHandle( m_wait_handle           );        
+                releaseBuffers   (                        ); // Release the capture frame
+                setStatus        ( CameraThread::Fault    );
+
+                std::string errorText = "No image captured.";
+                DEB_ERROR() << errorText;
+                REPORT_EVENT(errorText);
+                THROW_HW_ERROR(Error) << "No image captured.";
+            }
+            // ring occupancy: new frames and frames still being copied by the copy threads
+            {
+                occupancy = deltaFrames + (m_copy_pool.getNbPending() + m_bundle_number - 1) / m_bundle_number;
+
+                if(occupancy > m_ring_high_water)
+                    m_ring_high_water = occupancy;
+            }
+
+            // the frames overwritten in the ring are counted as lost by copyFrames (gap in the frame numbers)
+            if (deltaFrames > m_ring_size)
+            {
+                DEB_TRACE() << "deltaFrames > m_ring_size (" << deltaFrames << ")";
+            }
+
+            // In zero-copy mode, the DCAM ring is the lima buffer pool: a frame overwritten before 
+            // being given to lima cannot be recovered anymore. The plugin only knows the frames given
+            // to lima, not the frames lima processed or saved: a buffer given to lima but not yet 
+            // processed can be overwritten by the driver without this check seeing it.
+            if (m_zero_copy)
+            {
+                int32 last_needed_frame = ((0 == m_cam->m_nb_frames) || (frame_count < m_cam->m_nb_frames)) ? frame_count : m_cam->m_nb_frames;
+
+                if ((last_needed_frame - m_cam->m_image_number) > m_ring_size)
+                {
+                    dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+                    releaseWaitHandle( m_wait_handle           );        
+                    releaseBuffers   (                        ); // Release the capture frame
+                    setStatus        ( CameraThread::Fault    );
+
+                    std::string errorText = "Zero-copy ring overrun: frames were overwritten before being given to lima.";
+                    DEB_ERROR() << errorText;
+                    REPORT_EVENT(errorText);
+                    THROW_HW_ERROR(Error) << errorText;
+                }
+            }
+            else
+            // The copy threads read the DCAM ring: the slot of the oldest frame still being copied 
+            // is reused by DCAM with the next frame once m_ring_size - 1 newer frames are pending.
+            {
+                int oldest_ring_frame = m_copy_pool.getOldestRingFrame();
+
+                if ((oldest_ring_frame >= 0) && ((frame_count - oldest_ring_frame) >= (m_ring_size - 1)))
+                {
+                    manageCopyOverrun(frame_count - m_ring_size + 1);
+                }
+            }
+            lastFrameCount = frame_count;
+        }
+
+        // Check if acquisition was stopped & abort the current acqusition
+        if (m_force_stop)
+        {
+            continue_acq  = false;
+            m_force_stop = false;
+            break;
+        }
+
+        int nbFrameToCopy      = 0;
+        int first_frame_number = m_frame_number;
+
+        try
+        {
+            m_cam->m_mutex_force_stop.lock();
+
+            // Copy frames from DCAM_SDK to LiMa
+            nbFrameToCopy  = (deltaFrames < m_ring_size) ? deltaFrames : m_ring_size; // if more than m_ring_size have arrived
+
+            // after an overrun, only the newest m_ring_size frames are still in the ring
+            continue_acq    = copyFrames( (frame_index - nbFrameToCopy + 1 + m_ring_size) % m_ring_size, // index of the first image to copy from the ring buffer
+                                          nbFrameToCopy,
+                                          frame_count - nbFrameToCopy, 
+                                          buffer_mgr);
+            lastFrameIndex = frame_index;
+        }
+        catch (...)
+        {
+            // be sure to unlock the mutex before throwing the exception!
+            m_cam->m_mutex_force_stop.unlock();
+
+            dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+            releaseWaitHandle( m_wait_handle           );        
+            releaseBuffers   (                        ); // Release the capture frame
+            setStatus        ( CameraThread::Fault    );
+
+            throw;
+        }
+
+        m_cam->m_mutex_force_stop.unlock();
+
+        updateCaptureStatus(frame_count);
+        
+        // Update the rolling metrics (frames given to lima or to the copy threads)
+        {
+            int nb_frames = m_frame_number - first_frame_number;
+            int nb_lost   = static_cast<int>(m_cam->m_lost_frames_count - metrics_lost);
+
+            metrics_lost = m_cam->m_lost_frames_count;
+            m_metrics.update(m_wait_time, nb_frames, nb_frames * frame_mem_size, nb_lost, occupancy);
+        }
+
+        T1 = Timestamp::now();
+
+    } // end of acquisition loop
+
+    m_metrics.stop(LatencyRecorder::now());
+
+    // Stop the acquisition
+    err = dcamcap_stop( m_cam->m_camera_handle);
+
+    if( failed(err) )
+    {
+        releaseWaitHandle( m_wait_handle           );        
+        releaseBuffers   (                        ); // Release the capture frame
+        setStatus        ( CameraThread::Fault    );
+
+        std::string errorText = static_manage_error( m_cam, deb, "Cannot stop acquisition.", err, "dcamcap_stop");
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << "Cannot stop acquisition.";
+    }
+
+    closeRecorder();
+
+    // The wait handle and the DCAM ring are kept for the next acquisition (released by a change 
+    // of the image layout), only the copies still running are waited for (the raw writer slots too).
+    m_copy_pool.waitIdle();
+    m_raw_writer.close();
+
+    DEB_ALWAYS() << g_trace_line_separator.c_str();
+    DEB_ALWAYS() << "Total time (s): " << (T1 - T0);
+    DEB_ALWAYS() << "FPS           : " << int(m_cam->m_image_number / (T1 - T0) );
+    DEB_ALWAYS() << "Lost frames   : " << m_cam->m_lost_frames_count; 
+    DEB_ALWAYS() << "Ring depth    : " << m_ring_size << " (high water mark: " << m_ring_high_water << ")";
+    DEB_ALWAYS() << g_trace_line_separator.c_str();
+
+    setStatus(CameraThread::Ready);
+    DEB_TRACE() << "CameraThread::execStartAcq - END";
+}
+
+//-----------------------------------------------------------------------------
+// Copy the given frames to the buffer manager
+// In frame bundle mode, each DCAM frame contains m_bundle_number images.
+//-----------------------------------------------------------------------------
+bool Camera::CameraThread::copyFrames(const int        index_frame_begin, ///< [in] index of the frame where to begin copy
+                                      const int        nb_frames_count, ///< [in] number of frames to copy
+                                      const int        first_dcam_frame, ///< [in] DCAM number (count - 1) of the first frame to copy
+                                      StdBufferCbMgr & buffer_mgr ) ///< [in] buffer manager object
+{
+    DEB_MEMBER_FUNCT();
+    
+    DEB_TRACE() << "copyFrames(" << index_frame_begin << ", nb:" << nb_frames_count << ")";
+
+    DCAMERR  err         ;
+    FrameDim frame_dim   = buffer_mgr.getFrameDim();
+    Size     frame_size  = frame_dim.getSize     ();
+    int      height      = frame_size.getHeight  ();
+    int      memSize     = frame_dim.getMemSize  ();
+    long int lineSize    = frame_size.getWidth() * frame_dim.getDepth(); // useful bytes of a line
+    bool     regions     = !m_cam->m_regions.empty(); // the DCAM frame is the bounding box of the regions, packed in the lima frame
+    int      srcWidth    = (regions) ? m_cam->m_regions_bbox.getSize().getWidth () : frame_size.getWidth();
+    int      srcHeight   = (regions) ? m_cam->m_regions_bbox.getSize().getHeight() : height * m_nb_views; // W-View split mode: a lima frame per view
+    long int srcLineSize = srcWidth * frame_dim.getDepth(); // useful bytes of a DCAM line
+    
+    if((m_conversion == FrameCopy::Conversion_Window8) || m_accumulating)
+        srcLineSize = srcWidth * 2; // 16 bits DCAM pixels reduced to 8 bits or summed in 32 bits
+    else
+    if(m_conversion != FrameCopy::Conversion_None)
+        srcLineSize = FrameCopy::getPackedLineSize(srcWidth);
+    long int tapLineSize = (m_accumulating) ? srcLineSize : srcWidth * frame_dim.getDepth(); // raw writer and snapshot line (hardware images)
+    bool     CopySuccess = false                   ;
+    bool     AllCaptured = false                   ;
+    int      iFrameIndex = index_frame_begin             ; // Index of frame in the DCAM cycling buffer
+
+    for  (int cptFrame = 1 ; (cptFrame <= nb_frames_count) && (!AllCaptured) ; cptFrame++)
+    {
+        char     * src_top     = NULL; // top of the DCAM frame (first image of the bundle)
+        long int   sRowbytes   = 0   ;
+        int        nb_images   = 1   ; // number of images in the DCAM frame
+        bool       has_stamps  = false;
+        double     hw_time     = 0.0 ; // DCAM timestamp of the frame in host clock
+        int        framestamp  = 0   ;
+        double     lock_time   = 0.0 ; // latency record: time of the frame lock
+
+        // prepare frame stucture
+        DCAMBUF_FRAME bufframe;
+        memset( &bufframe, 0, sizeof(bufframe) );
+        bufframe.size    = sizeof(bufframe);
+        bufframe.iFrame    = iFrameIndex     ;
+
+        // In zero-copy mode, the frame is only locked to read its hardware stamps
+        if (m_zero_copy && (m_cam->m_hw_timestamp_supported || m_cam->m_hw_framestamp_supported))
+        {
+            if( !failed( dcambuf_lockframe( m_cam->m_camera_handle, &bufframe ) ) )
+            {
+                has_stamps = true;
+            }
+        }
+
+        if (!m_zero_copy)
+        {
+            // access image
+            err = dcambuf_lockframe( m_cam->m_camera_handle, &bufframe );
+
+            if( failed(err) )
+            {
+                setStatus(CameraThread::Fault);
+
+                std::string errorText = static_manage_error( m_cam, deb, "Unable to lock frame data", err, "dcambuf_lockframe");
+                REPORT_EVENT(errorText);
+                THROW_HW_ERROR(Error) << "Unable to lock frame data";
+            }
+
+            src_top   = static_cast<char *>(bufframe.buf);
+            sRowbytes = (m_bundle_number > 1) ? m_bundle_rowbytes : bufframe.rowbytes;
+            nb_images = m_bundle_number;
+            has_stamps = true;
+
+            if((lineSize * height != memSize) || (sRowbytes < srcLineSize))
+            {
+                static_manage_trace( m_cam, deb, "Incoherent sizes during frame copy process", DCAMERR_NONE,
+                                     "copyFrames", "source size %d, dest size %d", sRowbytes * height, memSize);
+
+                setStatus(CameraThread::Fault);
+
+                std::string errorText = static_manage_error( m_cam, deb, "Cannot get image.", DCAMERR_NONE, "copyFrames");
+                REPORT_EVENT(errorText);
+                THROW_HW_ERROR(Error) << "Cannot get image.";
+            }
+        }
+
+        if (m_latency.isEnabled())
+            lock_time = LatencyRecorder::now();
+
+        // DCAM frame count of the ring slot (the copy threads read the slot until its jobs are done)
+        int ring_frame = first_dcam_frame + (cptFrame - 1);
+
+        // hardware number of the DCAM frame: from the framestamp if possible, from the DCAM frame count otherwise
+        int hw_frame = ring_frame;
+
+        if (has_stamps && m_cam->m_hw_framestamp_supported)
+        {
+            // the first frame gives the framestamp of the hardware frame 0
+            if (!m_framestamp_base_valid)
+            {
+                m_framestamp_base       = bufframe.framestamp - hw_frame;
+                m_framestamp_base_valid = true;
+            }
+
+            hw_frame = bufframe.framestamp - m_framestamp_base;
+
+            if (hw_frame < m_next_hw_frame)
+            {
+                DEB_WARNING() << "Framestamp went backward (" << bufframe.framestamp << "), resynchronizing";
+                m_framestamp_base = bufframe.framestamp - m_next_hw_frame;
+                hw_frame          = m_next_hw_frame;
+            }
+        }
+
+        if (hw_frame > m_next_hw_frame)
+        {
+            CopySuccess = manageFrameGap(hw_frame, buffer_mgr);
+
+            if ( (m_frame_number >= m_cam->m_nb_frames) && (0!=m_cam->m_nb_frames))
+            {
+                DEB_TRACE() << "All images captured.";
+                AllCaptured = true;
+                break;
+            }
+        }
+
+        m_next_hw_frame = hw_frame + 1;
+
+        if (m_cam->m_trig_mode == IntTrigMult)
+            recordTriggerLatency(hw_frame);
+
+        if (has_stamps)
+        {
+            framestamp = bufframe.framestamp;
+
+            if (m_cam->m_hw_timestamp_supported && ((bufframe.timestamp.sec != 0) || (bufframe.timestamp.microsec != 0)))
+                hw_time = correlateTimestamp(bufframe.timestamp);
+        }
+
+        // Unpack each image of the DCAM frame
+        for (int image_index = 0 ; (image_index < nb_images) && (!AllCaptured) ; image_index++)
+        {
+            // a bundle has only one timestamp, the following images are spaced by the frame period
+            double image_time = hw_time;
+
+            if ((hw_time != 0.0) && (image_index > 0))
+                image_time += image_index * m_frame_period;
+
+            // hardware number of the image (does not fit in an int on long or fast acquisitions)
+            long long hw_image_nb = static_cast<long long>(hw_frame) * m_bundle_number + image_index;
+
+            // every hardware image is streamed to disk and can be the latest frame snapshot, whatever is given to lima
+            if (m_raw_writer.isOpen() || m_snapshot_active)
+            {
+                FrameCopyPool::Job tap_job;
+                tap_job.src          = (m_zero_copy) ? static_cast<const char *>(m_attached_frames[iFrameIndex]) : src_top + (image_index * m_bundle_step);
+                tap_job.dst          = NULL     ;
+                tap_job.src_rowbytes = (m_zero_copy) ? lineSize : sRowbytes;
+                tap_job.line_size    = tapLineSize;
+                tap_job.dst_rowbytes = 0        ;
+                tap_job.height       = srcHeight;
+                tap_job.frame_size   = 0        ;
+                tap_job.conversion   = (m_zero_copy) ? FrameCopy::Conversion_None : m_conversion;
+                tap_job.bit_shift    = m_bit_shift;
+                tap_job.ring_frame   = ring_frame ;
+
+                // the second view is not always just under the first one
+                if ((m_nb_views > 1) && (!regions) && (m_view_offset[1] >= 0))
+                    tap_job.src_half_offset = m_view_offset[1];
+
+                // copied by the copy threads, except in zero-copy mode (the lima buffer can be reused once delivered)
+                FrameCopyPool * tap_pool = (m_zero_copy) ? NULL : &m_copy_pool;
+
+                if (m_raw_writer.isOpen())
+                    m_raw_writer.push(tap_pool, tap_job, hw_image_nb, framestamp, image_time);
+
+                if (m_snapshot_active)
+                    m_snapshot.update(tap_pool, tap_job, hw_image_nb, framestamp, image_time, m_wait_time);
+            }
+
+            // decimated delivery: every hardware image is accounted, only some of them are given to lima
+            if (m_decimated)
+            {
+                bool deliver = (m_decimation > 0) && ((hw_image_nb % m_decimation) == 0);
+
+                // rate limit on the arrival time of the DCAM frame
+                if (deliver && (m_max_delivery_rate > 0.0))
+                {
+                    deliver = (m_wait_time >= m_next_delivery_time);
+
+                    if (deliver)
+                        m_next_delivery_time = m_wait_time + (1.0 / m_max_delivery_rate);
+                }
+
+                // the image of the last lima frame is still delivered
+                if ((m_nb_hw_images > 0) && (hw_image_nb + 1 >= m_nb_hw_images))
+                {
+                    DEB_TRACE() << "All hardware images captured.";
+                    m_hw_images_done = true;
+                }
+
+                if (!deliver)
+                {
+                    CopySuccess = m_delivery_ok;
+                    AllCaptured = m_hw_images_done;
+                    continue;
+                }
+            }
+
+            // summed in the lima frame of its accumulation group
+            if (m_accumulating)
+            {
+                CopySuccess = accumulateImage(hw_image_nb, src_top + (image_index * m_bundle_step), sRowbytes, framestamp, image_time, buffer_mgr);
+
+                if ( (m_frame_number >= m_cam->m_nb_frames) && (0!=m_cam->m_nb_frames))
+                {
+                    DEB_TRACE() << "All accumulated frames captured.";
+                    AllCaptured = true;
+                }
+
+                continue;
+            }
+
+            // in W-View split mode, each view is a lima frame
+            for (int view = 0 ; (view < m_nb_views) && (!AllCaptured) ; view++)
+            {
+                HwFrameInfoType frame_info;
+                frame_info.acq_frame_nb = m_frame_number;        
+
+                if (has_stamps)
+                {
+                    storeFrameStamps(m_frame_number, framestamp, image_time, 1, 0, view);
+
+                    if (m_cam->m_hw_timestamp_enabled && (hw_time != 0.0))
+                        frame_info.frame_timestamp = Timestamp(image_time) - m_start_timestamp;
+                }
+
+                void * dst = buffer_mgr.getFrameBufferPtr(m_frame_number);
+
+                if (m_latency.isEnabled())
+                    m_latency.begin(m_frame_number, m_queue_depth, m_wait_time, m_info_time, lock_time);
+
+                // In zero-copy mode, the frame was directly written by the driver into the lima buffer
+                if (m_zero_copy)
+                {
+                    if(dst != m_attached_frames[iFrameIndex])
+                    {
+                        static_manage_trace( m_cam, deb, "Incoherent zero-copy frame index", DCAMERR_NONE,
+                                             "copyFrames", "image number %d, ring index %d", m_frame_number, iFrameIndex);
+                        setStatus(CameraThread::Fault);
+
+                        std::string errorText = static_manage_error( m_cam, deb, "Cannot get image.", DCAMERR_NONE, "copyFrames");
+                        REPORT_EVENT(errorText);
+                        THROW_HW_ERROR(Error) << "Cannot get image.";
+                    }
+
+                    // nothing to copy
+                    if (m_latency.isEnabled())
+                        m_latency.mark(m_frame_number, LatencyRecorder::Stage_CopyEnd, lock_time);
+
+                    CopySuccess = deliverFrame(frame_info);
+                }
+                else
+                {
+                    FrameCopyPool::Job job;
+                    job.frame_info   = frame_info;
+                    job.src          = src_top + (image_index * m_bundle_step) +                              // top of the view
+                                       ((m_view_offset[view] >= 0) ? m_view_offset[view] : (view * height * sRowbytes));
+                    job.dst          = static_cast<char *>(dst);
+                    job.src_rowbytes = sRowbytes;
+                    job.line_size    = lineSize ;
+                    job.dst_rowbytes = 0        ;
+                    job.height       = height   ;
+                    job.frame_size   = 0        ;
+                    job.conversion   = m_conversion;
+                    job.bit_shift    = m_bit_shift ;
+                    job.ring_frame   = ring_frame  ;
+
+                    // one copy per region
+                    if (regions)
+                        buildRegionJobs(job);
+
+                    if(m_copy_pool.getNbThreads() > 0)
+                    {
+                        // the copy threads will give the frame to lima
+                        if (regions)
+                            m_copy_pool.push(m_region_jobs);
+                        else
+                            m_copy_pool.push(job);
+
+                        CopySuccess = m_delivery_ok;
+                    }
+                    else
+                    {
+                        if (regions)
+                        {
+                            for (size_t part = 0 ; part < m_region_jobs.size() ; part++)
+                                FrameCopyPool::copy(m_region_jobs[part]);
+                        }
+                        else
+                        {
+                            FrameCopyPool::copy(job);
+                        }
+
+                        if (m_latency.isEnabled())
+                            m_latency.mark(m_frame_number, LatencyRecorder::Stage_CopyEnd, LatencyRecorder::now());
+
+                        CopySuccess = deliverFrame(frame_info);
+                    }
+
+                #ifdef HAMAMATSU_CAMERA_DEBUG_ACQUISITION
+                    DEB_TRACE() << "Acquired (m_frame_number:" << m_frame_number << ")"
+                                << " (frame_index:"            << iFrameIndex    << ")" 
+                                << " (bundle_index:"           << image_index    << ")" 
+                                << " (rowbytes:"               << sRowbytes      << ")"
+                                << " (height:"                 << height         << ")";
+                #endif
+                }
+
+                ++m_frame_number;
+
+                // Done capturing (SNAP)
+                if ( (m_frame_number == m_cam->m_nb_frames) && (0!=m_cam->m_nb_frames))
+                {
+                    DEB_TRACE() << "All images captured.";
+                    AllCaptured = true;
+                }
+            }
+        }
+
+        iFrameIndex = (iFrameIndex+1) % m_ring_size;
+    }
+
+    DEB_TRACE() << DEB_VAR1(CopySuccess);
+    return CopySuccess;
+}
+
+//-----------------------------------------------------------------------------
+// Manage the hardware frames lost before the given DCAM frame, following the 
+// overrun policy. In frame bundle mode, each lost DCAM frame is m_bundle_number images.
+// throws an exception with the stop policy.
+//-----------------------------------------------------------------------------
+bool Camera::CameraThread::manageFrameGap(const int        hw_frame  , ///< [in] hardware number of the DCAM frame received
+                                          StdBufferCbMgr & buffer_mgr) ///< [in] buffer manager object
+{
+    DEB_MEMBER_FUNCT();
+
+    // no placeholder with a decimated delivery or an accumulation, lima does not receive all the hardware images
+    bool placeholders = (m_cam->m_overrun_policy == Overrun_Policy_Placeholder) && (!m_decimated) && (!m_accumulating);
+
+    Camera::FrameGap gap;
+    gap.first_hw_frame  = m_next_hw_frame * m_bundle_number;
+    gap.nb_frames       = (hw_frame - m_next_hw_frame) * m_bundle_number;
+    gap.next_lima_frame = (placeholders) ? m_frame_number + (gap.nb_frames * m_nb_views) : m_frame_number;
+
+    m_cam->m_lost_frames_count += gap.nb_frames;
+
+    DEB_WARNING() << "Lost hardware frames " << gap.first_hw_frame << " to " << (gap.first_hw_frame + gap.nb_frames - 1)
+                  << " (" << gap.nb_frames << " frames) before lima frame " << m_frame_number;
+
+    {
+        AutoMutex lock(m_frame_gaps_mutex);
+
+        if(static_cast<int>(m_frame_gaps.size()) < g_frame_gaps_max)
+            m_frame_gaps.push_back(gap);
+    }
+
+    if(m_cam->m_overrun_policy == Overrun_Policy_Stop)
+    {
+        setStatus(CameraThread::Fault);
+
+        std::string errorText = string_format("Lost hardware frames %d to %d.", gap.first_hw_frame, gap.first_hw_frame + gap.nb_frames - 1);
+        DEB_ERROR() << errorText;
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << errorText;
+    }
+
+    if(!placeholders)
+        return m_delivery_ok;
+
+    // a zero filled frame for each lost image, so lima frame n stays hardware frame n
+    FrameDim frame_dim   = buffer_mgr.getFrameDim();
+    bool     frame_ok    = true;
+
+    // W-View split mode: a placeholder for each view
+    for(int lost_index = 0 ; lost_index < gap.nb_frames * m_nb_views ; lost_index++)
+    {
+        if((0 != m_cam->m_nb_frames) && (m_frame_number >= m_cam->m_nb_frames))
+            break;
+
+        FrameCopyPool::Job job;
+        job.frame_info.acq_frame_nb = m_frame_number;
+        job.src          = NULL;
+        job.dst          = static_cast<char *>(buffer_mgr.getFrameBufferPtr(m_frame_number));
+        job.src_rowbytes = 0;
+        job.line_size    = frame_dim.getSize().getWidth() * frame_dim.getDepth();
+        job.dst_rowbytes = 0;
+        job.height       = frame_dim.getSize().getHeight();
+        job.frame_size   = 0;
+        job.conversion   = FrameCopy::Conversion_None;
+        job.bit_shift    = 0;
+        job.ring_frame   = -1;
+
+        if(m_copy_pool.getNbThreads() > 0)
+        {
+            m_copy_pool.push(job);
+            frame_ok = m_delivery_ok;
+        }
+        else
+        {
+            FrameCopyPool::copy(job);
+            frame_ok = deliverFrame(job.frame_info);
+        }
+
+        ++m_frame_number;
+    }
+
+    return frame_ok;
+}
+
+//-----------------------------------------------------------------------------
+// The copy threads are late and DCAM will reuse the ring slots of frames still
+// waiting for a copy. Following the overrun policy, the acquisition stops or 
+// the queued copies of these frames are replaced by zero filled frames (their 
+// lima frame numbers are already given) counted as lost frames.
+// throws an exception with the stop policy.
+//-----------------------------------------------------------------------------
+void Camera::CameraThread::manageCopyOverrun(const int last_ring_frame) ///< [in] last DCAM frame whose slot can be reused by DCAM
+{
+    DEB_MEMBER_FUNCT();
+
+    // the queued copies must not read the reused slots, the running ones give zero filled frames
+    int nb_dropped = m_copy_pool.dropRingFrames(last_ring_frame);
+
+    m_cam->m_lost_frames_count += nb_dropped;
+
+    if(m_cam->m_overrun_policy == Overrun_Policy_Stop)
+    {
+        dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
+        m_copy_pool.waitIdle();
+        releaseWaitHandle( m_wait_handle           );        
+        releaseBuffers   (                        ); // Release the capture frame
+        setStatus        ( CameraThread::Fault    );
+
+        std::string errorText = "Copy ring overrun: frames were overwritten before being copied.";
+        DEB_ERROR() << errorText;
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << errorText;
+    }
+
+    if(nb_dropped > 0)
+    {
+        DEB_WARNING() << "Copy ring overrun: " << nb_dropped 
+                      << " frames up to the DCAM frame " << last_ring_frame << " replaced by zero filled frames";
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Split the copy of a multi-region frame in one copy per region (and one 
+// zero fill per padded region), in m_region_jobs. The regions are packed one 
+// under the other in the lima frame (see Camera::setRegions).
+//-----------------------------------------------------------------------------
+void Camera::CameraThread::buildRegionJobs(const FrameCopyPool::Job & in_job) ///< [in] copy of the bounding box of the regions to the lima frame
+{
+    const std::vector<Roi> & regions = m_cam->m_regions;
+    const std::vector<Roi> & layout  = m_cam->m_regions_layout;
+    Point                    origin  = m_cam->m_regions_bbox.getTopLeft();
+
+    long dst_pixel    = in_job.line_size / m_cam->m_regions_frame_size.getWidth(); // bytes of a lima pixel
+    long src_pixel    = (in_job.conversion == FrameCopy::Conversion_Window8) ? 2 : dst_pixel; // bytes of a DCAM pixel
+    long dst_rowbytes = in_job.line_size;
+
+    m_region_jobs.clear();
+
+    for (size_t region_index = 0 ; region_index < regions.size() ; region_index++)
+    {
+        int x      = regions[region_index].getTopLeft().x - origin.x;
+        int y      = regions[region_index].getTopLeft().y - origin.y;
+        int width  = regions[region_index].getSize().getWidth ();
+        int height = regions[region_index].getSize().getHeight();
+        int dst_y  = layout [region_index].getTopLeft().y;
+
+        FrameCopyPool::Job part = in_job;
+        part.src          = in_job.src + (y * in_job.src_rowbytes) + (x * src_pixel);
+        part.dst          = in_job.dst + (dst_y * dst_rowbytes);
+        part.line_size    = width * dst_pixel;
+        part.dst_rowbytes = dst_rowbytes;
+        part.height       = height;
+        part.frame_size   = static_cast<size_t>(dst_rowbytes) * m_cam->m_regions_frame_size.getHeight();
+
+        m_region_jobs.push_back(part);
+
+        // lines narrower than the lima frame
+        if (part.line_size < dst_rowbytes)
+        {
+            FrameCopyPool::Job pad = part;
+            pad.src        = NULL;
+            pad.ring_frame = -1  ;
+            pad.dst        = part.dst + part.line_size;
+            pad.line_size  = dst_rowbytes - part.line_size;
+
+            m_region_jobs.push_back(pad);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::recordExposureEnd()
+// Keep the time of an exposure end event for Camera::getLastExposureEnd().
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::recordExposureEnd(void)
+{
+    AutoMutex lock(m_exposure_end_mutex);
+
+    m_last_exposure_end = Timestamp::now();
+    ++m_nb_exposure_ends;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::updateCaptureStatus()
+// Status from the capture events (only if the camera gives the exposure end events):
+// - Readout : an exposure ended and its frame is not transferred yet,
+// - Latency : all the frames are transferred and the camera waits for the trigger of the next frame,
+// - Exposure: all the frames are transferred and the camera exposes the next frame.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::updateCaptureStatus(const int32 frame_count) ///< [in] number of DCAM frames transferred since the capture start
+{
+    if (!m_exposure_events)
+        return;
+
+    int  nb_transferred = frame_count * m_bundle_number;
+    bool readout       ;
+
+    {
+        AutoMutex lock(m_exposure_end_mutex);
+
+        // several exposure ends between two waits are signaled once
+        if (m_nb_exposure_ends < nb_transferred)
+            m_nb_exposure_ends = nb_transferred;
+
+        readout = (m_nb_exposure_ends > nb_transferred);
+    }
+
+    bool triggered = false; // a software trigger waits for its frame
+
+    if (m_cam->m_trig_mode == IntTrigMult)
+    {
+        AutoMutex lock(m_trigger_mutex);
+        triggered = !m_trigger_times.empty();
+    }
+
+    if (readout)
+    {
+        setStatus(CameraThread::Readout);
+    }
+    else
+    if (((m_cam->m_trig_mode == IntTrigMult) && (!triggered)) || (m_cam->m_trig_mode == ExtTrigMult) || (m_cam->m_trig_mode == ExtGate))
+    {
+        setStatus(CameraThread::Latency);
+    }
+    else
+    {
+        setStatus(CameraThread::Exposure);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::correlateTimestamp()
+// Convert a DCAM timestamp to the host clock.
+// The offset between the clocks goes to the minimum of (host time - DCAM time) seen during 
+// the acquisition: the frame processed with the shortest delay gives the best estimate.
+// The offset only decreases by half a frame period at each frame and a timestamp is never
+// before the previous one, so the lima timestamps stay monotonic.
+//---------------------------------------------------------------------------------------
+double Camera::CameraThread::correlateTimestamp(const DCAM_TIMESTAMP & hw_timestamp) ///< [in] DCAM timestamp of a frame
+{
+    double hw_time = static_cast<double>(hw_timestamp.sec) + (static_cast<double>(hw_timestamp.microsec) * 1e-6);
+    double offset  = static_cast<double>(Timestamp::now()) - hw_time;
+
+    if(!m_clock_offset_valid)
+    {
+        m_clock_offset       = offset;
+        m_clock_offset_valid = true  ;
+        m_last_timestamp     = hw_time + m_clock_offset;
+        return m_last_timestamp;
+    }
+
+    if(offset < m_clock_offset)
+    {
+        double max_step = 0.5 * m_frame_period; // 0 if the frame period is unknown: the first offset is kept
+
+        m_clock_offset = ((m_clock_offset - offset) > max_step) ? (m_clock_offset - max_step) : offset;
+    }
+
+    double timestamp = hw_time + m_clock_offset;
+
+    if(timestamp < m_last_timestamp)
+        timestamp = m_last_timestamp;
+
+    m_last_timestamp = timestamp;
+    return timestamp;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::storeFrameStamps()
+// Keep the hardware stamps of a frame for Camera::getFrameStamps().
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::storeFrameStamps(const int    frame_nb    , ///< [in] lima frame number
+                                            const int    framestamp  , ///< [in] DCAM framestamp
+                                            const double timestamp   , ///< [in] DCAM timestamp in host clock (s)
+                                            const int    nb_images   , ///< [in] hardware images summed in the frame
+                                            const long   nb_saturated, ///< [in] saturated pixels found in these images
+                                            const int    view        ) ///< [in] W-View of the frame in split mode
+{
+    AutoMutex lock(m_frame_stamps_mutex);
+
+    FrameStamps & stamps = m_frame_stamps[frame_nb % g_frame_stamps_size];
+
+    stamps.frame_nb     = frame_nb    ;
+    stamps.framestamp   = framestamp  ;
+    stamps.timestamp    = timestamp   ;
+    stamps.nb_images    = nb_images   ;
+    stamps.nb_saturated = nb_saturated;
+    stamps.view         = view        ;
+}
+
+//-----------------------------------------------------------------------------
+// Sum a hardware image in the lima frame of its accumulation group. The frame
+// is given to lima after its last image, or before if the next image belongs
+// to another group (the end of the group was lost).
+// Called by the acquisition thread.
+//-----------------------------------------------------------------------------
+bool Camera::CameraThread::accumulateImage(const long long  hw_image    , ///< [in] hardware number of the image
+                                           const char     * src         , ///< [in] top of the 16 bits image
+                                           const long       src_rowbytes, ///< [in] bytes between two source lines
+                                           const int        framestamp  , ///< [in] DCAM framestamp
+                                           const double     timestamp   , ///< [in] DCAM timestamp in host clock (s)
+                                           StdBufferCbMgr & buffer_mgr  ) ///< [in] buffer manager object
+{
+    FrameDim  frame_dim = buffer_mgr.getFrameDim();
+    int       width     = frame_dim.getSize().getWidth ();
+    int       height    = frame_dim.getSize().getHeight();
+    long long group     = hw_image / m_acc_nb_frames;
+    bool      delivered = m_delivery_ok;
+
+    if ((m_acc_count > 0) && (group != m_acc_group))
+    {
+        delivered = deliverAccumulation();
+
+        if ( (m_frame_number >= m_cam->m_nb_frames) && (0!=m_cam->m_nb_frames))
+            return delivered;
+    }
+
+    if (m_acc_count == 0)
+    {
+        m_acc_group      = group;
+        m_acc_dst        = static_cast<char *>(buffer_mgr.getFrameBufferPtr(m_frame_number));
+        m_acc_saturated  = 0;
+        m_acc_framestamp = framestamp;
+        m_acc_timestamp  = timestamp ;
+    }
+
+    m_acc_saturated += FrameCopy::accumulate16(m_acc_dst, width * 4, src, src_rowbytes, width, height, (m_acc_count == 0), m_saturation_level);
+    ++m_acc_count;
+
+    if (((hw_image + 1) % m_acc_nb_frames) == 0)
+        delivered = deliverAccumulation();
+
+    return delivered;
+}
+
+//-----------------------------------------------------------------------------
+// Give the frame being summed to lima (means computed in Bpp32F), with the 
+// stamps of its first image
+//-----------------------------------------------------------------------------
+bool Camera::CameraThread::deliverAccumulation(void)
+{
+    StdBufferCbMgr & buffer_mgr = m_cam->m_buffer_ctrl_obj.getBuffer();
+    Size             frame_size = buffer_mgr.getFrameDim().getSize();
+
+    if (m_acc_average)
+        FrameCopy::average32(m_acc_dst, static_cast<size_t>(frame_size.getWidth()) * frame_size.getHeight(), m_acc_count);
+
+    HwFrameInfoType frame_info;
+    frame_info.acq_frame_nb = m_frame_number;
+
+    storeFrameStamps(m_frame_number, m_acc_framestamp, m_acc_timestamp, m_acc_count, m_acc_saturated);
+
+    if (m_cam->m_hw_timestamp_enabled && (m_acc_timestamp != 0.0))
+        frame_info.frame_timestamp = Timestamp(m_acc_timestamp) - m_start_timestamp;
+
+    m_acc_count = 0;
+    ++m_frame_number;
+
+    return deliverFrame(frame_info);
+}
+
+//-----------------------------------------------------------------------------
+// Give a copied frame to lima
+// Called by the acquisition thread or by the copy threads (in frame order).
+//-----------------------------------------------------------------------------
+bool Camera::CameraThread::deliverFrame(HwFrameInfoType & frame_info) ///< [in] informations of the frame to give to lima
+{
+    StdBufferCbMgr & buffer_mgr = m_cam->m_buffer_ctrl_obj.getBuffer();
+
+    bool frame_ok = buffer_mgr.newFrameReady(frame_info);
+    ++m_cam->m_image_number; // atomic: read by the lima and acquisition threads
+
+    if(m_latency.isEnabled())
+        m_latency.mark(frame_info.acq_frame_nb, LatencyRecorder::Stage_Delivered, LatencyRecorder::now());
+
+    if(!frame_ok)
+        m_delivery_ok = false;
+
+    return frame_ok;
+}
+
+//-----------------------------------------------------------------------------
+// FrameCopyPool::Callback: a frame was copied by a copy thread
+//-----------------------------------------------------------------------------
+void Camera::CameraThread::frameCopied(HwFrameInfoType & frame_info) ///< [in] informations of the copied frame
+{
+    deliverFrame(frame_info);
+}
+
+//-----------------------------------------------------------------------------
+// FrameCopyPool::Callback: a frame was fully copied by the copy threads
+// (before the reorder stage)
+//-----------------------------------------------------------------------------
+void Camera::CameraThread::frameCopyEnd(const int frame_nb) ///< [in] number of a frame fully copied
+{
+    if(m_latency.isEnabled())
+        m_latency.mark(frame_nb, LatencyRecorder::Stage_CopyEnd, LatencyRecorder::now());
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::openRecorder()
+// Create the recorder file of the acquisition and attach it to the capture.
+// Each acquisition gets its own file: <path>_<index>.dcimg
+// Must be called after the DCAM ring allocation and before dcamcap_start.
+// throws an exception in case of problem
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::openRecorder(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+
+    // the recorder counts DCAM frames (a frame contains m_bundle_number hardware images)
+    long long nb_hw_images   = getNbHardwareImages();
+    int       nb_dcam_frames = (0 != nb_hw_images) ? static_cast<int>((nb_hw_images + m_bundle_number - 1) / m_bundle_number) : 
+                                                     m_cam->m_recording_max_frames;
+
+    std::string file_name = string_format("%s_%04d", m_cam->m_recording_path.c_str(), m_rec_index++);
+
+#ifdef _WIN32
+    DCAMREC_OPENA recopen;
+#else
+    DCAMREC_OPEN  recopen;
+#endif
+    memset( &recopen, 0, sizeof(recopen) );
+    recopen.size               = sizeof(recopen);
+    recopen.path               = file_name.c_str();
+    recopen.ext                = "dcimg";
+    recopen.maxframepersession = nb_dcam_frames;
+
+#ifdef _WIN32
+    err = dcamrec_openA( &recopen );
+#else
+    err = dcamrec_open ( &recopen );
+#endif
+
+    if( failed(err) )
+    {
+        std::string errorText = static_manage_error( m_cam, deb, "Cannot create the recorder file", err, "dcamrec_open", "%s.dcimg", file_name.c_str());
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << "Cannot create the recorder file " << file_name << ".dcimg";
+    }
+
+    err = dcamcap_record( m_cam->m_camera_handle, recopen.hrec );
+
+    if( failed(err) )
+    {
+        dcamrec_close( recopen.hrec );
+
+        std::string errorText = static_manage_error( m_cam, deb, "Cannot attach the recorder to the capture", err, "dcamcap_record");
+        REPORT_EVENT(errorText);
+        THROW_HW_ERROR(Error) << "Cannot attach the recorder to the capture";
+    }
+
+    AutoMutex lock(m_rec_mutex);
+
+    m_rec_handle                   = recopen.hrec;
+    m_rec_start_time               = LatencyRecorder::now();
+    m_rec_frame_bytes              = m_alloc_frame_bytes;
+    m_rec_status.recording         = true ;
+    m_rec_status.file_name         = file_name;
+    m_rec_status.nb_frames         = 0    ;
+    m_rec_status.nb_missed         = 0    ;
+    m_rec_status.nb_missed_events  = 0    ;
+    m_rec_status.nb_skipped_events = 0    ;
+    m_rec_status.throughput        = 0.0  ;
+    m_rec_status.error.clear();
+
+    DEB_ALWAYS() << "Recording " << nb_dcam_frames << " DCAM frames in " << file_name << ".dcimg";
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::closeRecorder()
+// Close the recorder file of the acquisition (after dcamcap_stop).
+// Does nothing if no recorder is open. Does not throw exception.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::closeRecorder(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    AutoMutex lock(m_rec_mutex);
+
+    if(m_rec_handle == NULL)
+        return;
+
+    updateRecorderStatus();
+
+    DCAMERR err = dcamrec_close( m_rec_handle );
+
+    if( failed(err) )
+    {
+        std::string errorText = static_manage_error( m_cam, deb, "Cannot close the recorder file", err, "dcamrec_close");
+        REPORT_EVENT(errorText);
+    }
+
+    m_rec_handle           = NULL ;
+    m_rec_status.recording = false;
+
+    DEB_ALWAYS() << "Recorder file " << m_rec_status.file_name << ".dcimg closed: " << m_rec_status.nb_frames << " frames ("
+                 << m_rec_status.nb_missed << " missed), " << m_rec_status.throughput << " MB/s";
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::updateRecorderStatus()
+// Read the recorder counters (m_rec_mutex must be locked).
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::updateRecorderStatus(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_rec_handle == NULL)
+        return;
+
+    DCAMREC_STATUS recstatus;
+    memset( &recstatus, 0, sizeof(recstatus) );
+    recstatus.size = sizeof(recstatus);
+
+    if( failed( dcamrec_status( m_rec_handle, &recstatus ) ) )
+        return;
+
+    double elapsed = LatencyRecorder::now() - m_rec_start_time;
+
+    m_rec_status.nb_frames  = recstatus.totalframecount   ;
+    m_rec_status.nb_missed  = recstatus.missingframe_count;
+    m_rec_status.throughput = (elapsed > 0.0) ? (recstatus.totalframecount * m_rec_frame_bytes) / (elapsed * 1024.0 * 1024.0) : 0.0;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::manageRecorderEvents()
+// Count the recorder events of a wait. 
+// @return false if the recording cannot continue (disk full or write fault)
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::manageRecorderEvents(const int32 events) ///< [in] DCAMWAIT_RECEVENT_* events received
+{
+    DEB_MEMBER_FUNCT();
+
+    AutoMutex lock(m_rec_mutex);
+
+    if(events & DCAMWAIT_RECEVENT_MISSED)
+    {
+        ++m_rec_status.nb_missed_events;
+        DEB_WARNING() << "The recorder missed frames";
+    }
+
+    if(events & DCAMWAIT_RECEVENT_SKIPPED)
+    {
+        ++m_rec_status.nb_skipped_events;
+        DEB_WARNING() << "The recorder skipped frames";
+    }
+
+    if(events & DCAMWAIT_RECEVENT_DISKFULL)
+        m_rec_status.error = "Recorder disk full (" + m_rec_status.file_name + ".dcimg)";
+    else
+    if(events & DCAMWAIT_RECEVENT_WRITEFAULT)
+        m_rec_status.error = "Recorder write fault (" + m_rec_status.file_name + ".dcimg)";
+
+    return m_rec_status.error.empty();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getRecordingStatus()
+// Recorder state of the current (or latest) acquisition, can be called during the capture.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getRecordingStatus(RecordingStatus & out_status) ///< [out] recorder state of the current (or latest) acquisition
+{
+    AutoMutex lock(m_rec_mutex);
+
+    updateRecorderStatus();
+    out_status = m_rec_status;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getRawWriterStatus()
+// Raw stream state of the current (or latest) acquisition, can be called during the capture.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getRawWriterStatus(RawWriter::Status & out_status) ///< [out] raw stream state of the current (or latest) acquisition
+{
+    m_raw_writer.getStatus(out_status);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::isBuffersAllocated()
+// Check if the DCAM ring is allocated (or attached)
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::isBuffersAllocated(void) const
+{
+    return m_buffers_allocated;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::isZeroCopy()
+// Check if the DCAM ring of the current (or latest) acquisition is made of the lima buffers
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::isZeroCopy(void) const
+{
+    return m_zero_copy;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getBundleNumber()
+// Number of images in each DCAM frame of the current (or latest) acquisition
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::getBundleNumber(void) const
+{
+    return m_bundle_number;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getRingSize()
+// Number of frames in the DCAM ring buffer of the current (or latest) acquisition
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::getRingSize(void) const
+{
+    return m_ring_size;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getRingHighWater()
+// Maximum number of DCAM frames waiting to be copied during the current (or latest) acquisition
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::getRingHighWater(void) const
+{
+    return m_ring_high_water;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getAccExposure()
+// Exposure time of a hardware image of the current (or latest) acquisition (s)
+//---------------------------------------------------------------------------------------
+double Camera::CameraThread::getAccExposure(void) const
+{
+    return m_acc_exposure;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getExposureEvents()
+// Check if the status of the latest acquisition was driven by the exposure end events
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::getExposureEvents(void) const
+{
+    return m_exposure_events;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getLockedSize()
+// Memory of the lima buffers locked by the latest prefault (MB)
+//---------------------------------------------------------------------------------------
+double Camera::CameraThread::getLockedSize(void) const
+{
+    return m_locked_size;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getBuffersNode()
+// NUMA node holding most of the prefaulted lima buffers (-1: unknown)
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::getBuffersNode(void) const
+{
+    return m_buffers_node;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getClockOffset()
+// Offset between the host clock and the DCAM clock, false if it was not measured yet
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::getClockOffset(double & out_offset) ///< [out] host clock minus DCAM clock (s)
+{
+    if(!m_clock_offset_valid)
+        return false;
+
+    out_offset = m_clock_offset;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getFrameStamps()
+// Hardware stamps of one of the latest frames, false if the frame is too old or not
+// acquired yet. Can be called during the capture.
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::getFrameStamps(const int     in_frame_nb, ///< [in]  lima frame number
+                                          FrameStamps & out_stamps ) ///< [out] hardware stamps of the frame
+{
+    AutoMutex lock(m_frame_stamps_mutex);
+
+    const FrameStamps & stamps = m_frame_stamps[in_frame_nb % g_frame_stamps_size];
+
+    if(stamps.frame_nb != in_frame_nb)
+        return false;
+
+    out_stamps = stamps;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getFrameGaps()
+// Lost hardware frames of the current (or latest) acquisition, can be called during the capture.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getFrameGaps(std::vector<FrameGap> & out_gaps) ///< [out] lost hardware frames of the current (or latest) acquisition
+{
+    AutoMutex lock(m_frame_gaps_mutex);
+    out_gaps = m_frame_gaps;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getTriggerLatency()
+// Software trigger to frame latencies of the current (or latest) acquisition,
+// can be called during the capture.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getTriggerLatency(TriggerLatency & out_latency) ///< [out] software trigger to frame latencies
+{
+    AutoMutex lock(m_trigger_mutex);
+    out_latency = m_trigger_latency;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getExposureEnds()
+// Host time of the latest exposure end and number of exposure ends of the acquisition.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getExposureEnds(double & out_timestamp   , ///< [out] host time of the latest exposure end (s, 0 if none)
+                                           int &    out_nb_exposures) ///< [out] number of exposure ends since the acquisition start
+{
+    AutoMutex lock(m_exposure_end_mutex);
+
+    out_nb_exposures = m_nb_exposure_ends;
+    out_timestamp    = (out_nb_exposures > 0) ? static_cast<double>(m_last_exposure_end) : 0.0;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setThreadSettingsChanged()
+// Apply the priority and cpus of the camera at the next acquisition start.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setThreadSettingsChanged(void)
+{
+    m_thread_settings_changed = true;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getThreadSettings()
+// Effective priority and cpus of the acquisition thread.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getThreadSettings(std::string & out_settings) ///< [out] effective priority and cpus of the thread
+{
+    AutoMutex lock(m_thread_settings_mutex);
+    out_settings = m_thread_settings;
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setLatencyRecordEnabled()
+// Enable the per-frame latency records of the next acquisitions.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setLatencyRecordEnabled(const bool in_enabled) ///< [in] true to record the frames of the next acquisitions
+{
+    m_latency.setEnabled(in_enabled);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getLatencyRecordEnabled()
+// Check if the per-frame latencies are recorded.
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::getLatencyRecordEnabled(void) const
+{
+    return m_latency.isEnabled();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setLatencyRecordSize()
+// Set the number of latency records.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setLatencyRecordSize(const int in_nb_records) ///< [in] number of frames kept
+{
+    m_latency.setNbRecords(in_nb_records);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getLatencyRecordSize()
+// Get the number of latency records.
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::getLatencyRecordSize(void) const
+{
+    return m_latency.getNbRecords();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getLatencyStatistics()
+// Latency between two stages of the frames of the latest acquisition.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getLatencyStatistics(const LatencyRecorder::Stage in_from, ///< [in]  first stage
+                                                const LatencyRecorder::Stage in_to  , ///< [in]  last stage
+                                                int &    out_nb ,                     ///< [out] number of frames used
+                                                double & out_p50,                     ///< [out] median latency (s)
+                                                double & out_p99,                     ///< [out] 99th percentile latency (s)
+                                                double & out_max)                     ///< [out] maximum latency (s)
+{
+    m_latency.getLatencyStatistics(in_from, in_to, out_nb, out_p50, out_p99, out_max);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getQueueDepthStatistics()
+// Number of DCAM frames waiting in the ring each time the thread found new frames.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getQueueDepthStatistics(int & out_p50, ///< [out] median queue depth
+                                                   int & out_p99, ///< [out] 99th percentile
+                                                   int & out_max) ///< [out] maximum
+{
+    m_latency.getQueueDepthStatistics(out_p50, out_p99, out_max);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::dumpLatencyRecords()
+// Write the latency records of the latest acquisition in a CSV file.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::dumpLatencyRecords(const std::string & in_file_name) ///< [in] path of the CSV file to write
+{
+    m_latency.dump(in_file_name);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setMetricsWindow()
+// Set the time covered by the rolling metrics.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setMetricsWindow(const double in_window) ///< [in] time covered by the metrics (s)
+{
+    m_metrics.setWindow(in_window);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getMetricsWindow()
+// Get the time covered by the rolling metrics.
+//---------------------------------------------------------------------------------------
+double Camera::CameraThread::getMetricsWindow(void) const
+{
+    return m_metrics.getWindow();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getMetrics()
+// Rolling metrics of the latest window (ending now during an acquisition).
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getMetrics(RollingMetrics::Values & out_metrics) ///< [out] metrics of the latest window
+{
+    m_metrics.get(LatencyRecorder::now(), out_metrics);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setCopyThreads()
+// Set the number of threads copying the frames to the lima buffers.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setCopyThreads(const int in_nb_threads) ///< [in] number of copy threads (0: no thread)
+{
+    m_copy_pool.setNbThreads(in_nb_threads);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getCopyThreads()
+// Get the number of threads copying the frames to the lima buffers.
+//---------------------------------------------------------------------------------------
+int Camera::CameraThread::getCopyThreads(void) const
+{
+    return m_copy_pool.getNbThreads();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::setCopySplitThreshold()
+// Set the frame size from which a frame is copied by several threads.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::setCopySplitThreshold(const size_t in_threshold) ///< [in] frame size from which a frame is copied by several threads (0: never)
+{
+    m_copy_pool.setSplitThreshold(in_threshold);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getCopySplitThreshold()
+// Get the frame size from which a frame is copied by several threads.
+//---------------------------------------------------------------------------------------
+size_t Camera::CameraThread::getCopySplitThreshold(void) const
+{
+    return m_copy_pool.getSplitThreshold();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::getRawWriterDefaults()
+// Default settings of the raw writer, used to initialize the camera settings.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::getRawWriterDefaults(long long & out_file_size, ///< [out] default size of the raw files (bytes)
+                                                int &       out_nb_slots , ///< [out] default number of frame slots of the writer
+                                                bool &      out_direct_io) const ///< [out] default use of the direct I/O
+{
+    out_file_size = m_raw_writer.getFileSize();
+    out_nb_slots  = m_raw_writer.getNbSlots ();
+    out_direct_io = m_raw_writer.getDirectIoEnabled();
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::readSnapshot()
+// Copy of the latest frame for the viewers, false if no frame was received yet.
+// Never blocks the acquisition.
+//---------------------------------------------------------------------------------------
+bool Camera::CameraThread::readSnapshot(FrameSnapshot::Info & out_info, ///< [out] stamps of the latest frame
+                                        std::vector<char>   & out_data) ///< [out] pixels of the latest frame
+{
+    return m_snapshot.read(out_info, out_data);
+}
+
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::fireSoftwareTrigger()
+// Fire the software trigger of the next frame of an IntTrigMult acquisition 
+// (startAcq calls after the first one). Called by the lima thread.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::fireSoftwareTrigger(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    {
+        AutoMutex lock(m_trigger_mutex);
+        m_trigger_times.push_back(LatencyRecorder::now());
+        ++m_trigger_latency.nb_triggers;
+    }
+
+    DCAMERR err = dcamcap_firetrigger( m_cam->m_camera_handle, 0 );
+
+    if( failed(err) )
+    {
+        {
+            AutoMutex lock(m_trigger_mutex);
+            m_trigger_times.pop_back();
+            --m_trigger_latency.nb_triggers;
+        }
 
-        std::string errorText = static_manage_error( m_cam, deb, "Cannot start the capture", err, "dcamcap_start");
+        std::string errorText = static_manage_error( m_cam, deb, "Cannot fire the software trigger", err, "dcamcap_firetrigger");
         REPORT_EVENT(errorText);
-        THROW_HW_ERROR(Error) << "Frame capture failed";
+        THROW_HW_ERROR(Error) << "Cannot fire the software trigger";
     }
 
-    //-----------------------------------------------------------------------------
-    // Transfer the images as they are beeing captured from dcam_sdk buffer to Lima
-    //-----------------------------------------------------------------------------
-    // Timestamp before DCAM "snapshot"
-    T0 = Timestamp::now();
+    // the exposure events give the end of the exposure
+    if (m_exposure_events)
+        setStatus(CameraThread::Exposure);
+}
 
-    m_cam->m_lost_frames_count = 0;
+//---------------------------------------------------------------------------------------
+//! Camera::CameraThread::recordTriggerLatency()
+// Match a received frame with its software trigger (the hardware frame n is the frame of
+// the trigger n, the triggers of the lost frames are dropped) and update the latencies.
+//---------------------------------------------------------------------------------------
+void Camera::CameraThread::recordTriggerLatency(const int hw_frame) ///< [in] hardware number of the DCAM frame received
+{
+    AutoMutex lock(m_trigger_mutex);
 
-    int32 lastFrameCount = 0 ;
-    int32 frame_count     = 0 ;
-    int32 lastFrameIndex = -1;
-    int32 frame_index     = 0 ;
-    
-    // Main acquisition loop
-    while (    ( continue_acq )    &&
-            ( (0==m_cam->m_nb_frames) || (m_cam->m_image_number < m_cam->m_nb_frames) ) )
+    while ((!m_trigger_times.empty()) && (m_trigger_base < hw_frame))
+    {
+        m_trigger_times.pop_front();
+        ++m_trigger_base;
+    }
+
+    if (m_trigger_times.empty() || (m_trigger_base != hw_frame))
+        return;
+
+    double latency = m_wait_time - m_trigger_times.front();
+
+    m_trigger_times.pop_front();
+    ++m_trigger_base;
+
+    TriggerLatency & stats = m_trigger_latency;
+
+    if ((stats.nb_frames == 0) || (latency < stats.min))
+        stats.min = latency;
+
+    if ((stats.nb_frames == 0) || (latency > stats.max))
+        stats.max = latency;
+
+    ++stats.nb_frames;
+    m_trigger_latency_sum += latency;
+
+    stats.last = latency;
+    stats.mean = m_trigger_latency_sum / stats.nb_frames;
+}
+
+//-----------------------------------------------------------------------------
+/// Return the current number of views for this camera
+//-----------------------------------------------------------------------------
+int Camera::getNumberofViews(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err   ;
+    int32   nView = 0  ;
+    double  v     = 0.0;
+
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_NUMBEROF_VIEW, &v );
+    if( failed(err) )
+    {
+        manage_trace( deb, "Unable to retrieve the number of possible W-VIEW", err, "dcamprop_getvalue - DCAM_IDPROP_NUMBEROF_VIEW");
+    }
+    else    
+    {
+        nView = static_cast<int32>(v);
+    }
+
+    DEB_TRACE() << DEB_VAR1(nView);
+
+    return  nView;
+}
+
+//-----------------------------------------------------------------------------
+/// Return the maximum number of views for this camera
+//-----------------------------------------------------------------------------
+int Camera::getMaxNumberofViews(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    FeatureInfos feature_obj;
+    int32        nView     = 0;
+
+    if( !dcamex_getfeatureinq( m_camera_handle, "DCAM_IDPROP_NUMBEROF_VIEW", DCAM_IDPROP_NUMBEROF_VIEW, feature_obj ) )
+    {
+        manage_trace( deb, "Failed to get number of view");
+    }
+    else
+    {
+        DEB_TRACE() << g_trace_line_separator.c_str();
+        feature_obj.traceGeneralInformations();
+
+        nView = static_cast<int32>(feature_obj.m_max);
+    }
+
+    DEB_TRACE() << DEB_VAR1(nView);
+
+    return  nView;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the W-VIEW mode
+//-----------------------------------------------------------------------------
+void Camera::setViewMode(bool in_view_mode_activated, ///< [in] view mode activation or not
+                         int  in_views_number      ) ///< [in] number of views if view mode activated
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(in_view_mode_activated, in_views_number);
+
+    if(in_view_mode_activated && (!m_regions.empty()))
     {
-        setStatus(CameraThread::Exposure);
+        THROW_HW_ERROR(Error) << "The W-VIEW mode is not possible with the multi-region readout!";
+    }
 
-        // Check first if acq. has been stopped
-        if (m_force_stop)
-        {
-            //abort the current acquisition
-            continue_acq  = false;
-            m_force_stop = false;
-            continue;
-        }
+    m_thread.releasePreparedBuffers(); // the image layout can change
 
-        // Wait for the next image to become available or the end of the capture by user
-        // set wait param
-        DCAMWAIT_START waitstart;
-        memset( &waitstart, 0, sizeof(DCAMWAIT_START) );
-        waitstart.size        = sizeof(DCAMWAIT_START);
-        waitstart.eventmask    = DCAMWAIT_CAPEVENT_FRAMEREADY | DCAMWAIT_CAPEVENT_STOPPED;
-        waitstart.timeout    = DCAMWAIT_TIMEOUT_INFINITE;
+    DCAMERR  err;
+    bool     split_active = isViewSplitActive();
+    bool     view_rois    = !m_view_rois.empty();
 
-        // wait image
-        err = dcamwait_start( m_wait_handle, &waitstart );
+    m_view_rois.clear(); // the views go back to whole views
 
-        if( failed(err) )
+    if(in_view_mode_activated)
+    {
+        if(m_max_views > 1)
         {
-            // If capture was aborted (by stopAcq() -> dcam_idle())
-            if (DCAMERR_ABORT == err)
+            // checking if the W-View mode is possible for this camera
+            if( m_max_views < in_views_number )
             {
-                DEB_TRACE() << "DCAMERR_ABORT";
-                continue_acq = false;
-                continue;
+                manage_error( deb, "Unable to activate W-VIEW mode", DCAMERR_NONE, NULL, "max views number %d, needed %d", m_max_views, in_views_number);
+                THROW_HW_ERROR(Error) << "Unable to activate W-VIEW mode";
             }
-            else 
-            if (DCAMERR_TIMEOUT == err)
-            {
-                dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
-                releaseWaitHandle( m_wait_handle           );        
-                dcambuf_release  ( m_cam->m_camera_handle ); // Release the capture frame
-                setStatus        ( CameraThread::Fault    );
 
-                std::string errorText = static_manage_error( m_cam, deb, "Error during the frame capture wait", err, "dcamwait_start");
-                REPORT_EVENT(errorText);
+            // set split view mode
+            err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_SENSORMODE, static_cast<double>(DCAMPROP_SENSORMODE__SPLITVIEW) );
 
-                THROW_HW_ERROR(Error) << "DCAMERR_TIMEOUT";
-            }
-            else
-            if(( DCAMERR_LOSTFRAME == err) || (DCAMERR_MISSINGFRAME_TROUBLE == err) )
+            if( failed(err) )
             {
-                static_manage_error( m_cam, deb, "Error during the frame capture wait", err, "dcamwait_start");
-                ++m_cam->m_lost_frames_count;
-                continue;
+                manage_error( deb, "Unable to activate W-VIEW mode", err, 
+                                   "dcamprop_setvalue", "DCAM_IDPROP_SENSORMODE - DCAMPROP_SENSORMODE__SPLITVIEW");
+                THROW_HW_ERROR(Error) << "Unable to activate W-VIEW mode";
             }
-            else
-            {                    
-                dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
-                releaseWaitHandle( m_wait_handle           );        
-                dcambuf_release  ( m_cam->m_camera_handle ); // Release the capture frame
-                setStatus        ( CameraThread::Fault    );
 
-                std::string errorText = static_manage_error( m_cam, deb, "Error during the frame capture wait", err, "dcamwait_start");
-                REPORT_EVENT(errorText);
-                THROW_HW_ERROR(Error) << "Error during the frame capture wait";
-            }
+            m_view_mode_enabled = true          ; // W-View mode with splitting image
+            m_view_number      = in_views_number; // number of W-Views
+
+            manage_trace( deb, "W-VIEW mode activated", DCAMERR_NONE, NULL, "views number %d", in_views_number);
         }
         else
-        // wait succeeded
+        // W-View is not supported for this camera
         {
-            if (waitstart.eventhappened & DCAMWAIT_CAPEVENT_STOPPED)
-            {
-                DEB_TRACE() << "DCAM_EVENT_CAPTUREEND";
-                continue_acq = false;
-                continue;
-            }
+            manage_error( deb, "Cannot set the W-View mode - This camera does not support the W-View mode.", DCAMERR_NONE);
+            THROW_HW_ERROR(Error) << "Cannot set the W-View mode - This camera does not support the W-View mode.";
         }
+    }
+    else
+    // unactivated
+    {
+        // set area mode
+        err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_SENSORMODE, static_cast<double>(DCAMPROP_SENSORMODE__AREA) );
 
-        if (m_force_stop)
+        if( failed(err) )
         {
-            //abort the current acqusition
-            continue_acq  = false;
-            m_force_stop = false;
-            break;
+            manage_error( deb, "Unable to activate AREA mode", err, 
+                               "dcamprop_setvalue", "DCAM_IDPROP_SENSORMODE - DCAMPROP_SENSORMODE__AREA");
+            THROW_HW_ERROR(Error) << "Unable to activate AREA mode";
         }
 
-        // Transfert the new images
-        setStatus(CameraThread::Readout);
-        
-        int32 deltaFrames = 0;
-
-        getTransfertInfo(frame_index, frame_count);
-
-        // manage the frame info
+        // if view mode was activated, we rewrite the exposure time
+        if (m_view_mode_enabled)
         {
-            deltaFrames = frame_count-lastFrameCount;
-            DEB_TRACE() << g_trace_little_line_separator.c_str();
-            DEB_TRACE() << "(m_image_number:"  << m_cam->m_image_number << ")"
-                        << " (lastFrameIndex:" << lastFrameIndex        << ")" 
-                        << " (frame_index:"    << frame_index           << ")" 
-                        << " (frame_count:"    << frame_count           << ")"
-                        << " (deltaFrames:"    << deltaFrames           << ")";
-
-            if (0 == frame_count)
-            {
-                dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
-                releaseWaitHandle( m_wait_handle           );        
-                dcambuf_release  ( m_cam->m_camera_handle ); // Release the capture frame
-                setStatus        ( CameraThread::Fault    );
-
-                std::string errorText = "No image captured.";
-                DEB_ERROR() << errorText;
-                REPORT_EVENT(errorText);
-                THROW_HW_ERROR(Error) << "No image captured.";
-            }
-            if (deltaFrames > m_cam->m_frame_buffer_size)
-            {
-                m_cam->m_lost_frames_count += deltaFrames;
-                DEB_TRACE() << "deltaFrames > m_frame_buffer_size (" << deltaFrames << ")";
-            }
-            lastFrameCount = frame_count;
+            setExpTime(m_exp_time); // rewrite the value in the camera
         }
 
-        // Check if acquisition was stopped & abort the current acqusition
-        if (m_force_stop)
-        {
-            continue_acq  = false;
-            m_force_stop = false;
-            break;
-        }
+        m_view_mode_enabled = false; // W-View mode with splitting image
+        m_view_number      = 0    ; // number of W-Views
 
-        int nbFrameToCopy = 0;
+        manage_trace( deb, "W-VIEW mode unactivated");
+    }
 
-        try
-        {
-            m_cam->m_mutex_force_stop.lock();
+    // the lima frame changes between one view and the whole frame
+    if((split_active != isViewSplitActive()) || view_rois)
+        updateMaxImageSize();
+}
 
-            // Copy frames from DCAM_SDK to LiMa
-            nbFrameToCopy  = (deltaFrames < m_cam->m_frame_buffer_size) ? deltaFrames : m_cam->m_frame_buffer_size; // if more than m_frame_buffer_size have arrived
+//-----------------------------------------------------------------------------
+/// Give each of the two W-Views as its own lima frame: the lima frames of a 
+/// hardware image are its first view (even frame numbers) then its second 
+/// view (odd frame numbers), copied from the top of each view in the DCAM 
+/// frame. The lima frame is one view and the lima roi is the roi of the views.
+/// Only used in W-VIEW mode with two views.
+//-----------------------------------------------------------------------------
+void Camera::setViewSplitEnabled(const bool in_enabled) ///< [in] true to give each view of the two W-Views as its own lima frame
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
 
-            continue_acq    = copyFrames( (lastFrameIndex+1)% m_cam->m_frame_buffer_size, // index of the first image to copy from the ring buffer
-                                          nbFrameToCopy,
-                                          buffer_mgr);
-            lastFrameIndex = frame_index;
-        }
-        catch (...)
-        {
-            // be sure to unlock the mutex before throwing the exception!
-            m_cam->m_mutex_force_stop.unlock();
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the W-View split mode during an acquisition!";
+    }
 
-            dcamcap_stop     ( m_cam->m_camera_handle ); // Stop the acquisition
-            releaseWaitHandle( m_wait_handle           );        
-            dcambuf_release  ( m_cam->m_camera_handle ); // Release the capture frame
-            setStatus        ( CameraThread::Fault    );
+    m_thread.releasePreparedBuffers(); // the image layout can change
 
-            throw;
-        }
+    bool split_active = isViewSplitActive();
 
-        m_cam->m_mutex_force_stop.unlock();
-        
-        // Update fps 
-        T1     = Timestamp::now();
-        DeltaT = T1 - T0;
+    m_view_split = in_enabled;
 
-        if (DeltaT > 0.0)
-            m_cam->m_fps = m_cam->m_image_number / DeltaT;
+    // the lima frame changes between one view and the whole frame
+    if(split_active != isViewSplitActive())
+        updateMaxImageSize();
+}
 
-    } // end of acquisition loop
+//-----------------------------------------------------------------------------
+/// Check if each of the two W-Views is given as its own lima frame
+//-----------------------------------------------------------------------------
+bool Camera::getViewSplitEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_view_split;
+}
 
-    // Stop the acquisition
-    err = dcamcap_stop( m_cam->m_camera_handle);
+//-----------------------------------------------------------------------------
+/// Get the W-View of a recent lima frame in split mode (0: first view, 
+/// 1: second view). The view frame number is the lima frame number / 2.
+//-----------------------------------------------------------------------------
+int Camera::getFrameView(const int in_frame_nb) ///< [in] lima frame number
+{
+    DEB_MEMBER_FUNCT();
 
-    if( failed(err) )
+    if(in_frame_nb < 0)
     {
-        releaseWaitHandle( m_wait_handle           );        
-        dcambuf_release  ( m_cam->m_camera_handle ); // Release the capture frame
-        setStatus        ( CameraThread::Fault    );
+        THROW_HW_ERROR(Error) << "Incorrect frame number: " << in_frame_nb;
+    }
 
-        std::string errorText = static_manage_error( m_cam, deb, "Cannot stop acquisition.", err, "dcamcap_stop");
-        REPORT_EVENT(errorText);
-        THROW_HW_ERROR(Error) << "Cannot stop acquisition.";
+    CameraThread::FrameStamps stamps;
+
+    if(!m_thread.getFrameStamps(in_frame_nb, stamps))
+    {
+        THROW_HW_ERROR(Error) << "No information for the frame " << in_frame_nb << " (too old or not acquired yet)";
     }
 
-    // release the wait handle
-    releaseWaitHandle( m_wait_handle );        
+    return stamps.view;
+}
+
+//-----------------------------------------------------------------------------
+/// Set an independent subarray for each of the two W-Views, in sensor pixels 
+/// of the view, so only the needed part of each view is read out. 
+/// The DCAM subarray size is common to the views: the two subarrays must have
+/// the same size, only their positions differ. Each position is checked with
+/// the subarray steps of its view. The lima frame is the two subarrays one 
+/// under the other (one subarray in split mode) and the lima roi can only be 
+/// the full frame. An empty list goes back to the whole views.
+/// Only used in W-VIEW mode with two views.
+//-----------------------------------------------------------------------------
+void Camera::setViewRois(const std::vector<Roi> & in_view_rois) ///< [in] subarray of each of the two W-Views (empty: whole views)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the W-View subarrays during an acquisition!";
+    }
 
-    // Release the capture frame
-    err = dcambuf_release( m_cam->m_camera_handle );
+    if((!m_view_mode_enabled) || (m_view_number != 2))
+    {
+        THROW_HW_ERROR(Error) << "The W-View subarrays need the W-VIEW mode with two views!";
+    }
 
-    if( failed(err) )
+    if((!in_view_rois.empty()) && (in_view_rois.size() != 2))
     {
-        setStatus(CameraThread::Fault);
-        std::string errorText = static_manage_error( m_cam, deb, "Unable to free capture frame", err, "dcambuf_release");
-        REPORT_EVENT(errorText);
-        THROW_HW_ERROR(Error) << "Unable to free capture frame";
+        THROW_HW_ERROR(Error) << "Two W-View subarrays are needed, " << in_view_rois.size() << " given!";
     }
-    else
+
+    int view_height = m_max_image_height / 2;
+
+    for(size_t view_index = 0 ; view_index < in_view_rois.size() ; view_index++)
     {
-        DEB_TRACE() << "dcambuf_release success.";
+        const Roi & view_roi = in_view_rois[view_index];
+        Point       top      = view_roi.getTopLeft();
+        Size        size     = view_roi.getSize   ();
+
+        if((size.getWidth() <= 0) || (size.getHeight() <= 0) || (top.x < 0) || (top.y < 0) ||
+           (top.x + size.getWidth () > m_max_image_width) ||
+           (top.y + size.getHeight() > view_height      ))
+        {
+            THROW_HW_ERROR(Error) << "Invalid subarray for the view " << (view_index + 1) << ": " << view_roi;
+        }
+
+        if((size.getWidth () != in_view_rois[0].getSize().getWidth ()) ||
+           (size.getHeight() != in_view_rois[0].getSize().getHeight()))
+        {
+            THROW_HW_ERROR(Error) << "The two W-View subarrays must have the same size (the DCAM subarray size is common to the views)!";
+        }
+
+        // the position is rounded with the subarray steps of the view when the camera gives them
+        FeatureInfos feature_pos_x = m_feature_pos_x;
+        FeatureInfos feature_pos_y = m_feature_pos_y;
+
+        if(m_feature_pos_x.m_has_view)
+            dcamex_getfeatureinq(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS (view)", DCAM_IDPROP_VIEW_((view_index + 1), DCAM_IDPROP_SUBARRAYHPOS), feature_pos_x);
+
+        if(m_feature_pos_y.m_has_view)
+            dcamex_getfeatureinq(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS (view)", DCAM_IDPROP_VIEW_((view_index + 1), DCAM_IDPROP_SUBARRAYVPOS), feature_pos_y);
+
+        int x      = top.x;
+        int y      = top.y;
+        int width  = size.getWidth ();
+        int height = size.getHeight();
+
+        feature_pos_x.RoundValue   (x     );
+        feature_pos_y.RoundValue   (y     );
+        m_feature_size_x.RoundValue(width );
+        m_feature_size_y.RoundValue(height);
+
+        if(view_roi != Roi(x, y, width, height))
+        {
+            manage_error( deb, "This W-View subarray is not a valid one.", DCAMERR_NONE, "setViewRois");
+            THROW_HW_ERROR(Error) << "The subarray of the view " << (view_index + 1) << " is not a valid one. Please try (" 
+                                  << x << ", " << y << ", " << width << ", " << height << ")";
+        }
     }
 
-    DEB_ALWAYS() << g_trace_line_separator.c_str();
-    DEB_ALWAYS() << "Total time (s): " << (T1 - T0);
-    DEB_ALWAYS() << "FPS           : " << int(m_cam->m_image_number / (T1 - T0) );
-    DEB_ALWAYS() << "Lost frames   : " << m_cam->m_lost_frames_count; 
-    DEB_ALWAYS() << g_trace_line_separator.c_str();
+    m_thread.releasePreparedBuffers(); // the image layout changes
+
+    m_view_rois = in_view_rois;
+
+    // programs the views subarrays with the full frame roi
+    Size max_image_size;
+    getDetectorMaxImageSize(max_image_size);
+
+    setRoi(Roi(Point(0, 0), Size(max_image_size.getWidth() / m_bin.getX(), max_image_size.getHeight() / m_bin.getY())));
+
+    updateMaxImageSize();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the subarray of each of the two W-Views (empty: whole views)
+//-----------------------------------------------------------------------------
+void Camera::getViewRois(std::vector<Roi> & out_view_rois) ///< [out] subarray of each of the two W-Views (empty: whole views)
+{
+    DEB_MEMBER_FUNCT();
+    out_view_rois = m_view_rois;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the lima frames are the W-Views of the hardware images
+//-----------------------------------------------------------------------------
+bool Camera::isViewSplitActive(void) const
+{
+    return (m_view_split && m_view_mode_enabled && (m_view_number == 2));
+}
+
+//-----------------------------------------------------------------------------
+/// Give the current lima frame size (whole frame, view or packed regions) to
+/// lima, which reallocates its buffers.
+//-----------------------------------------------------------------------------
+void Camera::updateMaxImageSize(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    Size      max_image_size;
+    ImageType image_type    ;
+
+    getDetectorMaxImageSize(max_image_size);
+    getImageType(image_type);
+
+    maxImageSizeChanged(max_image_size, image_type);
+}
+
+//-----------------------------------------------------------------------------
+/// Set the W-VIEW mode
+//-----------------------------------------------------------------------------
+void Camera::setViewMode(bool flag)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(flag);
 
-    setStatus(CameraThread::Ready);
-    DEB_TRACE() << "CameraThread::execStartAcq - END";
+    setViewMode(flag, 2); // 2 views max for ORCA
 }
 
 //-----------------------------------------------------------------------------
-// Copy the given frames to the buffer manager
+/// Get the W-VIEW mode
 //-----------------------------------------------------------------------------
-bool Camera::CameraThread::copyFrames(const int        index_frame_begin, ///< [in] index of the frame where to begin copy
-                                      const int        nb_frames_count, ///< [in] number of frames to copy
-                                      StdBufferCbMgr & buffer_mgr ) ///< [in] buffer manager object
+void Camera::getViewMode(bool& flag)
 {
     DEB_MEMBER_FUNCT();
-    
-    DEB_TRACE() << "copyFrames(" << index_frame_begin << ", nb:" << nb_frames_count << ")";
-
-    DCAMERR  err         ;
-    FrameDim frame_dim   = buffer_mgr.getFrameDim();
-    Size     frame_size  = frame_dim.getSize     ();
-    int      height      = frame_size.getHeight  ();
-    int      memSize     = frame_dim.getMemSize  ();
-    bool     CopySuccess = false                   ;
-    int      iFrameIndex = index_frame_begin             ; // Index of frame in the DCAM cycling buffer
 
-    for  (int cptFrame = 1 ; cptFrame <= nb_frames_count ; cptFrame++)
+    if(getStatus() == CameraThread::Ready)
     {
-        void     * dst         = buffer_mgr.getFrameBufferPtr(m_cam->m_image_number);
-        void     * src         ;
-        long int   sRowbytes   ;
-        bool       bImageCopied;
-
-        // prepare frame stucture
-        DCAMBUF_FRAME bufframe;
-        memset( &bufframe, 0, sizeof(bufframe) );
-        bufframe.size    = sizeof(bufframe);
-        bufframe.iFrame    = iFrameIndex     ;
+        double  sensor_mode;
+        DCAMERR err        ;
 
-        // access image
-        err = dcambuf_lockframe( m_cam->m_camera_handle, &bufframe );
+        err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORMODE, &sensor_mode);
 
         if( failed(err) )
         {
-            bImageCopied = false;
-            setStatus(CameraThread::Fault);
-
-            std::string errorText = static_manage_error( m_cam, deb, "Unable to lock frame data", err, "dcambuf_lockframe");
-            REPORT_EVENT(errorText);
-            THROW_HW_ERROR(Error) << "Unable to lock frame data";
+            manage_error( deb, "Cannot get sensor mode", err, 
+                          "dcamprop_getvalue", "IDPROP=DCAM_IDPROP_SENSORMODE");
+            THROW_HW_ERROR(Error) << "Cannot get sensor mode";
         }
-        else
-        {
-            sRowbytes = bufframe.rowbytes;
-            src       = bufframe.buf     ;
 
-            if(sRowbytes * height != memSize)
-            {
-                bImageCopied = false;
-                static_manage_trace( m_cam, deb, "Incoherent sizes during frame copy process", DCAMERR_NONE,
-                                     "copyFrames", "source size %d, dest size %d", memSize, sRowbytes * height);
-            }
-            else
-            {
-                memcpy( dst, src, sRowbytes * height );
-                bImageCopied = true;
-
-            #ifdef HAMAMATSU_CAMERA_DEBUG_ACQUISITION
-                DEB_TRACE() << "Acquired (m_image_number:" << m_cam->m_image_number << ")"
-                            << " (frame_index:"            << iFrameIndex           << ")" 
-                            << " (rowbytes:"               << sRowbytes             << ")"
-                            << " (height:"                 << height                << ")";
-            #endif
-            }
-        }
+        flag = (static_cast<int>(sensor_mode) == DCAMPROP_SENSORMODE__SPLITVIEW);
+    }
+    else
+    // do not call the sdk functions during acquisition
+    {
+        flag = m_view_mode_enabled;
+    }
+}
 
-        if (!bImageCopied)
-        {
-            setStatus(CameraThread::Fault);
-            CopySuccess = false;
+//-----------------------------------------------------------------------------
+/// Set the new exposure time for a view
+//-----------------------------------------------------------------------------
+void Camera::setViewExpTime(int    view_index, ///< [in] view index [0...m_max_views[
+                            double exp_time  ) ///< [in] exposure time to set
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(view_index, exp_time);
 
-            std::string errorText = static_manage_error( m_cam, deb, "Cannot get image.", DCAMERR_NONE, "copyFrames");
-            REPORT_EVENT(errorText);
-            THROW_HW_ERROR(Error) << "Cannot get image.";
-            break;
+    DCAMERR err;
+
+    // W-View is not supported for this camera
+    if(m_max_views < 2)
+    {
+        manage_error( deb, "Cannot set view exposure time - This camera does not support the W-View mode.", DCAMERR_NONE);
+        THROW_HW_ERROR(Error) << "Cannot set view exposure time - This camera does not support the W-View mode.";
+    }
+    else
+    if(view_index < m_max_views)
+    {
+        // Changing a View exposure time is not allowed if W-VIEW mode is not activated but we keep the value
+        if(!m_view_mode_enabled)
+        {
+            manage_error( deb, "Cannot change W-View exposure time when W-VIEW mode is unactivated!", DCAMERR_NONE, "setViewExpTime");
         }
         else
         {
-            HwFrameInfoType frame_info;
-            frame_info.acq_frame_nb = m_cam->m_image_number;        
+            // set the exposure time
+            err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_VIEW_((view_index + 1), DCAM_IDPROP_EXPOSURETIME), exp_time);
 
-            // Make the new frame available
-            if ( (0==m_cam->m_nb_frames) || (m_cam->m_image_number < m_cam->m_nb_frames) )
+            if( failed(err) )
             {
-                CopySuccess = buffer_mgr.newFrameReady(frame_info);
-                ++m_cam->m_image_number;
+                manage_error( deb, "Cannot set view exposure time", err, 
+                              "dcamprop_setvalue", "IDPROP=DCAM_IDPROP_EXPOSURETIME, VIEW INDEX=%d, VALUE=%lf", view_index, exp_time);
+                THROW_HW_ERROR(Error) << "Cannot set view exposure time";
             }
 
-            // Done capturing (SNAP)
-            if ( (m_cam->m_image_number == m_cam->m_nb_frames) && (0!=m_cam->m_nb_frames))
-            {
-                DEB_TRACE() << "All images captured.";
-                break;
-            }
+            double temp_exp_time;
+            getViewExpTime(view_index, temp_exp_time);
+            manage_trace( deb, "Changed View Exposure time", DCAMERR_NONE, NULL, "views index %d, exp:%lf >> real:%lf", view_index, exp_time, temp_exp_time);
         }
 
-        iFrameIndex = (iFrameIndex+1) % m_cam->m_frame_buffer_size;
+        m_view_exp_time[view_index] = exp_time;
+    }
+    else
+    {
+        manage_error( deb, "Cannot set view exposure time", DCAMERR_NONE, 
+                      "", "VIEW INDEX=%d, MAX VIEWS=%d", view_index, m_max_views);
+        THROW_HW_ERROR(Error) << "Cannot set view exposure time";
     }
-
-    DEB_TRACE() << DEB_VAR1(CopySuccess);
-    return CopySuccess;
 }
 
 //-----------------------------------------------------------------------------
-/// Return the current number of views for this camera
+/// Get the current exposure time for a view
 //-----------------------------------------------------------------------------
-int Camera::getNumberofViews(void)
+void Camera::getViewExpTime(int      view_index, ///< [in] view index [0...m_max_views[
+                            double & exp_time  ) ///< [out] current exposure time
 {
     DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(view_index);
 
-    DCAMERR err   ;
-    int32   nView = 0  ;
-    double  v     = 0.0;
+    DCAMERR err;
 
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_NUMBEROF_VIEW, &v );
-    if( failed(err) )
+    // W-View is not supported for this camera
+    if(m_max_views < 2)
     {
-        manage_trace( deb, "Unable to retrieve the number of possible W-VIEW", err, "dcamprop_getvalue - DCAM_IDPROP_NUMBEROF_VIEW");
+        exp_time = m_exp_time;
     }
-    else    
+    else
+    if(view_index < m_max_views)
     {
-        nView = static_cast<int32>(v);
-    }
+        double exposure;
 
-    DEB_TRACE() << DEB_VAR1(nView);
+        // if W-VIEW mode is not activated we cannot retrieve the current value 
+        if(!m_view_mode_enabled)
+        {
+            exposure = m_view_exp_time[view_index];
+        }
+        else
+        if(getStatus() == CameraThread::Ready)
+        {
+            err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_VIEW_((view_index + 1), DCAM_IDPROP_EXPOSURETIME), &exposure);
 
-    return  nView;
+            if( failed(err) )
+            {
+                manage_error( deb, "Cannot get view exposure time", err, 
+                              "dcamprop_getvalue", "IDPROP=DCAM_IDPROP_EXPOSURETIME, VIEW INDEX=%d", view_index);
+                THROW_HW_ERROR(Error) << "Cannot get view exposure time";
+            }
+        }
+        else
+        // do not call the sdk functions during acquisition
+        {
+            exposure = m_view_exp_time[view_index];
+        }
+
+        exp_time = exposure;
+    }
+    else
+    {
+        manage_error( deb, "Cannot get view exposure time", DCAMERR_NONE, 
+                      "", "VIEW INDEX=%d, MAX VIEWS=%d", view_index, m_max_views);
+        THROW_HW_ERROR(Error) << "Cannot get view exposure time";
+    }
 }
 
 //-----------------------------------------------------------------------------
-/// Return the maximum number of views for this camera
+/// Get the minimum exposure time of all views
 //-----------------------------------------------------------------------------
-int Camera::getMaxNumberofViews(void)
+void Camera::getMinViewExpTime(double& exp_time) ///< [out] current exposure time
 {
     DEB_MEMBER_FUNCT();
 
-    FeatureInfos feature_obj;
-    int32        nView     = 0;
+    // the exposure is the minimum of the views'exposure values
+    int    view_index   = 0   ;
+    double exposure     = -1.0; // we search the minimum value - this is the not set value
+    double view_exposure; 
 
-    if( !dcamex_getfeatureinq( m_camera_handle, "DCAM_IDPROP_NUMBEROF_VIEW", DCAM_IDPROP_NUMBEROF_VIEW, feature_obj ) )
-    {
-        manage_trace( deb, "Failed to get number of view");
-    }
-    else
+    if(m_max_views > 1)
     {
-        DEB_TRACE() << g_trace_line_separator.c_str();
-        feature_obj.traceGeneralInformations();
+        while(view_index < m_max_views)
+        {
+            getViewExpTime(view_index, view_exposure);
+            
+            if((exposure == -1.0) || (view_exposure < exposure))
+                exposure = view_exposure; // sets the new minimum
 
-        nView = static_cast<int32>(feature_obj.m_max);
+            view_index++;
+        }
     }
 
-    DEB_TRACE() << DEB_VAR1(nView);
-
-    return  nView;
+    exp_time = exposure;
 }
 
 //-----------------------------------------------------------------------------
-/// Set the W-VIEW mode
+/// Set the new exposure time for the first view
 //-----------------------------------------------------------------------------
-void Camera::setViewMode(bool in_view_mode_activated, ///< [in] view mode activation or not
-                         int  in_views_number      ) ///< [in] number of views if view mode activated
+void Camera::setViewExpTime1(double exp_time ) ///< [in] exposure time to set
 {
-    DEB_MEMBER_FUNCT();
-    DEB_PARAM() << DEB_VAR2(in_view_mode_activated, in_views_number);
-
-    DCAMERR  err;
-
-    if(in_view_mode_activated)
-    {
-        if(m_max_views > 1)
-        {
-            // checking if the W-View mode is possible for this camera
-            if( m_max_views < in_views_number )
-            {
-                manage_error( deb, "Unable to activate W-VIEW mode", DCAMERR_NONE, NULL, "max views number %d, needed %d", m_max_views, in_views_number);
-                THROW_HW_ERROR(Error) << "Unable to activate W-VIEW mode";
-            }
+    setViewExpTime(0, exp_time );
+}
 
-            // set split view mode
-            err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_SENSORMODE, static_cast<double>(DCAMPROP_SENSORMODE__SPLITVIEW) );
+//-----------------------------------------------------------------------------
+/// Set the new exposure time for the second view
+//-----------------------------------------------------------------------------
+void Camera::setViewExpTime2(double exp_time ) ///< [in] exposure time to set
+{
+    setViewExpTime(1, exp_time );
+}
 
-            if( failed(err) )
-            {
-                manage_error( deb, "Unable to activate W-VIEW mode", err, 
-                                   "dcamprop_setvalue", "DCAM_IDPROP_SENSORMODE - DCAMPROP_SENSORMODE__SPLITVIEW");
-                THROW_HW_ERROR(Error) << "Unable to activate W-VIEW mode";
-            }
+//-----------------------------------------------------------------------------
+/// Get the current exposure time for the first view
+//-----------------------------------------------------------------------------
+void Camera::getViewExpTime1(double & exp_time ) ///< [out] current exposure time
+{
+    getViewExpTime(0, exp_time );
+}
 
-            m_view_mode_enabled = true          ; // W-View mode with splitting image
-            m_view_number      = in_views_number; // number of W-Views
+//-----------------------------------------------------------------------------
+/// Get the current exposure time for the second view
+//-----------------------------------------------------------------------------
+void Camera::getViewExpTime2(double & exp_time ) ///< [out] current exposure time
+{
+    getViewExpTime(1, exp_time );
+}
 
-            manage_trace( deb, "W-VIEW mode activated", DCAMERR_NONE, NULL, "views number %d", in_views_number);
-        }
-        else
-        // W-View is not supported for this camera
-        {
-            manage_error( deb, "Cannot set the W-View mode - This camera does not support the W-View mode.", DCAMERR_NONE);
-            THROW_HW_ERROR(Error) << "Cannot set the W-View mode - This camera does not support the W-View mode.";
-        }
+//-----------------------------------------------------------------------------
+/// Set the blank mode of the Sync-readout trigger
+//-----------------------------------------------------------------------------
+void Camera::setSyncReadoutBlankMode(enum SyncReadOut_BlankMode in_sync_read_out_mode) ///< [in] type of sync-readout trigger's blank
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_sync_read_out_mode);
+
+    DCAMERR  err ;
+    int      mode;
+
+    if(in_sync_read_out_mode == SyncReadOut_BlankMode_Standard)
+    {
+        mode = DCAMPROP_SYNCREADOUT_SYSTEMBLANK__STANDARD;
     }
     else
-    // unactivated
+    if(in_sync_read_out_mode == SyncReadOut_BlankMode_Minimum)
     {
-        // set area mode
-        err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_SENSORMODE, static_cast<double>(DCAMPROP_SENSORMODE__AREA) );
+        mode = DCAMPROP_SYNCREADOUT_SYSTEMBLANK__MINIMUM;
+    }
+    else
+    {
+        manage_error( deb, "Unable to set the SyncReadout blank mode", DCAMERR_NONE, 
+                           "", "in_sync_read_out_mode is unknown %d", static_cast<int>(in_sync_read_out_mode));
+        THROW_HW_ERROR(Error) << "Unable to set the SyncReadout blank mode";
+    }
 
-        if( failed(err) )
+    // set the mode
+    err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_SYNCREADOUT_SYSTEMBLANK, static_cast<double>(mode) );
+
+    if( failed(err) )
+    {
+        if((err == DCAMERR_INVALIDPROPERTYID)||(err == DCAMERR_NOTSUPPORT))
         {
-            manage_error( deb, "Unable to activate AREA mode", err, 
-                               "dcamprop_setvalue", "DCAM_IDPROP_SENSORMODE - DCAMPROP_SENSORMODE__AREA");
-            THROW_HW_ERROR(Error) << "Unable to activate AREA mode";
+            manage_trace( deb, "Unable to set the SyncReadout blank mode", err, 
+                               "dcamprop_setvalue", "DCAM_IDPROP_SYNCREADOUT_SYSTEMBLANK %d", mode);
         }
-
-        // if view mode was activated, we rewrite the exposure time
-        if (m_view_mode_enabled)
+        else
         {
-            setExpTime(m_exp_time); // rewrite the value in the camera
+            manage_error( deb, "Unable to set the SyncReadout blank mode", err, 
+                               "dcamprop_setvalue", "DCAM_IDPROP_SYNCREADOUT_SYSTEMBLANK %d", mode);
+            THROW_HW_ERROR(Error) << "Unable to set the SyncReadout blank mode";
         }
-
-        m_view_mode_enabled = false; // W-View mode with splitting image
-        m_view_number      = 0    ; // number of W-Views
-
-        manage_trace( deb, "W-VIEW mode unactivated");
     }
 }
 
 //-----------------------------------------------------------------------------
-/// Set the W-VIEW mode
+/// Checking the ROI properties (min, max, step...)
 //-----------------------------------------------------------------------------
-void Camera::setViewMode(bool flag)
+void Camera::checkingROIproperties(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_PARAM() << DEB_VAR1(flag);
 
-    setViewMode(flag, 2); // 2 views max for ORCA
+    // Checking ROI properties
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS" , DCAM_IDPROP_SUBARRAYHPOS , NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS" , DCAM_IDPROP_SUBARRAYVPOS , NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHSIZE", DCAM_IDPROP_SUBARRAYHSIZE, NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVSIZE", DCAM_IDPROP_SUBARRAYVSIZE, NULL );
+
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS VIEW1" , DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYHPOS ), NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS VIEW1" , DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYVPOS ), NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHSIZE VIEW1", DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYHSIZE), NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVSIZE VIEW1", DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYVSIZE), NULL );
+
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS VIEW2" , DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYHPOS ), NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS VIEW2" , DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYVPOS ), NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHSIZE VIEW2", DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYHSIZE), NULL );
+    DEB_TRACE() << g_trace_line_separator.c_str();
+    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVSIZE VIEW2", DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYVSIZE), NULL );
 }
 
 //-----------------------------------------------------------------------------
-/// Get the W-VIEW mode
+/// Return the sensor temperature support by the current detector
 //-----------------------------------------------------------------------------
-void Camera::getViewMode(bool& flag)
+bool Camera::isSensorTemperatureSupported(void)
 {
     DEB_MEMBER_FUNCT();
 
-    if(getStatus() == CameraThread::Ready)
+    DCAMERR err;
+    bool    supported;
+    double  temperature = 0.0;
+    
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORTEMPERATURE, &temperature );
+    
+    if( failed(err) )
     {
-        double  sensor_mode;
-        DCAMERR err        ;
-
-        err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORMODE, &sensor_mode);
-
-        if( failed(err) )
+        if((err == DCAMERR_INVALIDPROPERTYID)||(err == DCAMERR_NOTSUPPORT))
         {
-            manage_error( deb, "Cannot get sensor mode", err, 
-                          "dcamprop_getvalue", "IDPROP=DCAM_IDPROP_SENSORMODE");
-            THROW_HW_ERROR(Error) << "Cannot get sensor mode";
+            supported = false;
         }
-
-        flag = (static_cast<int>(sensor_mode) == DCAMPROP_SENSORMODE__SPLITVIEW);
-    }
+        else
+        {
+            manage_trace( deb, "Unable to retrieve the sensor temperature", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORTEMPERATURE");
+            THROW_HW_ERROR(Error) << "Unable to retrieve the sensor temperature";
+        }
+    }    
     else
-    // do not call the sdk functions during acquisition
     {
-        flag = m_view_mode_enabled;
+        supported = true;
     }
+
+    return supported;
 }
 
 //-----------------------------------------------------------------------------
-/// Set the new exposure time for a view
+/// Return the current sensor temperature
 //-----------------------------------------------------------------------------
-void Camera::setViewExpTime(int    view_index, ///< [in] view index [0...m_max_views[
-                            double exp_time  ) ///< [in] exposure time to set
+double Camera::getSensorTemperature(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_PARAM() << DEB_VAR2(view_index, exp_time);
 
     DCAMERR err;
-
-    // W-View is not supported for this camera
-    if(m_max_views < 2)
-    {
-        manage_error( deb, "Cannot set view exposure time - This camera does not support the W-View mode.", DCAMERR_NONE);
-        THROW_HW_ERROR(Error) << "Cannot set view exposure time - This camera does not support the W-View mode.";
-    }
-    else
-    if(view_index < m_max_views)
+    double  temperature = 0.0;
+    
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORTEMPERATURE, &temperature );
+    
+    if( failed(err) )
     {
-        // Changing a View exposure time is not allowed if W-VIEW mode is not activated but we keep the value
-        if(!m_view_mode_enabled)
-        {
-            manage_error( deb, "Cannot change W-View exposure time when W-VIEW mode is unactivated!", DCAMERR_NONE, "setViewExpTime");
-        }
-        else
-        {
-            // set the exposure time
-            err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_VIEW_((view_index + 1), DCAM_IDPROP_EXPOSURETIME), exp_time);
-
-            if( failed(err) )
-            {
-                manage_error( deb, "Cannot set view exposure time", err, 
-                              "dcamprop_setvalue", "IDPROP=DCAM_IDPROP_EXPOSURETIME, VIEW INDEX=%d, VALUE=%lf", view_index, exp_time);
-                THROW_HW_ERROR(Error) << "Cannot set view exposure time";
-            }
+        manage_trace( deb, "Unable to retrieve the sensor temperature", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORTEMPERATURE");
 
-            double temp_exp_time;
-            getViewExpTime(view_index, temp_exp_time);
-            manage_trace( deb, "Changed View Exposure time", DCAMERR_NONE, NULL, "views index %d, exp:%lf >> real:%lf", view_index, exp_time, temp_exp_time);
+        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
+        {
+            THROW_HW_ERROR(Error) << "Unable to retrieve the sensor temperature";
         }
-
-        m_view_exp_time[view_index] = exp_time;
-    }
+    }    
     else
     {
-        manage_error( deb, "Cannot set view exposure time", DCAMERR_NONE, 
-                      "", "VIEW INDEX=%d, MAX VIEWS=%d", view_index, m_max_views);
-        THROW_HW_ERROR(Error) << "Cannot set view exposure time";
+        DEB_TRACE() << DEB_VAR1(temperature);
     }
+    
+    return temperature;
 }
 
+//=============================================================================
+// COOLER MODE
+//=============================================================================
 //-----------------------------------------------------------------------------
-/// Get the current exposure time for a view
+/// Return the cooler mode support by the current detector
 //-----------------------------------------------------------------------------
-void Camera::getViewExpTime(int      view_index, ///< [in] view index [0...m_max_views[
-                            double & exp_time  ) ///< [out] current exposure time
+bool Camera::isCoolerModeSupported(void)
+{
+    return !(getCoolerMode() == Cooler_Mode::Cooler_Mode_Not_Supported);
+}
+
+//-----------------------------------------------------------------------------
+/// Return the current cooler mode
+//-----------------------------------------------------------------------------
+enum Camera::Cooler_Mode Camera::getCoolerMode(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_PARAM() << DEB_VAR1(view_index);
 
-    DCAMERR err;
+    enum Cooler_Mode result = Cooler_Mode::Cooler_Mode_Not_Supported;
 
-    // W-View is not supported for this camera
-    if(m_max_views < 2)
-    {
-        exp_time = m_exp_time;
-    }
-    else
-    if(view_index < m_max_views)
+    DCAMERR err ;
+    double  temp;
+    
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORCOOLER, &temp );
+    
+    if( failed(err) )
     {
-        double exposure;
+        manage_trace( deb, "Unable to retrieve the sensor cooler", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORCOOLER");
 
-        // if W-VIEW mode is not activated we cannot retrieve the current value 
-        if(!m_view_mode_enabled)
+        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
         {
-            exposure = m_view_exp_time[view_index];
+            THROW_HW_ERROR(Error) << "Unable to retrieve the sensor cooler";
         }
-        else
-        if(getStatus() == CameraThread::Ready)
-        {
-            err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_VIEW_((view_index + 1), DCAM_IDPROP_EXPOSURETIME), &exposure);
+    }    
+    else
+    {
+        int32 nMode = static_cast<int32>(temp);
 
-            if( failed(err) )
-            {
-                manage_error( deb, "Cannot get view exposure time", err, 
-                              "dcamprop_getvalue", "IDPROP=DCAM_IDPROP_EXPOSURETIME, VIEW INDEX=%d", view_index);
-                THROW_HW_ERROR(Error) << "Cannot get view exposure time";
-            }
-        }
-        else
-        // do not call the sdk functions during acquisition
+        DEB_TRACE() << DEB_VAR1(nMode);
+
+        switch (nMode)
         {
-            exposure = m_view_exp_time[view_index];
+            case DCAMPROP_SENSORCOOLER__OFF: result = Cooler_Mode::Cooler_Mode_Off; break;
+            case DCAMPROP_SENSORCOOLER__ON : result = Cooler_Mode::Cooler_Mode_On ; break;
+            case DCAMPROP_SENSORCOOLER__MAX: result = Cooler_Mode::Cooler_Mode_Max; break;
+            default: break; // result will be Sensor_Cooler_Not_Supported
         }
-
-        exp_time = exposure;
     }
-    else
+    
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Get the cooler mode label.
+//-----------------------------------------------------------------------------
+std::string Camera::getCoolerModeLabel(void)
+{
+    return getCoolerModeLabelFromMode(getCoolerMode());
+}
+
+//-----------------------------------------------------------------------------
+// Get a cooler mode label from a mode.
+//-----------------------------------------------------------------------------
+std::string Camera::getCoolerModeLabelFromMode(enum Camera::Cooler_Mode in_cooler_mode)
+{
+    std::string label = "";
+
+    switch (in_cooler_mode)
     {
-        manage_error( deb, "Cannot get view exposure time", DCAMERR_NONE, 
-                      "", "VIEW INDEX=%d, MAX VIEWS=%d", view_index, m_max_views);
-        THROW_HW_ERROR(Error) << "Cannot get view exposure time";
+        case Camera::Cooler_Mode_Off          : label = SENSOR_COOLER_OFF          ; break;
+        case Camera::Cooler_Mode_On           : label = SENSOR_COOLER_ON           ; break;
+        case Camera::Cooler_Mode_Max          : label = SENSOR_COOLER_MAX          ; break;
+        case Camera::Cooler_Mode_Not_Supported: label = SENSOR_COOLER_NOT_SUPPORTED; break;
+        default: break;
     }
+
+    return label;
 }
 
+//=============================================================================
+// TEMPERATURE STATUS
+//=============================================================================
 //-----------------------------------------------------------------------------
-/// Get the minimum exposure time of all views
+/// Return the temperature status support by the current detector
 //-----------------------------------------------------------------------------
-void Camera::getMinViewExpTime(double& exp_time) ///< [out] current exposure time
+bool Camera::isTemperatureStatusSupported(void)
+{
+    return !(getTemperatureStatus() == Temperature_Status::Temperature_Status_Not_Supported);
+}
+
+//-----------------------------------------------------------------------------
+/// Return the current temperature status
+//-----------------------------------------------------------------------------
+enum Camera::Temperature_Status Camera::getTemperatureStatus(void)
 {
     DEB_MEMBER_FUNCT();
 
-    // the exposure is the minimum of the views'exposure values
-    int    view_index   = 0   ;
-    double exposure     = -1.0; // we search the minimum value - this is the not set value
-    double view_exposure; 
+    enum Temperature_Status result = Temperature_Status::Temperature_Status_Not_Supported;
 
-    if(m_max_views > 1)
+    DCAMERR err ;
+    double  temp;
+    
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORTEMPERATURE_STATUS, &temp );
+    
+    if( failed(err) )
     {
-        while(view_index < m_max_views)
+        manage_trace( deb, "Unable to retrieve the temperature status", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORTEMPERATURE_STATUS");
+
+        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
         {
-            getViewExpTime(view_index, view_exposure);
-            
-            if((exposure == -1.0) || (view_exposure < exposure))
-                exposure = view_exposure; // sets the new minimum
+            THROW_HW_ERROR(Error) << "Unable to retrieve the temperature status";
+        }
+    }    
+    else
+    {
+        int32 nMode = static_cast<int32>(temp);
 
-            view_index++;
+        DEB_TRACE() << DEB_VAR1(nMode);
+
+        switch (nMode)
+        {
+            case DCAMPROP_SENSORTEMPERATURE_STATUS__NORMAL    : result = Temperature_Status::Temperature_Status_Normal    ; break;
+            case DCAMPROP_SENSORTEMPERATURE_STATUS__WARNING   : result = Temperature_Status::Temperature_Status_Warning   ; break;
+            case DCAMPROP_SENSORTEMPERATURE_STATUS__PROTECTION: result = Temperature_Status::Temperature_Status_Protection; break;
+            default: break; // result will be Temperature_Status_Not_Supported
         }
     }
-
-    exp_time = exposure;
+    
+    return result;
 }
 
 //-----------------------------------------------------------------------------
-/// Set the new exposure time for the first view
+// Get a temperature status label from the status.
 //-----------------------------------------------------------------------------
-void Camera::setViewExpTime1(double exp_time ) ///< [in] exposure time to set
+std::string Camera::getTemperatureStatusLabelFromStatus(enum Camera::Temperature_Status in_temperature_status)
 {
-    setViewExpTime(0, exp_time );
+    std::string label = "";
+
+    switch (in_temperature_status)
+    {
+        case Camera::Temperature_Status_Not_Supported : label = TEMPERATURE_STATUS_NOT_SUPPORTED; break;
+        case Camera::Temperature_Status_Normal        : label = TEMPERATURE_STATUS_NORMAL       ; break;
+        case Camera::Temperature_Status_Warning       : label = TEMPERATURE_STATUS_WARNING      ; break;
+        case Camera::Temperature_Status_Protection    : label = TEMPERATURE_STATUS_PROTECTION   ; break;
+        default: break;
+    }
+
+    return label;
 }
 
 //-----------------------------------------------------------------------------
-/// Set the new exposure time for the second view
+// Get the temperature status label.
 //-----------------------------------------------------------------------------
-void Camera::setViewExpTime2(double exp_time ) ///< [in] exposure time to set
+std::string Camera::getTemperatureStatusLabel(void)
 {
-    setViewExpTime(1, exp_time );
+    return getTemperatureStatusLabelFromStatus(getTemperatureStatus());
 }
 
+//=============================================================================
+// COOLER STATUS
+//=============================================================================
 //-----------------------------------------------------------------------------
-/// Get the current exposure time for the first view
+// Get a cooler status label from a status.
 //-----------------------------------------------------------------------------
-void Camera::getViewExpTime1(double & exp_time ) ///< [out] current exposure time
+std::string Camera::getCoolerStatusLabelFromStatus(enum Camera::Cooler_Status in_cooler_status)
 {
-    getViewExpTime(0, exp_time );
+    std::string label = "";
+
+    switch (in_cooler_status)
+    {
+        case Camera::Cooler_Status_Not_Supported : label = COOLER_STATUS_NOT_SUPPORTED; break;
+        case Camera::Cooler_Status_Error4        : label = COOLER_STATUS_ERROR4       ; break;
+        case Camera::Cooler_Status_Error3        : label = COOLER_STATUS_ERROR3       ; break;
+        case Camera::Cooler_Status_Error2        : label = COOLER_STATUS_ERROR2       ; break;
+        case Camera::Cooler_Status_Error1        : label = COOLER_STATUS_ERROR1       ; break;
+        case Camera::Cooler_Status_None          : label = COOLER_STATUS_NONE         ; break;
+        case Camera::Cooler_Status_Off           : label = COOLER_STATUS_OFF          ; break;
+        case Camera::Cooler_Status_Ready         : label = COOLER_STATUS_READY        ; break;
+        case Camera::Cooler_Status_Busy          : label = COOLER_STATUS_BUSY         ; break;
+        case Camera::Cooler_Status_Always        : label = COOLER_STATUS_ALWAYS       ; break;
+        case Camera::Cooler_Status_Warning       : label = COOLER_STATUS_WARNING      ; break;
+
+        default: break;
+    }
+
+    return label;
 }
 
 //-----------------------------------------------------------------------------
-/// Get the current exposure time for the second view
+/// Return the cooler status support by the current detector
 //-----------------------------------------------------------------------------
-void Camera::getViewExpTime2(double & exp_time ) ///< [out] current exposure time
+bool Camera::isCoolerStatusSupported(void)
 {
-    getViewExpTime(1, exp_time );
+    return !(getCoolerStatus() == Cooler_Status::Cooler_Status_Not_Supported);
 }
 
 //-----------------------------------------------------------------------------
-/// Set the blank mode of the Sync-readout trigger
+/// Return the current cooler status
 //-----------------------------------------------------------------------------
-void Camera::setSyncReadoutBlankMode(enum SyncReadOut_BlankMode in_sync_read_out_mode) ///< [in] type of sync-readout trigger's blank
+enum Camera::Cooler_Status Camera::getCoolerStatus(void)
 {
     DEB_MEMBER_FUNCT();
-    DEB_PARAM() << DEB_VAR1(in_sync_read_out_mode);
 
-    DCAMERR  err ;
-    int      mode;
+    enum Cooler_Status result = Cooler_Status::Cooler_Status_Not_Supported;
 
-    if(in_sync_read_out_mode == SyncReadOut_BlankMode_Standard)
-    {
-        mode = DCAMPROP_SYNCREADOUT_SYSTEMBLANK__STANDARD;
-    }
-    else
-    if(in_sync_read_out_mode == SyncReadOut_BlankMode_Minimum)
+    DCAMERR err ;
+    double  temp;
+    
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORCOOLERSTATUS, &temp );
+    
+    if( failed(err) )
     {
-        mode = DCAMPROP_SYNCREADOUT_SYSTEMBLANK__MINIMUM;
-    }
+        manage_trace( deb, "Unable to retrieve the cooler status", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORCOOLERSTATUS");
+
+        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
+        {
+            THROW_HW_ERROR(Error) << "Unable to retrieve the cooler status";
+        }
+    }    
     else
     {
-        manage_error( deb, "Unable to set the SyncReadout blank mode", DCAMERR_NONE, 
-                           "", "in_sync_read_out_mode is unknown %d", static_cast<int>(in_sync_read_out_mode));
-        THROW_HW_ERROR(Error) << "Unable to set the SyncReadout blank mode";
-    }
+        int32 nMode = static_cast<int32>(temp);
 
-    // set the mode
-    err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_SYNCREADOUT_SYSTEMBLANK, static_cast<double>(mode) );
+        DEB_TRACE() << DEB_VAR1(nMode);
 
-    if( failed(err) )
-    {
-        if((err == DCAMERR_INVALIDPROPERTYID)||(err == DCAMERR_NOTSUPPORT))
-        {
-            manage_trace( deb, "Unable to set the SyncReadout blank mode", err, 
-                               "dcamprop_setvalue", "DCAM_IDPROP_SYNCREADOUT_SYSTEMBLANK %d", mode);
-        }
-        else
+        switch (nMode)
         {
-            manage_error( deb, "Unable to set the SyncReadout blank mode", err, 
-                               "dcamprop_setvalue", "DCAM_IDPROP_SYNCREADOUT_SYSTEMBLANK %d", mode);
-            THROW_HW_ERROR(Error) << "Unable to set the SyncReadout blank mode";
+            case DCAMPROP_SENSORCOOLERSTATUS__ERROR4 : result = Cooler_Status::Cooler_Status_Error4 ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__ERROR3 : result = Cooler_Status::Cooler_Status_Error3 ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__ERROR2 : result = Cooler_Status::Cooler_Status_Error2 ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__ERROR1 : result = Cooler_Status::Cooler_Status_Error1 ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__NONE   : result = Cooler_Status::Cooler_Status_None   ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__OFF    : result = Cooler_Status::Cooler_Status_Off    ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__READY  : result = Cooler_Status::Cooler_Status_Ready  ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__BUSY   : result = Cooler_Status::Cooler_Status_Busy   ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__ALWAYS : result = Cooler_Status::Cooler_Status_Always ; break;
+            case DCAMPROP_SENSORCOOLERSTATUS__WARNING: result = Cooler_Status::Cooler_Status_Warning; break;
+            default: break; // result will be Cooler_Status_Not_Supported
         }
     }
+    
+    return result;
 }
 
 //-----------------------------------------------------------------------------
-/// Checking the ROI properties (min, max, step...)
+// Get the cooler status label.
 //-----------------------------------------------------------------------------
-void Camera::checkingROIproperties(void)
+std::string Camera::getCoolerStatusLabel(void)
 {
-    DEB_MEMBER_FUNCT();
+    return getCoolerStatusLabelFromStatus(getCoolerStatus());
+}
 
-    // Checking ROI properties
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS" , DCAM_IDPROP_SUBARRAYHPOS , NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS" , DCAM_IDPROP_SUBARRAYVPOS , NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHSIZE", DCAM_IDPROP_SUBARRAYHSIZE, NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVSIZE", DCAM_IDPROP_SUBARRAYVSIZE, NULL );
+//=============================================================================
+// HIGH DYNAMIC RANGE
+//=============================================================================
+//-----------------------------------------------------------------------------
+/// Return the high dynamic range support by the current detector
+//-----------------------------------------------------------------------------
+bool Camera::isHighDynamicRangeSupported(void)
+{
+    DEB_MEMBER_FUNCT();
 
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS VIEW1" , DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYHPOS ), NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS VIEW1" , DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYVPOS ), NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHSIZE VIEW1", DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYHSIZE), NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVSIZE VIEW1", DCAM_IDPROP_VIEW_(1, DCAM_IDPROP_SUBARRAYVSIZE), NULL );
+    DCAMERR err;
+    bool    supported;
+    double  temp;
+    
+    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, &temp );
+    
+    if( failed(err) )
+    {
+        if((err == DCAMERR_INVALIDPROPERTYID)||(err == DCAMERR_NOTSUPPORT))
+        {
+            supported = false;
+        }
+        else
+        {
+            manage_trace( deb, "Unable to retrieve the high dynamic range mode", err, "dcamprop_getvalue - DCAM_IDPROP_HIGHDYNAMICRANGE_MODE");
+            THROW_HW_ERROR(Error) << "Unable to retrieve the high dynamic range mode";
+        }
+    }    
+    else
+    {
+        supported = true;
+    }
 
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHPOS VIEW2" , DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYHPOS ), NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVPOS VIEW2" , DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYVPOS ), NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYHSIZE VIEW2", DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYHSIZE), NULL );
-    DEB_TRACE() << g_trace_line_separator.c_str();
-    traceFeatureGeneralInformations(m_camera_handle, "DCAM_IDPROP_SUBARRAYVSIZE VIEW2", DCAM_IDPROP_VIEW_(2, DCAM_IDPROP_SUBARRAYVSIZE), NULL );
+    return supported;
 }
 
 //-----------------------------------------------------------------------------
-/// Return the sensor temperature support by the current detector
+/// get the current high dynamic range activation state
 //-----------------------------------------------------------------------------
-bool Camera::isSensorTemperatureSupported(void)
+bool Camera::getHighDynamicRangeEnabled(void)
 {
     DEB_MEMBER_FUNCT();
 
     DCAMERR err;
-    bool    supported;
-    double  temperature = 0.0;
-    
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORTEMPERATURE, &temperature );
+    double  temp;
+    bool    high_dynamic_range_mode = false;
     
-    if( failed(err) )
+    if(getStatus() == CameraThread::Ready)
     {
-        if((err == DCAMERR_INVALIDPROPERTYID)||(err == DCAMERR_NOTSUPPORT))
+        err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, &temp );
+        
+        if( failed(err) )
         {
-            supported = false;
-        }
+            manage_trace( deb, "Unable to retrieve the high dynamic range mode", err, "dcamprop_getvalue - DCAM_IDPROP_HIGHDYNAMICRANGE_MODE");
+
+            if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
+            {
+                THROW_HW_ERROR(Error) << "Unable to retrieve the high dynamic range mode";
+            }
+        }    
         else
         {
-            manage_trace( deb, "Unable to retrieve the sensor temperature", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORTEMPERATURE");
-            THROW_HW_ERROR(Error) << "Unable to retrieve the sensor temperature";
+            int high_dynamic_range = static_cast<int>(temp);
+
+            DEB_TRACE() << DEB_VAR1(high_dynamic_range);
+
+            if(high_dynamic_range == DCAMPROP_MODE__OFF) high_dynamic_range_mode = false;
+            else
+            if(high_dynamic_range == DCAMPROP_MODE__ON ) high_dynamic_range_mode = true ;
+            else
+            {
+                manage_trace( deb, "The read high dynamic range mode is incoherent!", err, "dcamprop_getvalue - DCAM_IDPROP_HIGHDYNAMICRANGE_MODE");
+            }
         }
-    }    
+    }
     else
+    // do not call the sdk functions during acquisition
     {
-        supported = true;
+        high_dynamic_range_mode = m_hdr_enabled;
     }
-
-    return supported;
+    
+    return high_dynamic_range_mode;
 }
 
 //-----------------------------------------------------------------------------
-/// Return the current sensor temperature
+/// set the current high dynamic range activation state
 //-----------------------------------------------------------------------------
-double Camera::getSensorTemperature(void)
+void Camera::setHighDynamicRangeEnabled(const bool & in_enabled)
 {
     DEB_MEMBER_FUNCT();
 
+    m_thread.releasePreparedBuffers(); // the image layout can change
+
     DCAMERR err;
-    double  temperature = 0.0;
-    
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORTEMPERATURE, &temperature );
-    
+
+    double temp = (in_enabled) ? static_cast<double>(DCAMPROP_MODE__ON) : static_cast<double>(DCAMPROP_MODE__OFF);
+
+    // set the value
+    err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, temp);
+
     if( failed(err) )
     {
-        manage_trace( deb, "Unable to retrieve the sensor temperature", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORTEMPERATURE");
+        manage_error( deb, "Cannot set high dynamic range mode", err, 
+                      "dcamprop_setvalue", "IDPROP=DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, VALUE=%d", static_cast<int>(temp));
+        THROW_HW_ERROR(Error) << "Cannot set high dynamic range mode";
+    }
 
-        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
-        {
-            THROW_HW_ERROR(Error) << "Unable to retrieve the sensor temperature";
-        }
-    }    
-    else
+    manage_trace( deb, "Changed high dynamic range mode", DCAMERR_NONE, NULL, "%s", ((in_enabled) ? "DCAMPROP_MODE__ON" : "DCAMPROP_MODE__OFF"));
+
+    // forcing the image pixel type to 16 bits
+    bool depth_changed = (m_depth != 16);
+
+    dcamex_setimagepixeltype( m_camera_handle, DCAM_PIXELTYPE_MONO16);
+    m_packed_transfer = false;
+    m_depth           = 16   ;
+    m_bytes_per_pixel = 2    ;
+    m_soft_bit_shift  = -1   ;
+
+    // lima reallocates its buffers with the new depth
+    if(depth_changed)
     {
-        DEB_TRACE() << DEB_VAR1(temperature);
+        Size max_image_size;
+        getDetectorMaxImageSize(max_image_size);
+        maxImageSizeChanged(max_image_size, Bpp16);
     }
-    
-    return temperature;
+
+    // keep the latest value
+    m_hdr_enabled = in_enabled;
 }
 
 //=============================================================================
-// COOLER MODE
+// CALIBRATION
 //=============================================================================
 //-----------------------------------------------------------------------------
-/// Return the cooler mode support by the current detector
+/// Read a calibration property
 //-----------------------------------------------------------------------------
-bool Camera::isCoolerModeSupported(void)
+double Camera::getCalibrationProperty(const int32  in_id  , ///< [in] property to read
+                                      const char * in_name) ///< [in] property name for the traces
 {
-    return !(getCoolerMode() == Cooler_Mode::Cooler_Mode_Not_Supported);
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+    double  temp;
+
+    err = dcamprop_getvalue( m_camera_handle, in_id, &temp );
+
+    if( failed(err) )
+    {
+        manage_error( deb, "Unable to retrieve the calibration property", err, "dcamprop_getvalue", "IDPROP=%s", in_name);
+        THROW_HW_ERROR(Error) << "Unable to retrieve the calibration property " << in_name;
+    }
+
+    return temp;
 }
 
 //-----------------------------------------------------------------------------
-/// Return the current cooler mode
+/// Write a calibration property (only between the acquisitions)
 //-----------------------------------------------------------------------------
-enum Camera::Cooler_Mode Camera::getCoolerMode(void)
+void Camera::setCalibrationProperty(const int32  in_id   , ///< [in] property to write
+                                    const double in_value, ///< [in] new value
+                                    const char * in_name ) ///< [in] property name for the traces
 {
     DEB_MEMBER_FUNCT();
 
-    enum Cooler_Mode result = Cooler_Mode::Cooler_Mode_Not_Supported;
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot change the calibration during an acquisition!";
+    }
+
+    DCAMERR err;
+
+    err = dcamprop_setvalue( m_camera_handle, in_id, in_value );
 
-    DCAMERR err ;
-    double  temp;
-    
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORCOOLER, &temp );
-    
     if( failed(err) )
     {
-        manage_trace( deb, "Unable to retrieve the sensor cooler", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORCOOLER");
+        manage_error( deb, "Cannot set the calibration property", err, 
+                      "dcamprop_setvalue", "IDPROP=%s, VALUE=%d", in_name, static_cast<int>(in_value));
+        THROW_HW_ERROR(Error) << "Cannot set the calibration property " << in_name;
+    }
+
+    manage_trace( deb, "Changed calibration property", DCAMERR_NONE, NULL, "%s=%d", in_name, static_cast<int>(in_value));
+}
+
+//-----------------------------------------------------------------------------
+/// Read the readout directions covered by a calibration data
+//-----------------------------------------------------------------------------
+enum Camera::Calibration_Status Camera::getCalibrationStatus(const int32  in_id  , ///< [in] DCAM_IDPROP_SUBTRACT_DATASTATUS or DCAM_IDPROP_SHADINGCALIB_DATASTATUS
+                                                             const char * in_name) ///< [in] property name for the traces
+{
+    DEB_MEMBER_FUNCT();
+
+    DCAMERR err;
+    double  temp;
+    enum Calibration_Status status = Calibration_Status_Not_Supported;
 
+    err = dcamprop_getvalue( m_camera_handle, in_id, &temp );
+
+    if( failed(err) )
+    {
         if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
         {
-            THROW_HW_ERROR(Error) << "Unable to retrieve the sensor cooler";
+            manage_error( deb, "Unable to retrieve the calibration data status", err, "dcamprop_getvalue", "IDPROP=%s", in_name);
+            THROW_HW_ERROR(Error) << "Unable to retrieve the calibration data status " << in_name;
         }
-    }    
+    }
     else
     {
-        int32 nMode = static_cast<int32>(temp);
+        int calib_status = static_cast<int>(temp);
 
-        DEB_TRACE() << DEB_VAR1(nMode);
+        DEB_TRACE() << DEB_VAR2(in_name, calib_status);
 
-        switch (nMode)
+        if(calib_status == DCAMPROP_CALIBDATASTATUS__NONE    ) status = Calibration_Status_None    ;
+        else
+        if(calib_status == DCAMPROP_CALIBDATASTATUS__FORWARD ) status = Calibration_Status_Forward ;
+        else
+        if(calib_status == DCAMPROP_CALIBDATASTATUS__BACKWARD) status = Calibration_Status_Backward;
+        else
+        if(calib_status == DCAMPROP_CALIBDATASTATUS__BOTH    ) status = Calibration_Status_Both    ;
+        else
         {
-            case DCAMPROP_SENSORCOOLER__OFF: result = Cooler_Mode::Cooler_Mode_Off; break;
-            case DCAMPROP_SENSORCOOLER__ON : result = Cooler_Mode::Cooler_Mode_On ; break;
-            case DCAMPROP_SENSORCOOLER__MAX: result = Cooler_Mode::Cooler_Mode_Max; break;
-            default: break; // result will be Sensor_Cooler_Not_Supported
+            manage_trace( deb, "The read calibration data status is incoherent!", DCAMERR_NONE, NULL, "%s=%d", in_name, calib_status);
         }
     }
-    
-    return result;
-}
 
-//-----------------------------------------------------------------------------
-// Get the cooler mode label.
-//-----------------------------------------------------------------------------
-std::string Camera::getCoolerModeLabel(void)
-{
-    return getCoolerModeLabelFromMode(getCoolerMode());
+    return status;
 }
 
 //-----------------------------------------------------------------------------
-// Get a cooler mode label from a mode.
+/// Run a calibration capture of the camera and store its result in a page of
+/// the camera memory. The capture uses the DCAM ring: the buffers prepared for
+/// the next acquisition are released. The capture mode is set back to normal,
+/// even after an error.
 //-----------------------------------------------------------------------------
-std::string Camera::getCoolerModeLabelFromMode(enum Camera::Cooler_Mode in_cooler_mode)
+void Camera::runCalibrationCapture(const int32  in_capture_mode, ///< [in] DCAMPROP_CAPTUREMODE__DARKCALIB or DCAMPROP_CAPTUREMODE__SHADINGCALIB
+                                   const int32  in_samples_id  , ///< [in] property giving the number of averaged images
+                                   const int32  in_store_id    , ///< [in] property storing the result in the camera memory
+                                   const int    in_page        , ///< [in] camera memory page receiving the result
+                                   const char * in_name        ) ///< [in] calibration name for the traces
 {
-    std::string label = "";
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(in_name, in_page);
 
-    switch (in_cooler_mode)
+    if(in_page < 1)
     {
-        case Camera::Cooler_Mode_Off          : label = SENSOR_COOLER_OFF          ; break;
-        case Camera::Cooler_Mode_On           : label = SENSOR_COOLER_ON           ; break;
-        case Camera::Cooler_Mode_Max          : label = SENSOR_COOLER_MAX          ; break;
-        case Camera::Cooler_Mode_Not_Supported: label = SENSOR_COOLER_NOT_SUPPORTED; break;
-        default: break;
+        THROW_HW_ERROR(Error) << "Invalid calibration memory page " << in_page;
     }
 
-    return label;
-}
+    if(m_thread.getStatus() != CameraThread::Ready)
+    {
+        THROW_HW_ERROR(Error) << "Cannot run the " << in_name << " calibration during an acquisition!";
+    }
 
-//=============================================================================
-// TEMPERATURE STATUS
-//=============================================================================
-//-----------------------------------------------------------------------------
-/// Return the temperature status support by the current detector
-//-----------------------------------------------------------------------------
-bool Camera::isTemperatureStatusSupported(void)
-{
-    return !(getTemperatureStatus() == Temperature_Status::Temperature_Status_Not_Supported);
-}
+    m_thread.releasePreparedBuffers(); // the DCAM ring is used by the calibration
 
-//-----------------------------------------------------------------------------
-/// Return the current temperature status
-//-----------------------------------------------------------------------------
-enum Camera::Temperature_Status Camera::getTemperatureStatus(void)
-{
-    DEB_MEMBER_FUNCT();
+    DCAMERR     err;
+    double      temp;
+    HDCAMWAIT   wait_handle       = NULL ;
+    bool        buffers_allocated = false;
+    std::string error;
 
-    enum Temperature_Status result = Temperature_Status::Temperature_Status_Not_Supported;
+    // the capture lasts the exposure of the averaged images
+    int nb_samples = g_calibration_nb_buffers;
+
+    err = dcamprop_getvalue( m_camera_handle, in_samples_id, &temp );
+
+    if( !failed(err) )
+        nb_samples = static_cast<int>(temp);
+
+    int32 timeout = static_cast<int32>((g_calibration_timeout + nb_samples * m_exp_time) * 1000.0);
+
+    DEB_TRACE() << DEB_VAR2(nb_samples, timeout);
+
+    err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_CAPTUREMODE, static_cast<double>(in_capture_mode) );
 
-    DCAMERR err ;
-    double  temp;
-    
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORTEMPERATURE_STATUS, &temp );
-    
     if( failed(err) )
     {
-        manage_trace( deb, "Unable to retrieve the temperature status", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORTEMPERATURE_STATUS");
+        manage_error( deb, "Cannot set the calibration capture mode", err, 
+                      "dcamprop_setvalue", "IDPROP=DCAM_IDPROP_CAPTUREMODE, VALUE=%d", in_capture_mode);
+        THROW_HW_ERROR(Error) << "The " << in_name << " calibration is not supported by the camera";
+    }
 
-        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
+    err = dcambuf_alloc( m_camera_handle, g_calibration_nb_buffers );
+
+    if( failed(err) )
+    {
+        manage_error( deb, "Cannot allocate the calibration buffers", err, 
+                      "dcambuf_alloc", "number_of_buffer=%d", g_calibration_nb_buffers);
+        error = "Cannot allocate the calibration buffers";
+    }
+    else
+    {
+        buffers_allocated = true;
+    }
+
+    if(error.empty())
+    {
+        DCAMWAIT_OPEN waitOpenHandle;
+
+        memset( &waitOpenHandle, 0, sizeof(DCAMWAIT_OPEN) );
+        waitOpenHandle.size  = sizeof(DCAMWAIT_OPEN);
+        waitOpenHandle.hdcam = m_camera_handle;
+
+        err = dcamwait_open( &waitOpenHandle );
+
+        if( failed(err) )
         {
-            THROW_HW_ERROR(Error) << "Unable to retrieve the temperature status";
+            manage_error( deb, "Cannot create the wait handle", err, "dcamwait_open");
+            error = "Cannot create the calibration wait handle";
         }
-    }    
-    else
+        else
+        {
+            wait_handle = waitOpenHandle.hwait;
+        }
+    }
+
+    if(error.empty())
     {
-        int32 nMode = static_cast<int32>(temp);
+        err = dcamcap_start( m_camera_handle, DCAMCAP_START_SEQUENCE );
 
-        DEB_TRACE() << DEB_VAR1(nMode);
+        if( failed(err) )
+        {
+            manage_error( deb, "Cannot start the calibration capture", err, "dcamcap_start");
+            error = "Cannot start the calibration capture";
+        }
+    }
 
-        switch (nMode)
+    // the camera stops the capture when the calibration is done
+    if(error.empty())
+    {
+        DCAMWAIT_START waitstart;
+
+        memset( &waitstart, 0, sizeof(DCAMWAIT_START) );
+        waitstart.size      = sizeof(DCAMWAIT_START);
+        waitstart.eventmask = DCAMWAIT_CAPEVENT_STOPPED;
+        waitstart.timeout   = timeout;
+
+        err = dcamwait_start( wait_handle, &waitstart );
+
+        if( failed(err) )
         {
-            case DCAMPROP_SENSORTEMPERATURE_STATUS__NORMAL    : result = Temperature_Status::Temperature_Status_Normal    ; break;
-            case DCAMPROP_SENSORTEMPERATURE_STATUS__WARNING   : result = Temperature_Status::Temperature_Status_Warning   ; break;
-            case DCAMPROP_SENSORTEMPERATURE_STATUS__PROTECTION: result = Temperature_Status::Temperature_Status_Protection; break;
-            default: break; // result will be Temperature_Status_Not_Supported
+            manage_error( deb, "Error during the calibration capture wait", err, "dcamwait_start", "timeout=%d", timeout);
+            error = (err == DCAMERR_TIMEOUT) ? "Timeout of the calibration capture" : "Error during the calibration capture";
+            dcamcap_stop( m_camera_handle );
         }
     }
-    
-    return result;
+
+    if(error.empty())
+    {
+        err = dcamprop_setvalue( m_camera_handle, in_store_id, static_cast<double>(in_page) );
+
+        if( failed(err) )
+        {
+            manage_error( deb, "Cannot store the calibration data", err, 
+                          "dcamprop_setvalue", "%s page=%d", in_name, in_page);
+            error = "Cannot store the calibration data in the camera memory";
+        }
+    }
+
+    // cleanup
+    if(wait_handle != NULL)
+    {
+        err = dcamwait_close( wait_handle );
+
+        if( failed(err) )
+            manage_trace( deb, "Cannot release the wait handle", err, "dcamwait_close");
+    }
+
+    if(buffers_allocated)
+    {
+        err = dcambuf_release( m_camera_handle, 0 );
+
+        if( failed(err) )
+            manage_trace( deb, "Unable to free the calibration buffers", err, "dcambuf_release");
+    }
+
+    err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_CAPTUREMODE, static_cast<double>(DCAMPROP_CAPTUREMODE__NORMAL) );
+
+    if( failed(err) )
+    {
+        manage_error( deb, "Cannot set back the normal capture mode", err, 
+                      "dcamprop_setvalue", "IDPROP=DCAM_IDPROP_CAPTUREMODE, VALUE=%d", DCAMPROP_CAPTUREMODE__NORMAL);
+
+        if(error.empty())
+            error = "Cannot set back the normal capture mode";
+    }
+
+    if(!error.empty())
+    {
+        THROW_HW_ERROR(Error) << "The " << in_name << " calibration failed: " << error;
+    }
+
+    manage_trace( deb, "Calibration data stored", DCAMERR_NONE, NULL, "%s page=%d", in_name, in_page);
+}
+
+//-----------------------------------------------------------------------------
+/// Capture a dark image (shutter closed, the camera averages a series of
+/// images) and store it in a page of the camera memory. The page becomes the
+/// selected dark subtraction page.
+//-----------------------------------------------------------------------------
+void Camera::captureDarkCalibration(const int in_page) ///< [in] camera memory page receiving the dark image
+{
+    DEB_MEMBER_FUNCT();
+
+    runCalibrationCapture(DCAMPROP_CAPTUREMODE__DARKCALIB, DCAM_IDPROP_DARKCALIB_SAMPLES, 
+                          DCAM_IDPROP_STORESUBTRACTIMAGETOMEMORY, in_page, "dark");
+
+    setCalibrationProperty(DCAM_IDPROP_SUBTRACTIMAGEMEMORY, static_cast<double>(in_page), "DCAM_IDPROP_SUBTRACTIMAGEMEMORY");
 }
 
 //-----------------------------------------------------------------------------
-// Get a temperature status label from the status.
+/// Capture the shading calibration data (uniform illumination) and store it 
+/// in a page of the camera memory. The camera needs the dark subtraction: it 
+/// is enabled with the selected dark page if it is off. The page becomes the
+/// selected shading correction page.
 //-----------------------------------------------------------------------------
-std::string Camera::getTemperatureStatusLabelFromStatus(enum Camera::Temperature_Status in_temperature_status)
+void Camera::captureShadingCalibration(const int in_page) ///< [in] camera memory page receiving the shading data
 {
-    std::string label = "";
+    DEB_MEMBER_FUNCT();
 
-    switch (in_temperature_status)
+    if(!getDarkSubtractionEnabled())
     {
-        case Camera::Temperature_Status_Not_Supported : label = TEMPERATURE_STATUS_NOT_SUPPORTED; break;
-        case Camera::Temperature_Status_Normal        : label = TEMPERATURE_STATUS_NORMAL       ; break;
-        case Camera::Temperature_Status_Warning       : label = TEMPERATURE_STATUS_WARNING      ; break;
-        case Camera::Temperature_Status_Protection    : label = TEMPERATURE_STATUS_PROTECTION   ; break;
-        default: break;
+        setDarkSubtractionEnabled(true);
     }
 
-    return label;
+    runCalibrationCapture(DCAMPROP_CAPTUREMODE__SHADINGCALIB, DCAM_IDPROP_SHADINGCALIB_SAMPLES, 
+                          DCAM_IDPROP_STORESHADINGCALIBDATATOMEMORY, in_page, "shading");
+
+    setCalibrationProperty(DCAM_IDPROP_SHADINGCALIBDATAMEMORY, static_cast<double>(in_page), "DCAM_IDPROP_SHADINGCALIBDATAMEMORY");
 }
 
 //-----------------------------------------------------------------------------
-// Get the temperature status label.
+/// Enable the subtraction of the selected dark image during the acquisitions
 //-----------------------------------------------------------------------------
-std::string Camera::getTemperatureStatusLabel(void)
+void Camera::setDarkSubtractionEnabled(const bool in_enabled) ///< [in] true to subtract the dark image during the acquisitions
 {
-    return getTemperatureStatusLabelFromStatus(getTemperatureStatus());
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    setCalibrationProperty(DCAM_IDPROP_SUBTRACT, 
+                           static_cast<double>((in_enabled) ? DCAMPROP_MODE__ON : DCAMPROP_MODE__OFF),
+                           "DCAM_IDPROP_SUBTRACT");
 }
 
-//=============================================================================
-// COOLER STATUS
-//=============================================================================
 //-----------------------------------------------------------------------------
-// Get a cooler status label from a status.
+/// Check if the dark image is subtracted during the acquisitions
 //-----------------------------------------------------------------------------
-std::string Camera::getCoolerStatusLabelFromStatus(enum Camera::Cooler_Status in_cooler_status)
+bool Camera::getDarkSubtractionEnabled(void)
 {
-    std::string label = "";
-
-    switch (in_cooler_status)
-    {
-        case Camera::Cooler_Status_Not_Supported : label = COOLER_STATUS_NOT_SUPPORTED; break;
-        case Camera::Cooler_Status_Error4        : label = COOLER_STATUS_ERROR4       ; break;
-        case Camera::Cooler_Status_Error3        : label = COOLER_STATUS_ERROR3       ; break;
-        case Camera::Cooler_Status_Error2        : label = COOLER_STATUS_ERROR2       ; break;
-        case Camera::Cooler_Status_Error1        : label = COOLER_STATUS_ERROR1       ; break;
-        case Camera::Cooler_Status_None          : label = COOLER_STATUS_NONE         ; break;
-        case Camera::Cooler_Status_Off           : label = COOLER_STATUS_OFF          ; break;
-        case Camera::Cooler_Status_Ready         : label = COOLER_STATUS_READY        ; break;
-        case Camera::Cooler_Status_Busy          : label = COOLER_STATUS_BUSY         ; break;
-        case Camera::Cooler_Status_Always        : label = COOLER_STATUS_ALWAYS       ; break;
-        case Camera::Cooler_Status_Warning       : label = COOLER_STATUS_WARNING      ; break;
+    DEB_MEMBER_FUNCT();
+    return (static_cast<int>(getCalibrationProperty(DCAM_IDPROP_SUBTRACT, "DCAM_IDPROP_SUBTRACT")) == DCAMPROP_MODE__ON);
+}
 
-        default: break;
-    }
+//-----------------------------------------------------------------------------
+/// Select the camera memory page of the subtracted dark image
+//-----------------------------------------------------------------------------
+void Camera::setDarkSubtractionPage(const int in_page) ///< [in] camera memory page of the subtracted dark image
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_page);
 
-    return label;
+    setCalibrationProperty(DCAM_IDPROP_SUBTRACTIMAGEMEMORY, static_cast<double>(in_page), "DCAM_IDPROP_SUBTRACTIMAGEMEMORY");
 }
 
 //-----------------------------------------------------------------------------
-/// Return the cooler status support by the current detector
+/// Get the camera memory page of the subtracted dark image
 //-----------------------------------------------------------------------------
-bool Camera::isCoolerStatusSupported(void)
+int Camera::getDarkSubtractionPage(void)
 {
-    return !(getCoolerStatus() == Cooler_Status::Cooler_Status_Not_Supported);
+    DEB_MEMBER_FUNCT();
+    return static_cast<int>(getCalibrationProperty(DCAM_IDPROP_SUBTRACTIMAGEMEMORY, "DCAM_IDPROP_SUBTRACTIMAGEMEMORY"));
 }
 
 //-----------------------------------------------------------------------------
-/// Return the current cooler status
+/// Enable the shading correction with the selected data during the acquisitions
 //-----------------------------------------------------------------------------
-enum Camera::Cooler_Status Camera::getCoolerStatus(void)
+void Camera::setShadingCorrectionEnabled(const bool in_enabled) ///< [in] true to correct the shading during the acquisitions
 {
     DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
 
-    enum Cooler_Status result = Cooler_Status::Cooler_Status_Not_Supported;
+    setCalibrationProperty(DCAM_IDPROP_SHADINGCORRECTION, 
+                           static_cast<double>((in_enabled) ? DCAMPROP_MODE__ON : DCAMPROP_MODE__OFF),
+                           "DCAM_IDPROP_SHADINGCORRECTION");
+}
 
-    DCAMERR err ;
-    double  temp;
-    
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_SENSORCOOLERSTATUS, &temp );
-    
-    if( failed(err) )
-    {
-        manage_trace( deb, "Unable to retrieve the cooler status", err, "dcamprop_getvalue - DCAM_IDPROP_SENSORCOOLERSTATUS");
+//-----------------------------------------------------------------------------
+/// Check if the shading is corrected during the acquisitions
+//-----------------------------------------------------------------------------
+bool Camera::getShadingCorrectionEnabled(void)
+{
+    DEB_MEMBER_FUNCT();
+    return (static_cast<int>(getCalibrationProperty(DCAM_IDPROP_SHADINGCORRECTION, "DCAM_IDPROP_SHADINGCORRECTION")) == DCAMPROP_MODE__ON);
+}
 
-        if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
-        {
-            THROW_HW_ERROR(Error) << "Unable to retrieve the cooler status";
-        }
-    }    
-    else
-    {
-        int32 nMode = static_cast<int32>(temp);
+//-----------------------------------------------------------------------------
+/// Select the camera memory page of the shading correction data
+//-----------------------------------------------------------------------------
+void Camera::setShadingCorrectionPage(const int in_page) ///< [in] camera memory page of the shading correction data
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_page);
 
-        DEB_TRACE() << DEB_VAR1(nMode);
+    setCalibrationProperty(DCAM_IDPROP_SHADINGCALIBDATAMEMORY, static_cast<double>(in_page), "DCAM_IDPROP_SHADINGCALIBDATAMEMORY");
+}
 
-        switch (nMode)
-        {
-            case DCAMPROP_SENSORCOOLERSTATUS__ERROR4 : result = Cooler_Status::Cooler_Status_Error4 ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__ERROR3 : result = Cooler_Status::Cooler_Status_Error3 ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__ERROR2 : result = Cooler_Status::Cooler_Status_Error2 ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__ERROR1 : result = Cooler_Status::Cooler_Status_Error1 ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__NONE   : result = Cooler_Status::Cooler_Status_None   ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__OFF    : result = Cooler_Status::Cooler_Status_Off    ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__READY  : result = Cooler_Status::Cooler_Status_Ready  ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__BUSY   : result = Cooler_Status::Cooler_Status_Busy   ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__ALWAYS : result = Cooler_Status::Cooler_Status_Always ; break;
-            case DCAMPROP_SENSORCOOLERSTATUS__WARNING: result = Cooler_Status::Cooler_Status_Warning; break;
-            default: break; // result will be Cooler_Status_Not_Supported
-        }
-    }
-    
-    return result;
+//-----------------------------------------------------------------------------
+/// Get the camera memory page of the shading correction data
+//-----------------------------------------------------------------------------
+int Camera::getShadingCorrectionPage(void)
+{
+    DEB_MEMBER_FUNCT();
+    return static_cast<int>(getCalibrationProperty(DCAM_IDPROP_SHADINGCALIBDATAMEMORY, "DCAM_IDPROP_SHADINGCALIBDATAMEMORY"));
 }
 
 //-----------------------------------------------------------------------------
-// Get the cooler status label.
+/// Get the readout directions covered by the current dark data
 //-----------------------------------------------------------------------------
-std::string Camera::getCoolerStatusLabel(void)
+enum Camera::Calibration_Status Camera::getDarkCalibrationStatus(void)
 {
-    return getCoolerStatusLabelFromStatus(getCoolerStatus());
+    DEB_MEMBER_FUNCT();
+    return getCalibrationStatus(DCAM_IDPROP_SUBTRACT_DATASTATUS, "DCAM_IDPROP_SUBTRACT_DATASTATUS");
+}
+
+//-----------------------------------------------------------------------------
+/// Get the readout directions covered by the current shading data
+//-----------------------------------------------------------------------------
+enum Camera::Calibration_Status Camera::getShadingCalibrationStatus(void)
+{
+    DEB_MEMBER_FUNCT();
+    return getCalibrationStatus(DCAM_IDPROP_SHADINGCALIB_DATASTATUS, "DCAM_IDPROP_SHADINGCALIB_DATASTATUS");
 }
 
 //=============================================================================
-// HIGH DYNAMIC RANGE
+// MULTI-REGION READOUT
 //=============================================================================
 //-----------------------------------------------------------------------------
-/// Return the high dynamic range support by the current detector
+/// Set the sensor regions given to lima. The camera reads the bounding box of
+/// the regions (subarray) and the copy packs the regions in the lima frame, 
+/// one under the other (the lines narrower than the widest region are padded 
+/// with zeros). If the camera supports the DCAM region data, it also only
+/// reads the regions. The lima frame size changes, the lima roi stays the 
+/// full frame. An empty list goes back to the whole sensor.
 //-----------------------------------------------------------------------------
-bool Camera::isHighDynamicRangeSupported(void)
+void Camera::setRegions(const std::vector<Roi> & in_regions) ///< [in] sensor regions given to lima, packed in one frame (empty: none)
 {
     DEB_MEMBER_FUNCT();
 
-    DCAMERR err;
-    bool    supported;
-    double  temp;
-    
-    err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, &temp );
-    
-    if( failed(err) )
+    if(m_thread.getStatus() != CameraThread::Ready)
     {
-        if((err == DCAMERR_INVALIDPROPERTYID)||(err == DCAMERR_NOTSUPPORT))
+        THROW_HW_ERROR(Error) << "Cannot change the regions during an acquisition!";
+    }
+
+    if(static_cast<int>(in_regions.size()) > g_regions_max)
+    {
+        THROW_HW_ERROR(Error) << "Too many regions " << in_regions.size() << " (maximum " << g_regions_max << ")";
+    }
+
+    if(!in_regions.empty())
+    {
+        if(m_view_mode_enabled)
         {
-            supported = false;
+            THROW_HW_ERROR(Error) << "The multi-region readout is not possible in W-VIEW mode!";
         }
-        else
+
+        if((m_bin.getX() != 1) || (m_bin.getY() != 1))
         {
-            manage_trace( deb, "Unable to retrieve the high dynamic range mode", err, "dcamprop_getvalue - DCAM_IDPROP_HIGHDYNAMICRANGE_MODE");
-            THROW_HW_ERROR(Error) << "Unable to retrieve the high dynamic range mode";
+            THROW_HW_ERROR(Error) << "The multi-region readout needs a 1x1 binning!";
         }
-    }    
-    else
+    }
+
+    for(size_t region_index = 0 ; region_index < in_regions.size() ; region_index++)
     {
-        supported = true;
+        const Roi & region = in_regions[region_index];
+        Point       top    = region.getTopLeft();
+        Size        size   = region.getSize   ();
+
+        if((size.getWidth() <= 0) || (size.getHeight() <= 0) || (top.x < 0) || (top.y < 0) ||
+           (top.x + size.getWidth () > m_max_image_width ) ||
+           (top.y + size.getHeight() > m_max_image_height))
+        {
+            THROW_HW_ERROR(Error) << "Invalid region " << region_index << ": " << region;
+        }
     }
 
-    return supported;
-}
+    m_thread.releasePreparedBuffers(); // the image layout changes
 
-//-----------------------------------------------------------------------------
-/// get the current high dynamic range activation state
-//-----------------------------------------------------------------------------
-bool Camera::getHighDynamicRangeEnabled(void)
-{
-    DEB_MEMBER_FUNCT();
+    ImageType image_type;
+    getImageType(image_type);
 
-    DCAMERR err;
-    double  temp;
-    bool    high_dynamic_range_mode = false;
-    
-    if(getStatus() == CameraThread::Ready)
+    if(in_regions.empty())
     {
-        err = dcamprop_getvalue( m_camera_handle, DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, &temp );
-        
-        if( failed(err) )
-        {
-            manage_trace( deb, "Unable to retrieve the high dynamic range mode", err, "dcamprop_getvalue - DCAM_IDPROP_HIGHDYNAMICRANGE_MODE");
+        if(m_hw_regions)
+            setHardwareRegions(in_regions);
 
-            if((err != DCAMERR_INVALIDPROPERTYID)&&(err != DCAMERR_NOTSUPPORT))
-            {
-                THROW_HW_ERROR(Error) << "Unable to retrieve the high dynamic range mode";
-            }
-        }    
-        else
+        m_regions.clear       ();
+        m_regions_layout.clear();
+        m_hw_regions = false;
+
+        if (!dcamex_setsubarrayrect(m_camera_handle, 0, 0, m_max_image_width, m_max_image_height, g_get_sub_array_do_not_use_view))
         {
-            int high_dynamic_range = static_cast<int>(temp);
+            manage_error( deb, "Cannot set detector ROI!");
+            THROW_HW_ERROR(Error) << "Cannot set detector ROI!";
+        }
 
-            DEB_TRACE() << DEB_VAR1(high_dynamic_range);
+        m_roi = Roi(Point(0, 0), Size(m_max_image_width, m_max_image_height));
 
-            if(high_dynamic_range == DCAMPROP_MODE__OFF) high_dynamic_range_mode = false;
-            else
-            if(high_dynamic_range == DCAMPROP_MODE__ON ) high_dynamic_range_mode = true ;
-            else
-            {
-                manage_trace( deb, "The read high dynamic range mode is incoherent!", err, "dcamprop_getvalue - DCAM_IDPROP_HIGHDYNAMICRANGE_MODE");
-            }
-        }
+        // lima goes back to the whole sensor
+        maxImageSizeChanged(Size(m_max_image_width, m_max_image_height), image_type);
+        return;
     }
-    else
-    // do not call the sdk functions during acquisition
+
+    // bounding box of the regions, aligned on the subarray steps
+    int left   = m_max_image_width ;
+    int top    = m_max_image_height;
+    int right  = 0;
+    int bottom = 0;
+    int width  = 0; // width of the packed frame
+
+    for(size_t region_index = 0 ; region_index < in_regions.size() ; region_index++)
     {
-        high_dynamic_range_mode = m_hdr_enabled;
+        const Roi & region = in_regions[region_index];
+
+        left   = std::min(left  , region.getTopLeft().x);
+        top    = std::min(top   , region.getTopLeft().y);
+        right  = std::max(right , region.getTopLeft().x + region.getSize().getWidth ());
+        bottom = std::max(bottom, region.getTopLeft().y + region.getSize().getHeight());
+        width  = std::max(width , region.getSize().getWidth());
     }
-    
-    return high_dynamic_range_mode;
+
+    int pos_step_x  = (m_feature_pos_x.m_has_step ) ? static_cast<int>(m_feature_pos_x.m_step ) : 1;
+    int pos_step_y  = (m_feature_pos_y.m_has_step ) ? static_cast<int>(m_feature_pos_y.m_step ) : 1;
+    int size_step_x = (m_feature_size_x.m_has_step) ? static_cast<int>(m_feature_size_x.m_step) : 1;
+    int size_step_y = (m_feature_size_y.m_has_step) ? static_cast<int>(m_feature_size_y.m_step) : 1;
+
+    left = (left / pos_step_x) * pos_step_x;
+    top  = (top  / pos_step_y) * pos_step_y;
+
+    int bbox_width  = std::min(((right  - left + size_step_x - 1) / size_step_x) * size_step_x, static_cast<int>(m_max_image_width  - left));
+    int bbox_height = std::min(((bottom - top  + size_step_y - 1) / size_step_y) * size_step_y, static_cast<int>(m_max_image_height - top ));
+
+    DEB_TRACE() << "Regions bounding box: " << left << ", " << top << ", " << bbox_width << ", " << bbox_height;
+
+    if (!dcamex_setsubarrayrect(m_camera_handle, left, top, bbox_width, bbox_height, g_get_sub_array_do_not_use_view))
+    {
+        manage_error( deb, "Cannot set the bounding box of the regions!");
+        THROW_HW_ERROR(Error) << "Cannot set the bounding box of the regions!";
+    }
+
+    m_roi          = Roi(Point(left, top), Size(bbox_width, bbox_height));
+    m_regions_bbox = m_roi;
+
+    // the regions are packed one under the other
+    int height = 0;
+
+    m_regions_layout.clear();
+
+    for(size_t region_index = 0 ; region_index < in_regions.size() ; region_index++)
+    {
+        m_regions_layout.push_back(Roi(Point(0, height), in_regions[region_index].getSize()));
+        height += in_regions[region_index].getSize().getHeight();
+    }
+
+    m_regions            = in_regions;
+    m_regions_frame_size = Size(width, height);
+    m_hw_regions         = setHardwareRegions(in_regions);
+
+    DEB_TRACE() << "Regions frame: " << width << "x" << height << ", in hardware: " << m_hw_regions;
+
+    // lima reallocates its buffers with the packed frame size
+    maxImageSizeChanged(m_regions_frame_size, image_type);
 }
 
 //-----------------------------------------------------------------------------
-/// set the current high dynamic range activation state
+/// Get the sensor regions given to lima
 //-----------------------------------------------------------------------------
-void Camera::setHighDynamicRangeEnabled(const bool & in_enabled)
+void Camera::getRegions(std::vector<Roi> & out_regions) ///< [out] sensor regions of the acquisitions
+{
+    DEB_MEMBER_FUNCT();
+    out_regions = m_regions;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the position of each region in the lima frame
+//-----------------------------------------------------------------------------
+void Camera::getRegionsLayout(std::vector<Roi> & out_layout) ///< [out] position of each region in the lima frame
+{
+    DEB_MEMBER_FUNCT();
+    out_layout = m_regions_layout;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the camera only reads the regions (DCAM region data), otherwise
+/// it reads their bounding box.
+//-----------------------------------------------------------------------------
+bool Camera::getRegionsInHardware(void)
+{
+    DEB_MEMBER_FUNCT();
+    return m_hw_regions;
+}
+
+//-----------------------------------------------------------------------------
+/// Give the regions to the camera with the DCAM region data (rectangle array),
+/// if it supports them. An empty list gives the whole sensor back.
+/// Return true if the camera reads the regions.
+//-----------------------------------------------------------------------------
+bool Camera::setHardwareRegions(const std::vector<Roi> & in_regions) ///< [in] sensor regions read by the camera (empty: whole sensor)
 {
     DEB_MEMBER_FUNCT();
 
     DCAMERR err;
 
-    double temp = (in_enabled) ? static_cast<double>(DCAMPROP_MODE__ON) : static_cast<double>(DCAMPROP_MODE__OFF);
+    DCAMDEV_CAPABILITY_REGION capregion;
+    memset( &capregion, 0, sizeof(capregion) );
+    capregion.hdr.size   = sizeof(capregion);
+    capregion.hdr.domain = DCAMDEV_CAPDOMAIN__DCAMDATA;
+    capregion.hdr.kind   = DCAMDATA_KIND__REGION;
 
-    // set the value
-    err = dcamprop_setvalue( m_camera_handle, DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, temp);
+    err = dcamdev_getcapability( m_camera_handle, &capregion.hdr );
 
-    if( failed(err) )
+    if( failed(err) || (!(capregion.hdr.capflag & DCAMDATA_REGIONTYPE__RECT16ARRAY)) || (!(capregion.hdr.capflag & DCAMDATA_REGIONTYPE__ACCESSREADY)) )
     {
-        manage_error( deb, "Cannot set high dynamic range mode", err, 
-                      "dcamprop_setvalue", "IDPROP=DCAM_IDPROP_HIGHDYNAMICRANGE_MODE, VALUE=%d", static_cast<int>(temp));
-        THROW_HW_ERROR(Error) << "Cannot set high dynamic range mode";
+        DEB_TRACE() << "The camera does not support the region data, the bounding box of the regions is read";
+        return false;
     }
 
-    manage_trace( deb, "Changed high dynamic range mode", DCAMERR_NONE, NULL, "%s", ((in_enabled) ? "DCAMPROP_MODE__ON" : "DCAMPROP_MODE__OFF"));
+    // right and bottom are included
+    std::vector<DCAMDATA_REGIONRECT> rects;
 
-    // forcing the image pixel type to 16 bits
-    dcamex_setimagepixeltype( m_camera_handle, DCAM_PIXELTYPE_MONO16);
+    if(in_regions.empty())
+    {
+        DCAMDATA_REGIONRECT rect;
+        rect.left   = 0;
+        rect.top    = 0;
+        rect.right  = static_cast<short>(m_max_image_width  - 1);
+        rect.bottom = static_cast<short>(m_max_image_height - 1);
+        rects.push_back(rect);
+    }
 
-    // keep the latest value
-    m_hdr_enabled = in_enabled;
+    for(size_t region_index = 0 ; region_index < in_regions.size() ; region_index++)
+    {
+        const Roi & region = in_regions[region_index];
+
+        DCAMDATA_REGIONRECT rect;
+        rect.left   = static_cast<short>(region.getTopLeft().x);
+        rect.top    = static_cast<short>(region.getTopLeft().y);
+        rect.right  = static_cast<short>(region.getTopLeft().x + region.getSize().getWidth () - 1);
+        rect.bottom = static_cast<short>(region.getTopLeft().y + region.getSize().getHeight() - 1);
+        rects.push_back(rect);
+    }
+
+    DCAMDATA_REGION regiondata;
+    memset( &regiondata, 0, sizeof(regiondata) );
+    regiondata.hdr.size  = sizeof(regiondata);
+    regiondata.hdr.iKind = DCAMDATA_KIND__REGION;
+    regiondata.type      = DCAMDATA_REGIONTYPE__RECT16ARRAY;
+    regiondata.data      = &rects[0];
+    regiondata.datasize  = static_cast<int32>(sizeof(DCAMDATA_REGIONRECT) * rects.size());
+
+    err = dcamdev_setdata( m_camera_handle, &regiondata.hdr );
+
+    if( failed(err) )
+    {
+        // the copy still packs the regions of the bounding box
+        manage_trace( deb, "Cannot set the region data, the bounding box of the regions is read", err, 
+                      "dcamdev_setdata", "KIND:REGION, TYPE:RECT16ARRAY, %d rectangles", static_cast<int>(rects.size()));
+        return false;
+    }
+
+    return !in_regions.empty();
 }
 
 //=============================================================================
@@ -3545,6 +8552,8 @@ void Camera::setParameter(std::string parameter_name, double value)
 {
     DEB_MEMBER_FUNCT();
 
+    m_thread.releasePreparedBuffers(); // the image layout can change
+
 	DCAMERR err;
     int parameter_id = m_map_parameters[parameter_name];
     err = dcamprop_setvalue(m_camera_handle, parameter_id, value);
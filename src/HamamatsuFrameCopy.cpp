@@ -0,0 +1,888 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <string.h>
+#include <vector>
+#include "lima/Timestamp.h"
+#include "HamamatsuFrameCopy.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// SIMD kernels are only built for x86 targets.
+// Visual Studio allows the use of the SSSE3/AVX2/AVX-512 intrinsics without /arch 
+// flag, gcc needs the target attribute on each function using them.
+// AVX-512 intrinsics are available since Visual Studio 2017 (15.3).
+//-----------------------------------------------------------------------------
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define HAMAMATSU_COPY_X86
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define HAMAMATSU_TARGET_SSSE3
+        #define HAMAMATSU_TARGET_AVX2
+        #define HAMAMATSU_TARGET_AVX512
+        #if (_MSC_VER >= 1911)
+            #define HAMAMATSU_COPY_AVX512
+        #endif
+    #else
+        #include <cpuid.h>
+        #define HAMAMATSU_TARGET_SSSE3  __attribute__((target("ssse3")))
+        #define HAMAMATSU_TARGET_AVX2   __attribute__((target("avx2")))
+        #define HAMAMATSU_TARGET_AVX512 __attribute__((target("avx512f")))
+        #define HAMAMATSU_COPY_AVX512
+    #endif
+#endif
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+//-----------------------------------------------------------------------------
+FrameCopy::Kernel FrameCopy::s_kernel       = FrameCopy::Kernel_Scalar;
+FrameCopy::Kernel FrameCopy::s_best_kernel  = FrameCopy::Kernel_Scalar;
+size_t            FrameCopy::s_nt_threshold = 0    ;
+bool              FrameCopy::s_initialized  = false;
+
+static const size_t g_default_llc_size = 8 * 1024 * 1024; // used if the last level cache size is unknown
+
+//-----------------------------------------------------------------------------
+// Unpack a line of 12 bits pixels (3 bytes for 2 pixels) to 16 bits
+//-----------------------------------------------------------------------------
+static void unpack12_line_scalar(unsigned short * dst, const unsigned char * src, int width, bool mono12p)
+{
+    int x = 0;
+
+    if(mono12p)
+    {
+        // B0 = P0[7:0], B1 = P1[3:0] | P0[11:8], B2 = P1[11:4]
+        for( ; x + 1 < width ; x += 2, src += 3)
+        {
+            dst[x    ] = static_cast<unsigned short>( src[0]       | ((src[1] & 0x0F) << 8));
+            dst[x + 1] = static_cast<unsigned short>((src[1] >> 4) |  (src[2]         << 4));
+        }
+
+        if(x < width)
+            dst[x] = static_cast<unsigned short>(src[0] | ((src[1] & 0x0F) << 8));
+    }
+    else
+    {
+        // B0 = P0[11:4], B1 = P1[3:0] | P0[3:0], B2 = P1[11:4]
+        for( ; x + 1 < width ; x += 2, src += 3)
+        {
+            dst[x    ] = static_cast<unsigned short>((src[0] << 4) | (src[1] & 0x0F));
+            dst[x + 1] = static_cast<unsigned short>((src[2] << 4) | (src[1] >> 4  ));
+        }
+
+        if(x < width)
+            dst[x] = static_cast<unsigned short>((src[0] << 4) | (src[1] & 0x0F));
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Reduce a line of 16 bits pixels to a 8 bits window, saturated to 255
+//-----------------------------------------------------------------------------
+static void window8_line_scalar(unsigned char * dst, const unsigned short * src, int width, int shift)
+{
+    for(int x = 0 ; x < width ; x++)
+    {
+        unsigned int value = static_cast<unsigned int>(src[x]) >> shift;
+        dst[x] = static_cast<unsigned char>((value > 0xFF) ? 0xFF : value);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Add a line of 16 bits pixels to 32 bits sums (or start the sums with it),
+// return the number of pixels at or above the saturation value
+//-----------------------------------------------------------------------------
+static long accumulate16_line_scalar(unsigned int * dst, const unsigned short * src, int width, bool first, unsigned short saturation)
+{
+    long saturated = 0;
+
+    for(int x = 0 ; x < width ; x++)
+    {
+        dst[x]     = (first) ? src[x] : dst[x] + src[x];
+        saturated += (src[x] >= saturation) ? 1 : 0;
+    }
+
+    return saturated;
+}
+
+#if defined(HAMAMATSU_COPY_X86)
+//-----------------------------------------------------------------------------
+// cpuid and xgetbv wrappers
+//-----------------------------------------------------------------------------
+static void cpu_id(int info[4], int leaf, int sub_leaf)
+{
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, sub_leaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, sub_leaf, a, b, c, d);
+    info[0] = a; info[1] = b; info[2] = c; info[3] = d;
+#endif
+}
+
+static unsigned long long xcr0(void)
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Copy a line with 256 bits streaming stores
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_AVX2
+static void copy_line_stream_avx2(char * dst, const char * src, size_t size)
+{
+    // normal stores until the destination is aligned on 32 bytes
+    size_t head = (32 - (reinterpret_cast<size_t>(dst) & 31)) & 31;
+
+    if(head > size)
+        head = size;
+
+    memcpy(dst, src, head);
+    dst  += head;
+    src  += head;
+    size -= head;
+
+    for(size_t nb_blocks = size / 128 ; nb_blocks > 0 ; nb_blocks--)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src     ));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 32));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 64));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 96));
+
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst     ), a);
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + 32), b);
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + 64), c);
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst + 96), d);
+
+        src += 128;
+        dst += 128;
+    }
+
+    memcpy(dst, src, size & 127);
+    _mm256_zeroupper();
+}
+
+#if defined(HAMAMATSU_COPY_AVX512)
+//-----------------------------------------------------------------------------
+// Copy a line with 512 bits streaming stores
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_AVX512
+static void copy_line_stream_avx512(char * dst, const char * src, size_t size)
+{
+    // normal stores until the destination is aligned on 64 bytes
+    size_t head = (64 - (reinterpret_cast<size_t>(dst) & 63)) & 63;
+
+    if(head > size)
+        head = size;
+
+    memcpy(dst, src, head);
+    dst  += head;
+    src  += head;
+    size -= head;
+
+    for(size_t nb_blocks = size / 256 ; nb_blocks > 0 ; nb_blocks--)
+    {
+        __m512i a = _mm512_loadu_si512(reinterpret_cast<const void *>(src      ));
+        __m512i b = _mm512_loadu_si512(reinterpret_cast<const void *>(src +  64));
+        __m512i c = _mm512_loadu_si512(reinterpret_cast<const void *>(src + 128));
+        __m512i d = _mm512_loadu_si512(reinterpret_cast<const void *>(src + 192));
+
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(dst      ), a);
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(dst +  64), b);
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + 128), c);
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + 192), d);
+
+        src += 256;
+        dst += 256;
+    }
+
+    memcpy(dst, src, size & 255);
+    _mm256_zeroupper();
+}
+#endif // HAMAMATSU_COPY_AVX512
+
+//-----------------------------------------------------------------------------
+// Unpack a line of 12 bits pixels with SSSE3: 8 pixels (12 bytes) at a time.
+// Each pair of pixels is gathered in two 16 bits words, the even word is 
+// masked (and shifted for Mono12) and the odd word shifted.
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_SSSE3
+static void unpack12_line_ssse3(unsigned short * dst, const unsigned char * src, int width, bool mono12p)
+{
+    const __m128i gather   = mono12p ? _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11)   // B1B0, B2B1
+                                     : _mm_setr_epi8(1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);  // B0B1, B2B1
+    const __m128i even     = _mm_set1_epi32(mono12p ? 0x00000FFF : 0x0000000F);
+    const __m128i odd      = _mm_set1_epi32(mono12p ? static_cast<int>(0xFFFF0000) : static_cast<int>(0xFFFF0FF0));
+    long          src_size = (static_cast<long>(width) * 3 + 1) / 2;
+    int           x        = 0;
+
+    // the 16 bytes loads must stay in the line
+    for( ; (x + 8 <= width) && ((x / 2) * 3 + 16 <= src_size) ; x += 8, src += 12)
+    {
+        __m128i words   = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)), gather);
+        __m128i shifted = _mm_srli_epi16(words, 4);
+
+        // Mono12P: even = word & 0xFFF, odd = word >> 4
+        // Mono12 : even = ((word >> 4) & 0xFF0) | (word & 0xF), odd = word >> 4
+        __m128i pixels  = _mm_or_si128(_mm_and_si128(words, even), _mm_and_si128(shifted, odd));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), pixels);
+    }
+
+    unpack12_line_scalar(dst + x, src, width - x, mono12p);
+}
+
+//-----------------------------------------------------------------------------
+// Unpack a line of 12 bits pixels with AVX2: 16 pixels (24 bytes) at a time,
+// 12 bytes in each 128 bits lane.
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_AVX2
+static void unpack12_line_avx2(unsigned short * dst, const unsigned char * src, int width, bool mono12p)
+{
+    const __m256i lanes    = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i gather   = mono12p ? _mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+                                                    0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11)
+                                     : _mm256_setr_epi8(1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11,
+                                                    1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m256i even     = _mm256_set1_epi32(mono12p ? 0x00000FFF : 0x0000000F);
+    const __m256i odd      = _mm256_set1_epi32(mono12p ? static_cast<int>(0xFFFF0000) : static_cast<int>(0xFFFF0FF0));
+    long          src_size = (static_cast<long>(width) * 3 + 1) / 2;
+    int           x        = 0;
+
+    // the 32 bytes loads must stay in the line
+    for( ; (x + 16 <= width) && ((x / 2) * 3 + 32 <= src_size) ; x += 16, src += 24)
+    {
+        __m256i bytes   = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)), lanes);
+        __m256i words   = _mm256_shuffle_epi8(bytes, gather);
+        __m256i shifted = _mm256_srli_epi16(words, 4);
+        __m256i pixels  = _mm256_or_si256(_mm256_and_si256(words, even), _mm256_and_si256(shifted, odd));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), pixels);
+    }
+
+    _mm256_zeroupper();
+    unpack12_line_scalar(dst + x, src, width - x, mono12p);
+}
+
+//-----------------------------------------------------------------------------
+// Reduce a line of 16 bits pixels to 8 bits with SSSE3: 16 pixels at a time.
+// There is no unsigned 16 bits min before SSE4.1, the saturation is done with
+// an unsigned saturated add and sub of 0xFF00. packus then works on values
+// below 256.
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_SSSE3
+static void window8_line_ssse3(unsigned char * dst, const unsigned short * src, int width, int shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m128i clip  = _mm_set1_epi16(static_cast<short>(0xFF00));
+    int           x     = 0;
+
+    for( ; x + 16 <= width ; x += 16)
+    {
+        __m128i low  = _mm_srl_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x    )), count);
+        __m128i high = _mm_srl_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 8)), count);
+
+        low  = _mm_subs_epu16(_mm_adds_epu16(low , clip), clip);
+        high = _mm_subs_epu16(_mm_adds_epu16(high, clip), clip);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(low, high));
+    }
+
+    window8_line_scalar(dst + x, src + x, width - x, shift);
+}
+
+//-----------------------------------------------------------------------------
+// Reduce a line of 16 bits pixels to 8 bits with AVX2: 32 pixels at a time.
+// packus works by 128 bits lane, the qwords are put back in order after it.
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_AVX2
+static void window8_line_avx2(unsigned char * dst, const unsigned short * src, int width, int shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m256i clip  = _mm256_set1_epi16(0xFF);
+    int           x     = 0;
+
+    for( ; x + 32 <= width ; x += 32)
+    {
+        __m256i low  = _mm256_srl_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x     )), count);
+        __m256i high = _mm256_srl_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x + 16)), count);
+
+        low  = _mm256_min_epu16(low , clip);
+        high = _mm256_min_epu16(high, clip);
+
+        __m256i pixels = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), pixels);
+    }
+
+    _mm256_zeroupper();
+    window8_line_scalar(dst + x, src + x, width - x, shift);
+}
+
+//-----------------------------------------------------------------------------
+// Sum a line of 16 bits pixels in 32 bits with SSSE3: 8 pixels at a time.
+// A pixel is saturated if the saturated sub (saturation - pixel) gives 0, the
+// 16 bits counters of each lane cannot overflow for a line.
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_SSSE3
+static long accumulate16_line_ssse3(unsigned int * dst, const unsigned short * src, int width, bool first, unsigned short saturation)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16(static_cast<short>(saturation));
+    __m128i       count = _mm_setzero_si128();
+    int           x     = 0;
+
+    for( ; x + 8 <= width ; x += 8)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i low    = _mm_unpacklo_epi16(pixels, zero);
+        __m128i high   = _mm_unpackhi_epi16(pixels, zero);
+
+        if(!first)
+        {
+            low  = _mm_add_epi32(low , _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + x    )));
+            high = _mm_add_epi32(high, _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + x + 4)));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x    ), low );
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x + 4), high);
+
+        count = _mm_sub_epi16(count, _mm_cmpeq_epi16(_mm_subs_epu16(limit, pixels), zero));
+    }
+
+    unsigned short counts[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(counts), count);
+
+    long saturated = 0;
+
+    for(int lane = 0 ; lane < 8 ; lane++)
+        saturated += counts[lane];
+
+    return saturated + accumulate16_line_scalar(dst + x, src + x, width - x, first, saturation);
+}
+
+//-----------------------------------------------------------------------------
+// Sum a line of 16 bits pixels in 32 bits with AVX2: 16 pixels at a time
+//-----------------------------------------------------------------------------
+HAMAMATSU_TARGET_AVX2
+static long accumulate16_line_avx2(unsigned int * dst, const unsigned short * src, int width, bool first, unsigned short saturation)
+{
+    const __m256i limit = _mm256_set1_epi16(static_cast<short>(saturation));
+    __m256i       count = _mm256_setzero_si256();
+    int           x     = 0;
+
+    for( ; x + 16 <= width ; x += 16)
+    {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x));
+        __m256i low    = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(pixels));
+        __m256i high   = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(pixels, 1));
+
+        if(!first)
+        {
+            low  = _mm256_add_epi32(low , _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + x    )));
+            high = _mm256_add_epi32(high, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + x + 8)));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x    ), low );
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x + 8), high);
+
+        // pixel >= saturation if max(pixel, saturation) == pixel
+        count = _mm256_sub_epi16(count, _mm256_cmpeq_epi16(_mm256_max_epu16(pixels, limit), pixels));
+    }
+
+    unsigned short counts[16];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(counts), count);
+    _mm256_zeroupper();
+
+    long saturated = 0;
+
+    for(int lane = 0 ; lane < 16 ; lane++)
+        saturated += counts[lane];
+
+    return saturated + accumulate16_line_scalar(dst + x, src + x, width - x, first, saturation);
+}
+
+#endif // HAMAMATSU_COPY_X86
+
+//-----------------------------------------------------------------------------
+/// Detect the cpu features and the cache size (done once)
+//-----------------------------------------------------------------------------
+void FrameCopy::init(void)
+{
+    if(s_initialized)
+        return;
+
+    s_best_kernel = Kernel_Scalar;
+
+#if defined(HAMAMATSU_COPY_X86)
+    int info[4];
+
+    cpu_id(info, 0, 0);
+    int max_leaf = info[0];
+
+    cpu_id(info, 1, 0);
+    bool ssse3    = (info[2] & (1 <<  9)) != 0;
+    bool os_xsave = (info[2] & (1 << 27)) != 0;
+    bool avx      = (info[2] & (1 << 28)) != 0;
+
+    if(ssse3)
+        s_best_kernel = Kernel_SSSE3;
+
+    if(os_xsave && avx && (max_leaf >= 7))
+    {
+        unsigned long long xcr = xcr0();
+
+        cpu_id(info, 7, 0);
+
+        // the OS must save the ymm (and zmm) registers
+        if(((xcr & 0x6) == 0x6) && (info[1] & (1 << 5)))
+            s_best_kernel = Kernel_AVX2;
+
+    #if defined(HAMAMATSU_COPY_AVX512)
+        if(((xcr & 0xE6) == 0xE6) && (info[1] & (1 << 16)))
+            s_best_kernel = Kernel_AVX512;
+    #endif
+    }
+#endif
+
+    s_kernel = s_best_kernel;
+
+    if(s_nt_threshold == 0)
+        s_nt_threshold = getLastLevelCacheSize();
+
+    s_initialized = true;
+}
+
+//-----------------------------------------------------------------------------
+/// Return the size of the last level cache
+//-----------------------------------------------------------------------------
+size_t FrameCopy::getLastLevelCacheSize(void)
+{
+    size_t cache_size  = 0;
+
+#if defined(_WIN32)
+    DWORD buffer_size = 0;
+
+    GetLogicalProcessorInformation(NULL, &buffer_size);
+
+    if(buffer_size > 0)
+    {
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(buffer_size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+
+        if(GetLogicalProcessorInformation(&infos[0], &buffer_size))
+        {
+            int cache_level = 0;
+
+            for(size_t info_index = 0 ; info_index < infos.size() ; info_index++)
+            {
+                if((infos[info_index].Relationship == RelationCache) && (infos[info_index].Cache.Level >= cache_level))
+                {
+                    cache_level = infos[info_index].Cache.Level;
+                    cache_size  = infos[info_index].Cache.Size ;
+                }
+            }
+        }
+    }
+#elif defined(_SC_LEVEL3_CACHE_SIZE)
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+    if(size > 0)
+        cache_size = static_cast<size_t>(size);
+#endif
+
+    return (cache_size > 0) ? cache_size : g_default_llc_size;
+}
+
+//-----------------------------------------------------------------------------
+/// Copy an image.
+/// The frames smaller than the non-temporal threshold are copied with memcpy,
+/// so they stay in cache for the lima processing.
+//-----------------------------------------------------------------------------
+void FrameCopy::copy(char       * dst         , ///< [in] top of the destination image
+                     long         dst_rowbytes, ///< [in] bytes between two destination lines
+                     const char * src         , ///< [in] top of the source image
+                     long         src_rowbytes, ///< [in] bytes between two source lines
+                     long         line_size   , ///< [in] useful bytes of a line
+                     int          height      , ///< [in] number of lines
+                     size_t       frame_size  ) ///< [in] size of the whole frame if only a part of it is copied (0: same as the copy)
+{
+    init();
+
+    if(frame_size == 0)
+        frame_size = static_cast<size_t>(line_size) * height;
+
+    // contiguous lines are copied as a single line
+    if((src_rowbytes == line_size) && (dst_rowbytes == line_size))
+    {
+        line_size   *= height;
+        height       = 1;
+    }
+
+#if defined(HAMAMATSU_COPY_X86)
+    if((frame_size >= s_nt_threshold) && (s_kernel >= Kernel_AVX2))
+    {
+        for(int line = 0 ; line < height ; line++)
+        {
+        #if defined(HAMAMATSU_COPY_AVX512)
+            if(s_kernel == Kernel_AVX512)
+                copy_line_stream_avx512(dst, src, line_size);
+            else
+        #endif
+                copy_line_stream_avx2(dst, src, line_size);
+
+            dst += dst_rowbytes;
+            src += src_rowbytes;
+        }
+
+        // the streaming stores are weakly ordered
+        _mm_sfence();
+        return;
+    }
+#endif
+
+    for(int line = 0 ; line < height ; line++)
+    {
+        memcpy(dst, src, line_size);
+        dst += dst_rowbytes;
+        src += src_rowbytes;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Unpack a 12 bits packed image (DCAM_PIXELTYPE_MONO12 or MONO12P) to 16 bits.
+/// The source lines can be padded.
+//-----------------------------------------------------------------------------
+void FrameCopy::unpack12(char       * dst         , ///< [in] top of the 16 bits destination image
+                         long         dst_rowbytes, ///< [in] bytes between two destination lines
+                         const char * src         , ///< [in] top of the 12 bits packed source image
+                         long         src_rowbytes, ///< [in] bytes between two source lines
+                         int          width       , ///< [in] number of pixels of a line
+                         int          height      , ///< [in] number of lines
+                         Conversion   conversion  ) ///< [in] packing of the source (Conversion_Mono12 or Conversion_Mono12P)
+{
+    init();
+
+    bool mono12p = (conversion == Conversion_Mono12P);
+
+    for(int line = 0 ; line < height ; line++)
+    {
+        unsigned short      * d = reinterpret_cast<unsigned short      *>(dst);
+        const unsigned char * s = reinterpret_cast<const unsigned char *>(src);
+
+    #if defined(HAMAMATSU_COPY_X86)
+        if(s_kernel >= Kernel_AVX2)
+            unpack12_line_avx2(d, s, width, mono12p);
+        else
+        if(s_kernel == Kernel_SSSE3)
+            unpack12_line_ssse3(d, s, width, mono12p);
+        else
+    #endif
+            unpack12_line_scalar(d, s, width, mono12p);
+
+        dst += dst_rowbytes;
+        src += src_rowbytes;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Return the useful bytes of a 12 bits packed line
+//-----------------------------------------------------------------------------
+long FrameCopy::getPackedLineSize(int width) ///< [in] number of pixels of a line
+{
+    return (static_cast<long>(width) * 3 + 1) / 2;
+}
+
+//-----------------------------------------------------------------------------
+/// Reduce a 16 bits image to 8 bits, keeping the bits [shift, shift + 7]. 
+/// The pixels above the window are saturated to 255. The source lines can be
+/// padded.
+//-----------------------------------------------------------------------------
+void FrameCopy::window8(char       * dst         , ///< [in] top of the 8 bits destination image
+                        long         dst_rowbytes, ///< [in] bytes between two destination lines
+                        const char * src         , ///< [in] top of the 16 bits source image
+                        long         src_rowbytes, ///< [in] bytes between two source lines
+                        int          width       , ///< [in] number of pixels of a line
+                        int          height      , ///< [in] number of lines
+                        int          shift       ) ///< [in] lowest bit of the window (0 to 8), upper values saturate to 255
+{
+    init();
+
+    for(int line = 0 ; line < height ; line++)
+    {
+        unsigned char        * d = reinterpret_cast<unsigned char        *>(dst);
+        const unsigned short * s = reinterpret_cast<const unsigned short *>(src);
+
+    #if defined(HAMAMATSU_COPY_X86)
+        if(s_kernel >= Kernel_AVX2)
+            window8_line_avx2(d, s, width, shift);
+        else
+        if(s_kernel == Kernel_SSSE3)
+            window8_line_ssse3(d, s, width, shift);
+        else
+    #endif
+            window8_line_scalar(d, s, width, shift);
+
+        dst += dst_rowbytes;
+        src += src_rowbytes;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Add a 16 bits image to 32 bits sums, or start the sums with it. The 
+/// source lines can be padded.
+/// @return number of pixels of the image at or above the saturation value
+//-----------------------------------------------------------------------------
+long FrameCopy::accumulate16(char         * dst         , ///< [in] top of the 32 bits sums
+                             long           dst_rowbytes, ///< [in] bytes between two sum lines
+                             const char   * src         , ///< [in] top of the 16 bits source image
+                             long           src_rowbytes, ///< [in] bytes between two source lines
+                             int            width       , ///< [in] number of pixels of a line
+                             int            height      , ///< [in] number of lines
+                             bool           first       , ///< [in] true to start the sums with this image
+                             unsigned short saturation  ) ///< [in] pixel value counted as saturated
+{
+    init();
+
+    long saturated = 0;
+
+    for(int line = 0 ; line < height ; line++)
+    {
+        unsigned int         * d = reinterpret_cast<unsigned int         *>(dst);
+        const unsigned short * s = reinterpret_cast<const unsigned short *>(src);
+
+    #if defined(HAMAMATSU_COPY_X86)
+        if(s_kernel >= Kernel_AVX2)
+            saturated += accumulate16_line_avx2(d, s, width, first, saturation);
+        else
+        if(s_kernel == Kernel_SSSE3)
+            saturated += accumulate16_line_ssse3(d, s, width, first, saturation);
+        else
+    #endif
+            saturated += accumulate16_line_scalar(d, s, width, first, saturation);
+
+        dst += dst_rowbytes;
+        src += src_rowbytes;
+    }
+
+    return saturated;
+}
+
+//-----------------------------------------------------------------------------
+/// Replace 32 bits sums by their float means, in place
+//-----------------------------------------------------------------------------
+void FrameCopy::average32(char * data     , ///< [in] 32 bits sums, replaced by their float means
+                          size_t nb_pixels, ///< [in] number of pixels
+                          int    nb_images) ///< [in] number of images summed
+{
+    const float scale = (nb_images > 0) ? 1.0f / nb_images : 0.0f;
+
+    for(size_t pixel = 0 ; pixel < nb_pixels ; pixel++, data += 4)
+    {
+        unsigned int sum;
+        memcpy(&sum, data, 4);
+
+        float mean = static_cast<float>(sum) * scale;
+        memcpy(data, &mean, 4);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Return the kernel used for the big frames
+//-----------------------------------------------------------------------------
+FrameCopy::Kernel FrameCopy::getKernel(void)
+{
+    init();
+    return s_kernel;
+}
+
+//-----------------------------------------------------------------------------
+/// Return the name of the kernel used for the big frames
+//-----------------------------------------------------------------------------
+std::string FrameCopy::getKernelName(void)
+{
+    switch(getKernel())
+    {
+        case Kernel_AVX512: return "AVX512";
+        case Kernel_AVX2  : return "AVX2"  ;
+        case Kernel_SSSE3 : return "SSSE3" ;
+        default           : return "SCALAR";
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Force a kernel (the cpu must support it, otherwise the best supported is used)
+//-----------------------------------------------------------------------------
+void FrameCopy::setKernel(Kernel in_kernel) ///< [in] kernel to use (limited to the cpu features)
+{
+    init();
+    s_kernel = (in_kernel > s_best_kernel) ? s_best_kernel : in_kernel;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the frame size from which the streaming stores are used
+//-----------------------------------------------------------------------------
+size_t FrameCopy::getNonTemporalThreshold(void)
+{
+    init();
+    return s_nt_threshold;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the frame size from which the streaming stores are used
+/// (0 restores the default value: the last level cache size)
+//-----------------------------------------------------------------------------
+void FrameCopy::setNonTemporalThreshold(size_t in_threshold) ///< [in] frame size in bytes from which streaming stores are used
+{
+    init();
+    s_nt_threshold = (in_threshold == 0) ? getLastLevelCacheSize() : in_threshold;
+}
+
+//-----------------------------------------------------------------------------
+/// Compare the current kernel with the line by line memcpy of the former copy.
+/// Both copies use the same buffers, so the given geometry should be bigger 
+/// than the cache to measure the memory bandwidth.
+//-----------------------------------------------------------------------------
+void FrameCopy::benchmark(long     line_size     , ///< [in]  useful bytes of a line
+                          long     src_rowbytes  , ///< [in]  bytes between two source lines
+                          int      height        , ///< [in]  number of lines
+                          int      nb_iterations , ///< [in]  number of copies to time
+                          double & reference_rate, ///< [out] line by line memcpy rate (MB/s)
+                          double & kernel_rate   ) ///< [out] current kernel rate (MB/s)
+{
+    std::vector<char> src(static_cast<size_t>(src_rowbytes) * height, 1);
+    std::vector<char> dst(static_cast<size_t>(line_size   ) * height, 0);
+
+    double total_mb = (static_cast<double>(line_size) * height * nb_iterations) / (1024.0 * 1024.0);
+
+    // reference: the former copy
+    Timestamp start = Timestamp::now();
+
+    for(int iteration = 0 ; iteration < nb_iterations ; iteration++)
+    {
+        const char * s = &src[0];
+        char       * d = &dst[0];
+
+        for(int line = 0 ; line < height ; line++)
+        {
+            memcpy(d, s, line_size);
+            d += line_size   ;
+            s += src_rowbytes;
+        }
+    }
+
+    double elapsed = Timestamp::now() - start;
+    reference_rate = (elapsed > 0.0) ? (total_mb / elapsed) : 0.0;
+
+    // current kernel
+    start = Timestamp::now();
+
+    for(int iteration = 0 ; iteration < nb_iterations ; iteration++)
+    {
+        copy(&dst[0], line_size, &src[0], src_rowbytes, line_size, height);
+    }
+
+    elapsed     = Timestamp::now() - start;
+    kernel_rate = (elapsed > 0.0) ? (total_mb / elapsed) : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+/// Compare the current unpack kernel with the scalar unpack.
+/// The rates are given in MB/s of 16 bits pixels written.
+/// The source is filled with pseudo random pixels and the output of the 
+/// kernel is checked against the scalar one: false is returned if they differ.
+//-----------------------------------------------------------------------------
+bool FrameCopy::benchmarkUnpack(int        width        , ///< [in]  number of pixels of a line
+                                int        height       , ///< [in]  number of lines
+                                int        nb_iterations, ///< [in]  number of unpacks to time
+                                Conversion conversion   , ///< [in]  packing of the source
+                                double &   scalar_rate  , ///< [out] scalar unpack rate (MB/s of 16 bits pixels)
+                                double &   kernel_rate  ) ///< [out] current kernel rate (MB/s of 16 bits pixels)
+{
+    long src_rowbytes = getPackedLineSize(width);
+    long dst_rowbytes = static_cast<long>(width) * 2;
+
+    std::vector<char> src    (static_cast<size_t>(src_rowbytes) * height, 0);
+    std::vector<char> dst    (static_cast<size_t>(dst_rowbytes) * height, 0);
+    std::vector<char> dst_ref(static_cast<size_t>(dst_rowbytes) * height, 0);
+
+    // pseudo random packed pixels (linear congruential generator)
+    unsigned int seed = 12345U;
+
+    for(size_t index = 0 ; index < src.size() ; index++)
+    {
+        seed       = seed * 1103515245U + 12345U;
+        src[index] = static_cast<char>(seed >> 16);
+    }
+
+    double total_mb = (static_cast<double>(dst_rowbytes) * height * nb_iterations) / (1024.0 * 1024.0);
+
+    Kernel kernel = getKernel();
+
+    // reference: the scalar unpack
+    s_kernel = Kernel_Scalar;
+
+    Timestamp start = Timestamp::now();
+
+    for(int iteration = 0 ; iteration < nb_iterations ; iteration++)
+    {
+        unpack12(&dst_ref[0], dst_rowbytes, &src[0], src_rowbytes, width, height, conversion);
+    }
+
+    double elapsed = Timestamp::now() - start;
+    scalar_rate    = (elapsed > 0.0) ? (total_mb / elapsed) : 0.0;
+
+    // current kernel
+    s_kernel = kernel;
+    start    = Timestamp::now();
+
+    for(int iteration = 0 ; iteration < nb_iterations ; iteration++)
+    {
+        unpack12(&dst[0], dst_rowbytes, &src[0], src_rowbytes, width, height, conversion);
+    }
+
+    elapsed     = Timestamp::now() - start;
+    kernel_rate = (elapsed > 0.0) ? (total_mb / elapsed) : 0.0;
+
+    // without iteration, the outputs are computed once for the check
+    if(nb_iterations <= 0)
+    {
+        s_kernel = Kernel_Scalar;
+        unpack12(&dst_ref[0], dst_rowbytes, &src[0], src_rowbytes, width, height, conversion);
+        s_kernel = kernel;
+        unpack12(&dst[0], dst_rowbytes, &src[0], src_rowbytes, width, height, conversion);
+    }
+
+    return (memcmp(&dst[0], &dst_ref[0], dst.size()) == 0);
+}
@@ -0,0 +1,493 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <string.h>
+#include "HamamatsuFrameCopyPool.h"
+#include "HamamatsuFrameCopy.h"
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+static const size_t g_default_split_threshold = 8 * 1024 * 1024; // frames from 8 MB are copied by several threads
+
+//-----------------------------------------------------------------------------
+///  Ctor
+//-----------------------------------------------------------------------------
+FrameCopyPool::FrameCopyPool()
+    : m_dropped_ring_frame(-1),
+      m_callback     (NULL) ,
+      m_next_frame_nb(0)    ,
+      m_nb_pending   (0)    ,
+      m_nb_sink_jobs (0)    ,
+      m_delivering   (false),
+      m_quit         (false),
+      m_split_threshold(g_default_split_threshold)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------------------------------
+///  Dtor
+//-----------------------------------------------------------------------------
+FrameCopyPool::~FrameCopyPool()
+{
+    DEB_DESTRUCTOR();
+    stopThreads();
+}
+
+//-----------------------------------------------------------------------------
+/// Change the number of copy threads.
+/// Should only be called when no acquisition is running.
+//-----------------------------------------------------------------------------
+void FrameCopyPool::setNbThreads(const int nb_threads) ///< [in] number of copy threads (0: no thread)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_threads);
+
+    if(nb_threads < 0)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect number of copy threads: " << nb_threads;
+    }
+
+    stopThreads();
+
+    for(int thread_index = 0 ; thread_index < nb_threads ; thread_index++)
+    {
+        WorkerThread * worker = new WorkerThread(*this);
+        m_threads.push_back(worker);
+        worker->start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of copy threads
+//-----------------------------------------------------------------------------
+int FrameCopyPool::getNbThreads(void) const
+{
+    return static_cast<int>(m_threads.size());
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of frames pushed but not given back yet
+//-----------------------------------------------------------------------------
+int FrameCopyPool::getNbPending(void)
+{
+    AutoMutex lock(m_cond.mutex());
+    return m_nb_pending;
+}
+
+//-----------------------------------------------------------------------------
+/// Prepare the reorder stage for a new acquisition
+//-----------------------------------------------------------------------------
+void FrameCopyPool::start(Callback * callback      , ///< [in] object which receives the copied frames
+                          const int  first_frame_nb) ///< [in] number of the first frame of the acquisition
+{
+    DEB_MEMBER_FUNCT();
+
+    AutoMutex lock(m_cond.mutex());
+
+    m_callback      = callback      ;
+    m_next_frame_nb = first_frame_nb;
+    m_nb_pending    = 0             ;
+    m_nb_sink_jobs  = 0             ;
+    m_copied.clear    ();
+    m_parts_left.clear();
+    m_ring_jobs.clear ();
+    m_running_ring_jobs.clear();
+    m_jobs.clear      ();
+
+    m_dropped_ring_frame = -1;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the oldest DCAM frame still read by a job (queued or being copied), 
+/// -1 if no job reads the DCAM ring
+//-----------------------------------------------------------------------------
+int FrameCopyPool::getOldestRingFrame(void)
+{
+    AutoMutex lock(m_cond.mutex());
+    return (m_ring_jobs.empty()) ? -1 : m_ring_jobs.begin()->first;
+}
+
+//-----------------------------------------------------------------------------
+/// The queued jobs which read a DCAM frame up to the given one no longer read 
+/// the ring: their destination is filled with zeros (a sink is told that the 
+/// copy was dropped), so they cannot copy a slot already reused by DCAM. The 
+/// jobs being copied cannot be stopped: their destination is filled with zeros
+/// once their copy is done (torn copy).
+/// Returns the number of lima frames whose copies were dropped (each view or 
+/// image of a bundle is a lima frame).
+//-----------------------------------------------------------------------------
+int FrameCopyPool::dropRingFrames(const int last_ring_frame) ///< [in] last DCAM frame which can be reused by DCAM
+{
+    AutoMutex lock(m_cond.mutex());
+
+    std::set<int> dropped_frames; // lima frames (the parts of a frame are counted once)
+
+    for(std::deque<Job>::iterator job = m_jobs.begin() ; job != m_jobs.end() ; ++job)
+    {
+        if((job->ring_frame < 0) || (job->ring_frame > last_ring_frame))
+            continue;
+
+        if(job->sink == NULL)
+            dropped_frames.insert(job->frame_info.acq_frame_nb);
+
+        releaseRingJob(job->ring_frame);
+
+        job->src        = NULL;
+        job->ring_frame = -1  ;
+    }
+
+    // the copies running now will be torn
+    std::multimap<int, int>::iterator running_end = m_running_ring_jobs.upper_bound(last_ring_frame);
+
+    for(std::multimap<int, int>::iterator running = m_running_ring_jobs.begin() ; running != running_end ; ++running)
+    {
+        if(running->second >= 0)
+            dropped_frames.insert(running->second);
+    }
+
+    if(last_ring_frame > m_dropped_ring_frame)
+        m_dropped_ring_frame = last_ring_frame;
+
+    return static_cast<int>(dropped_frames.size());
+}
+
+//-----------------------------------------------------------------------------
+/// Set the frame size from which a frame is copied by several threads
+//-----------------------------------------------------------------------------
+void FrameCopyPool::setSplitThreshold(const size_t split_threshold) ///< [in] frame size from which a frame is copied by several threads (0: never)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(split_threshold);
+
+    AutoMutex lock(m_cond.mutex());
+    m_split_threshold = split_threshold;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the frame size from which a frame is copied by several threads
+//-----------------------------------------------------------------------------
+size_t FrameCopyPool::getSplitThreshold(void) const
+{
+    return m_split_threshold;
+}
+
+//-----------------------------------------------------------------------------
+/// Add a copy to do. The jobs must be pushed in frame number order.
+/// A copy to a sink is never split and its sink is told once it is done.
+//-----------------------------------------------------------------------------
+void FrameCopyPool::push(const Job & job) ///< [in] copy to do
+{
+    AutoMutex lock(m_cond.mutex());
+
+    if(job.sink != NULL)
+    {
+        ++m_nb_sink_jobs;
+
+        if(job.ring_frame >= 0)
+            ++m_ring_jobs[job.ring_frame];
+
+        m_jobs.push_back(job);
+        m_cond.broadcast();
+        return;
+    }
+
+    size_t frame_size = static_cast<size_t>(job.line_size) * job.height;
+    int    nb_parts   = 1;
+
+    // a very large frame is split in bands of lines, one per thread
+    if((m_split_threshold > 0) && (frame_size >= m_split_threshold) && (m_threads.size() > 1))
+    {
+        nb_parts = (static_cast<int>(m_threads.size()) < job.height) ? static_cast<int>(m_threads.size()) : job.height;
+    }
+
+    m_parts_left[job.frame_info.acq_frame_nb] = nb_parts;
+    ++m_nb_pending;
+
+    if(job.ring_frame >= 0)
+        m_ring_jobs[job.ring_frame] += nb_parts;
+
+    for(int part = 0 ; part < nb_parts ; part++)
+    {
+        int first_line = (job.height *  part     ) / nb_parts;
+        int last_line  = (job.height * (part + 1)) / nb_parts;
+
+        Job part_job        = job;
+        part_job.src        = (job.src != NULL) ? job.src + (first_line * job.src_rowbytes) : NULL;
+        part_job.dst        = job.dst + (first_line * ((job.dst_rowbytes > 0) ? job.dst_rowbytes : job.line_size));
+        part_job.height     = last_line - first_line;
+        part_job.frame_size = frame_size;
+
+        m_jobs.push_back(part_job);
+    }
+
+    m_cond.broadcast();
+}
+
+//-----------------------------------------------------------------------------
+/// Add the copies of the parts of one frame (same frame number, for example
+/// the regions of a multi-region frame). The parts are not split again.
+//-----------------------------------------------------------------------------
+void FrameCopyPool::push(const std::vector<Job> & parts) ///< [in] copies of the parts of one frame
+{
+    if(parts.empty())
+        return;
+
+    AutoMutex lock(m_cond.mutex());
+
+    m_parts_left[parts[0].frame_info.acq_frame_nb] = static_cast<int>(parts.size());
+    ++m_nb_pending;
+
+    for(size_t part = 0 ; part < parts.size() ; part++)
+    {
+        if(parts[part].ring_frame >= 0)
+            ++m_ring_jobs[parts[part].ring_frame];
+    }
+
+    m_jobs.insert(m_jobs.end(), parts.begin(), parts.end());
+
+    m_cond.broadcast();
+}
+
+//-----------------------------------------------------------------------------
+/// Wait until all the pushed frames are copied and given back (and all the 
+/// copies to the sinks are done)
+//-----------------------------------------------------------------------------
+void FrameCopyPool::waitIdle(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    AutoMutex lock(m_cond.mutex());
+
+    while((m_nb_pending > 0) || (m_nb_sink_jobs > 0))
+        m_cond.wait();
+}
+
+//-----------------------------------------------------------------------------
+/// Copy an image (the source lines can be padded), unpacking the 12 bits 
+/// pixels or reducing the 16 bits pixels to 8 bits if needed. A job without 
+/// source fills the destination with zeros (placeholder frame). The two 
+/// halves of the lines are copied separately if they are not contiguous in 
+/// the source (the two views of a W-View image).
+//-----------------------------------------------------------------------------
+void FrameCopyPool::copy(const Job & job) ///< [in] copy to do
+{
+    long dst_rowbytes = (job.dst_rowbytes > 0) ? job.dst_rowbytes : job.line_size;
+
+    if((job.src != NULL) && (job.src_half_offset > 0))
+    {
+        Job half = job;
+        half.src_half_offset = 0;
+        half.height          = job.height / 2;
+        copy(half);
+
+        half.src    = job.src + job.src_half_offset;
+        half.dst    = job.dst + (half.height * dst_rowbytes);
+        half.height = job.height - half.height;
+        copy(half);
+        return;
+    }
+
+    if(job.src == NULL)
+    {
+        if(dst_rowbytes == job.line_size)
+        {
+            memset(job.dst, 0, static_cast<size_t>(job.line_size) * job.height);
+        }
+        else
+        {
+            for(int line = 0 ; line < job.height ; line++)
+                memset(job.dst + (line * dst_rowbytes), 0, static_cast<size_t>(job.line_size));
+        }
+        return;
+    }
+
+    if((job.conversion == FrameCopy::Conversion_Mono12) || (job.conversion == FrameCopy::Conversion_Mono12P))
+    {
+        FrameCopy::unpack12(job.dst, dst_rowbytes, job.src, job.src_rowbytes, static_cast<int>(job.line_size / 2), job.height, job.conversion);
+        return;
+    }
+
+    if(job.conversion == FrameCopy::Conversion_Window8)
+    {
+        FrameCopy::window8(job.dst, dst_rowbytes, job.src, job.src_rowbytes, static_cast<int>(job.line_size), job.height, job.bit_shift);
+        return;
+    }
+
+    FrameCopy::copy(job.dst, dst_rowbytes, job.src, job.src_rowbytes, job.line_size, job.height, job.frame_size);
+}
+
+//-----------------------------------------------------------------------------
+/// Stop and release all the copy threads
+//-----------------------------------------------------------------------------
+void FrameCopyPool::stopThreads(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    {
+        AutoMutex lock(m_cond.mutex());
+        m_quit = true;
+        m_cond.broadcast();
+    }
+
+    for(size_t thread_index = 0 ; thread_index < m_threads.size() ; thread_index++)
+    {
+        m_threads[thread_index]->join();
+        delete m_threads[thread_index];
+    }
+
+    m_threads.clear();
+
+    AutoMutex lock(m_cond.mutex());
+    m_quit = false;
+}
+
+//-----------------------------------------------------------------------------
+/// Copy thread main loop.
+/// Each copied frame is stored until all the previous frames are copied,
+/// then one thread at a time gives the frames back in order (without the lock
+/// so the other threads keep copying).
+//-----------------------------------------------------------------------------
+void FrameCopyPool::workerLoop(void)
+{
+    AutoMutex lock(m_cond.mutex());
+
+    while(true)
+    {
+        while((!m_quit) && m_jobs.empty())
+            m_cond.wait();
+
+        if(m_quit)
+            break;
+
+        Job job = m_jobs.front();
+        m_jobs.pop_front();
+
+        std::multimap<int, int>::iterator running = m_running_ring_jobs.end();
+
+        if(job.ring_frame >= 0)
+            running = m_running_ring_jobs.insert(std::make_pair(job.ring_frame, (job.sink == NULL) ? job.frame_info.acq_frame_nb : -1));
+
+        // a copy dropped by a DCAM ring overrun is not done for a sink
+        lock.unlock();
+        if((job.sink == NULL) || (job.src != NULL))
+            copy(job);
+        lock.lock();
+
+        if(job.ring_frame >= 0)
+        {
+            m_running_ring_jobs.erase(running);
+            releaseRingJob(job.ring_frame);
+
+            // DCAM reused the slot during the copy: the copy is dropped too
+            if(job.ring_frame <= m_dropped_ring_frame)
+            {
+                job.src = NULL;
+
+                if(job.sink == NULL)
+                {
+                    lock.unlock();
+                    copy(job);
+                    lock.lock();
+                }
+            }
+        }
+
+        // out of the lima frames: no reorder stage
+        if(job.sink != NULL)
+        {
+            lock.unlock();
+            job.sink->slotCopied(job.sink_slot, (job.src != NULL));
+            lock.lock();
+
+            if((--m_nb_sink_jobs == 0) && (m_nb_pending == 0))
+                m_cond.broadcast();
+
+            continue;
+        }
+
+        // the frame is copied once all its parts are done
+        std::map<int, int>::iterator parts = m_parts_left.find(job.frame_info.acq_frame_nb);
+
+        if(--(parts->second) > 0)
+            continue;
+
+        m_parts_left.erase(parts);
+        m_callback->frameCopyEnd(job.frame_info.acq_frame_nb);
+        m_copied[job.frame_info.acq_frame_nb] = job.frame_info;
+
+        if(!m_delivering)
+        {
+            m_delivering = true;
+
+            std::map<int, HwFrameInfoType>::iterator it;
+
+            while((it = m_copied.find(m_next_frame_nb)) != m_copied.end())
+            {
+                HwFrameInfoType frame_info = it->second;
+                m_copied.erase(it);
+
+                lock.unlock();
+                m_callback->frameCopied(frame_info);
+                lock.lock();
+
+                ++m_next_frame_nb;
+                --m_nb_pending;
+            }
+
+            m_delivering = false;
+
+            if((m_nb_pending == 0) && (m_nb_sink_jobs == 0))
+                m_cond.broadcast();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// A job no longer reads its DCAM frame (pool lock held)
+//-----------------------------------------------------------------------------
+void FrameCopyPool::releaseRingJob(const int ring_frame) ///< [in] DCAM frame read by the job
+{
+    std::map<int, int>::iterator ring_jobs = m_ring_jobs.find(ring_frame);
+
+    if((ring_jobs != m_ring_jobs.end()) && (--(ring_jobs->second) <= 0))
+        m_ring_jobs.erase(ring_jobs);
+}
+
+//-----------------------------------------------------------------------------
+///  WorkerThread Ctor
+//-----------------------------------------------------------------------------
+FrameCopyPool::WorkerThread::WorkerThread(FrameCopyPool & pool)
+    : m_pool(pool)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------------------------------
+///  WorkerThread main function
+//-----------------------------------------------------------------------------
+void FrameCopyPool::WorkerThread::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    m_pool.workerLoop();
+}
@@ -0,0 +1,264 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <stdlib.h>
+#include <string.h>
+#include "HamamatsuFrameSnapshot.h"
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+//-----------------------------------------------------------------------------
+///  Ctor
+//-----------------------------------------------------------------------------
+FrameSnapshot::FrameSnapshot()
+    : m_middle    (1)  ,
+      m_back      (0)  ,
+      m_copying   (false),
+      m_front     (2)  ,
+      m_frame_size(0)  ,
+      m_width     (0)  ,
+      m_height    (0)  ,
+      m_depth     (0)  ,
+      m_seq       (0)  ,
+      m_max_rate  (0.0),
+      m_next_time (0.0)
+{
+    DEB_CONSTRUCTOR();
+
+    for(int slot_index = 0 ; slot_index < g_nb_slots ; slot_index++)
+    {
+        m_slots[slot_index].buffer = NULL;
+        memset(&m_slots[slot_index].info, 0, sizeof(Info));
+    }
+}
+
+//-----------------------------------------------------------------------------
+///  Dtor
+//-----------------------------------------------------------------------------
+FrameSnapshot::~FrameSnapshot()
+{
+    DEB_DESTRUCTOR();
+    releaseSlots();
+}
+
+//-----------------------------------------------------------------------------
+/// Set the maximum number of updates per second, so the snapshot copies 
+/// only cost the bandwidth the viewers need
+//-----------------------------------------------------------------------------
+void FrameSnapshot::setMaxRate(const double in_rate) ///< [in] maximum number of updates per second (0: every frame)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_rate);
+
+    if(in_rate < 0.0)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect snapshot rate: " << in_rate;
+    }
+
+    m_max_rate = in_rate;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the maximum number of updates per second
+//-----------------------------------------------------------------------------
+double FrameSnapshot::getMaxRate(void) const
+{
+    return m_max_rate;
+}
+
+//-----------------------------------------------------------------------------
+/// Allocate the slots for the frame size of the acquisition. The latest frame
+/// is kept if the size did not change. Called by the acquisition thread 
+/// before the capture (the only time it can wait for a reader), the copies
+/// of the previous acquisition must be done.
+//-----------------------------------------------------------------------------
+void FrameSnapshot::configure(const int in_width , ///< [in] pixels of a line
+                              const int in_height, ///< [in] lines of a frame
+                              const int in_depth ) ///< [in] bytes of a pixel
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR3(in_width, in_height, in_depth);
+
+    size_t frame_size = static_cast<size_t>(in_width) * in_height * in_depth;
+
+    m_next_time = 0.0;
+
+    AutoMutex lock(m_read_mutex);
+
+    if((frame_size == m_frame_size) && (in_width == m_width) && (in_height == m_height) && (in_depth == m_depth))
+        return;
+
+    releaseSlots();
+
+    for(int slot_index = 0 ; slot_index < g_nb_slots ; slot_index++)
+    {
+        m_slots[slot_index].buffer = static_cast<char *>(malloc(frame_size));
+
+        if(m_slots[slot_index].buffer == NULL)
+        {
+            releaseSlots();
+            THROW_HW_ERROR(Error) << "Cannot allocate the frame snapshot (" << g_nb_slots << " x " << frame_size << " bytes)";
+        }
+
+        memset(&m_slots[slot_index].info, 0, sizeof(Info));
+    }
+
+    m_back   = 0;
+    m_front  = 2;
+    m_middle.store(1);
+    m_copying.store(false);
+    m_seq    = 0;
+
+    m_frame_size = frame_size;
+    m_width      = in_width  ;
+    m_height     = in_height ;
+    m_depth      = in_depth  ;
+}
+
+//-----------------------------------------------------------------------------
+/// Give a frame to the back slot: a copy thread fills it and publishes it.
+/// Called by the acquisition thread, never waits: the frame is skipped while
+/// the previous one is being copied.
+/// @return false if the frame was skipped (rate limit or copy running)
+//-----------------------------------------------------------------------------
+bool FrameSnapshot::update(FrameCopyPool           * io_pool      , ///< [in] copy threads doing the copy (NULL: copied by the caller)
+                           const FrameCopyPool::Job & in_job       , ///< [in] copy of the frame (its destination is replaced by the back slot)
+                           const long long           in_frame_nb  , ///< [in] hardware image number
+                           const int                 in_framestamp, ///< [in] DCAM framestamp
+                           const double              in_timestamp , ///< [in] hardware timestamp in host clock (s)
+                           const double              in_now       ) ///< [in] arrival time of the frame (s)
+{
+    if(m_frame_size == 0)
+        return false;
+
+    // acquire: the back slot given back by the copy thread
+    if(m_copying.load(std::memory_order_acquire))
+        return false;
+
+    if(m_max_rate > 0.0)
+    {
+        if(in_now < m_next_time)
+            return false;
+
+        m_next_time = in_now + (1.0 / m_max_rate);
+    }
+
+    Slot & slot = m_slots[m_back];
+
+    slot.info.seq        = ++m_seq        ;
+    slot.info.frame_nb   = in_frame_nb    ;
+    slot.info.timestamp  = in_timestamp   ;
+    slot.info.framestamp = in_framestamp  ;
+    slot.info.width      = m_width        ;
+    slot.info.height     = m_height       ;
+    slot.info.depth      = m_depth        ;
+
+    FrameCopyPool::Job job = in_job;
+    job.dst          = slot.buffer;
+    job.dst_rowbytes = 0;
+    job.frame_size   = 0;
+    job.sink         = this;
+    job.sink_slot    = m_back;
+
+    m_copying.store(true, std::memory_order_relaxed);
+
+    if((io_pool != NULL) && (io_pool->getNbThreads() > 0))
+    {
+        io_pool->push(job);
+    }
+    else
+    {
+        FrameCopyPool::copy(job);
+        slotCopied(m_back, true);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/// The back slot is filled (called by a copy thread, or by the acquisition 
+/// thread without copy thread): it is published, unless the copy was dropped.
+//-----------------------------------------------------------------------------
+void FrameSnapshot::slotCopied(const int  slot_index, ///< [in] back slot filled by the copy
+                               const bool copied    ) ///< [in] false if the copy was dropped
+{
+    // release: the frame is written before the slot is shared
+    if(copied)
+        m_back = m_middle.exchange(slot_index | g_fresh_bit, std::memory_order_acq_rel) & ~g_fresh_bit;
+
+    // release: the new back slot is given back to the acquisition thread
+    m_copying.store(false, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+/// Get a copy of the latest frame. Several readers can call it, the 
+/// acquisition thread is never blocked.
+/// @return false if no frame was received since the configuration
+//-----------------------------------------------------------------------------
+bool FrameSnapshot::read(Info              & out_info, ///< [out] stamps of the latest frame
+                         std::vector<char> & out_data) ///< [out] pixels of the latest frame
+{
+    AutoMutex lock(m_read_mutex);
+
+    if(m_frame_size == 0)
+        return false;
+
+    takeLatest();
+
+    const Slot & slot = m_slots[m_front];
+
+    out_info = slot.info;
+
+    if(slot.info.seq == 0)
+        return false;
+
+    out_data.assign(slot.buffer, slot.buffer + m_frame_size);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Swap the front slot with the middle one if the middle one is newer
+/// (m_read_mutex locked)
+//-----------------------------------------------------------------------------
+void FrameSnapshot::takeLatest(void)
+{
+    if((m_middle.load(std::memory_order_acquire) & g_fresh_bit) == 0)
+        return;
+
+    // acquire: the frame written by the acquisition thread is visible
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~g_fresh_bit;
+}
+
+//-----------------------------------------------------------------------------
+/// Free the slots
+//-----------------------------------------------------------------------------
+void FrameSnapshot::releaseSlots(void)
+{
+    for(int slot_index = 0 ; slot_index < g_nb_slots ; slot_index++)
+    {
+        free(m_slots[slot_index].buffer);
+        m_slots[slot_index].buffer = NULL;
+    }
+
+    m_frame_size = 0;
+}
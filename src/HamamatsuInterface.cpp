@@ -162,3 +162,30 @@ int Interface::getNbHwAcquiredFrames()
 // release.
 /////////////////////////////////////////////////////////////
 
+//-----------------------------------------------------
+// @brief set the time covered by the rolling metrics (s)
+//-----------------------------------------------------
+void Interface::setMetricsWindow(const double window)
+{
+    DEB_MEMBER_FUNCT();
+    m_cam.setMetricsWindow(window);
+}
+
+//-----------------------------------------------------
+// @brief return the time covered by the rolling metrics (s)
+//-----------------------------------------------------
+double Interface::getMetricsWindow()
+{
+    DEB_MEMBER_FUNCT();
+    return m_cam.getMetricsWindow();
+}
+
+//-----------------------------------------------------
+// @brief return the frame rate, throughput, ring occupancy, 
+// wake-up jitter and lost frame rate over the latest window
+//-----------------------------------------------------
+void Interface::getRollingMetrics(RollingMetrics::Values& metrics)
+{
+    DEB_MEMBER_FUNCT();
+    m_cam.getRollingMetrics(metrics);
+}
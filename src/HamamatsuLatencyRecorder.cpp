@@ -0,0 +1,343 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include "HamamatsuLatencyRecorder.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+static const int g_default_nb_records = 65536; // about one minute at 1 kHz
+
+//-----------------------------------------------------------------------------
+// Percentile of sorted values (nearest rank)
+//-----------------------------------------------------------------------------
+template<typename T> static T getPercentile(const vector<T> & in_sorted, ///< [in] values sorted in increasing order
+                                            const double      in_percent) ///< [in] percentile (0-100)
+{
+    size_t rank = static_cast<size_t>((in_percent / 100.0) * (in_sorted.size() - 1) + 0.5);
+    return in_sorted[rank];
+}
+
+//-----------------------------------------------------------------------------
+// Frame number order of the records
+//-----------------------------------------------------------------------------
+static bool isBefore(const LatencyRecorder::Record * in_first , ///< [in] first record
+                     const LatencyRecorder::Record * in_second) ///< [in] second record
+{
+    return in_first->frame_nb < in_second->frame_nb;
+}
+
+//-----------------------------------------------------------------------------
+///  Ctor
+//-----------------------------------------------------------------------------
+LatencyRecorder::LatencyRecorder()
+    : m_enabled   (false),
+      m_mask      (0)    ,
+      m_start_time(0.0)
+{
+    DEB_CONSTRUCTOR();
+    setNbRecords(g_default_nb_records);
+}
+
+//-----------------------------------------------------------------------------
+/// Enable or disable the recording.
+/// Should only be called when no acquisition is running.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::setEnabled(const bool in_enabled) ///< [in] true to record the frames of the next acquisitions
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    m_enabled.store(in_enabled, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+/// Change the number of records (the latest frames of an acquisition are kept).
+/// Should only be called when no acquisition is running.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::setNbRecords(const int in_nb_records) ///< [in] number of records (rounded up to a power of two)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_nb_records);
+
+    if(in_nb_records < 1)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect number of latency records: " << in_nb_records;
+    }
+
+    // a power of two so the record of a frame is found with a mask
+    int nb_records = 1;
+
+    while(nb_records < in_nb_records)
+        nb_records <<= 1;
+
+    Record unused;
+    memset(&unused, 0, sizeof(unused));
+    unused.frame_nb = -1;
+
+    m_records.assign(nb_records, unused);
+    m_mask = nb_records - 1;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of records
+//-----------------------------------------------------------------------------
+int LatencyRecorder::getNbRecords(void) const
+{
+    return static_cast<int>(m_records.size());
+}
+
+//-----------------------------------------------------------------------------
+/// Clear the records of the previous acquisition.
+/// Called by the acquisition thread before the capture start.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::start(void)
+{
+    if(!isEnabled())
+        return;
+
+    for(size_t record_index = 0 ; record_index < m_records.size() ; record_index++)
+        m_records[record_index].frame_nb = -1;
+
+    m_start_time = now();
+}
+
+//-----------------------------------------------------------------------------
+/// Fill the first stages of a frame record.
+/// Called by the acquisition thread before the frame is given to the copy threads.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::begin(const int    frame_nb   , ///< [in] lima frame number
+                            const int    queue_depth, ///< [in] DCAM frames waiting in the ring
+                            const double wait_time  , ///< [in] time of Stage_WaitReturn
+                            const double info_time  , ///< [in] time of Stage_TransferInfo
+                            const double lock_time  ) ///< [in] time of Stage_Lock
+{
+    Record & record = m_records[frame_nb & m_mask];
+
+    record.frame_nb                    = frame_nb   ;
+    record.queue_depth                 = queue_depth;
+    record.times[Stage_WaitReturn  ]   = wait_time  ;
+    record.times[Stage_TransferInfo]   = info_time  ;
+    record.times[Stage_Lock        ]   = lock_time  ;
+    record.times[Stage_CopyEnd     ]   = 0.0        ;
+    record.times[Stage_Delivered   ]   = 0.0        ;
+}
+
+//-----------------------------------------------------------------------------
+/// Fill a later stage of a frame record.
+/// The frames without record (placeholder frames, or overwritten by a newer 
+/// frame) are ignored.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::mark(const int    frame_nb, ///< [in] lima frame number
+                           const Stage  stage   , ///< [in] stage reached
+                           const double time    ) ///< [in] time of the stage
+{
+    Record & record = m_records[frame_nb & m_mask];
+
+    if(record.frame_nb == frame_nb)
+        record.times[stage] = time;
+}
+
+//-----------------------------------------------------------------------------
+/// Compute the latency between two stages over the recorded frames.
+/// Only the frames which reached both stages are used.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::getLatencyStatistics(const Stage in_from, ///< [in]  first stage
+                                           const Stage in_to  , ///< [in]  last stage
+                                           int &       out_nb , ///< [out] number of frames used
+                                           double &    out_p50, ///< [out] median latency (s)
+                                           double &    out_p99, ///< [out] 99th percentile latency (s)
+                                           double &    out_max) ///< [out] maximum latency (s)
+{
+    DEB_MEMBER_FUNCT();
+
+    vector<double> latencies;
+    latencies.reserve(m_records.size());
+
+    for(size_t record_index = 0 ; record_index < m_records.size() ; record_index++)
+    {
+        const Record & record = m_records[record_index];
+
+        if((record.frame_nb >= 0) && (record.times[in_from] != 0.0) && (record.times[in_to] != 0.0))
+            latencies.push_back(record.times[in_to] - record.times[in_from]);
+    }
+
+    out_nb  = static_cast<int>(latencies.size());
+    out_p50 = 0.0;
+    out_p99 = 0.0;
+    out_max = 0.0;
+
+    if(latencies.empty())
+        return;
+
+    sort(latencies.begin(), latencies.end());
+
+    out_p50 = getPercentile(latencies, 50.0);
+    out_p99 = getPercentile(latencies, 99.0);
+    out_max = latencies.back();
+
+    DEB_RETURN() << DEB_VAR4(out_nb, out_p50, out_p99, out_max);
+}
+
+//-----------------------------------------------------------------------------
+/// Compute the number of DCAM frames waiting in the ring when the frames 
+/// were found by the acquisition thread.
+//-----------------------------------------------------------------------------
+void LatencyRecorder::getQueueDepthStatistics(int & out_p50, ///< [out] median queue depth
+                                              int & out_p99, ///< [out] 99th percentile queue depth
+                                              int & out_max) ///< [out] maximum queue depth
+{
+    DEB_MEMBER_FUNCT();
+
+    vector<int> depths;
+    depths.reserve(m_records.size());
+
+    for(size_t record_index = 0 ; record_index < m_records.size() ; record_index++)
+    {
+        if(m_records[record_index].frame_nb >= 0)
+            depths.push_back(m_records[record_index].queue_depth);
+    }
+
+    out_p50 = 0;
+    out_p99 = 0;
+    out_max = 0;
+
+    if(depths.empty())
+        return;
+
+    sort(depths.begin(), depths.end());
+
+    out_p50 = getPercentile(depths, 50.0);
+    out_p99 = getPercentile(depths, 99.0);
+    out_max = depths.back();
+
+    DEB_RETURN() << DEB_VAR3(out_p50, out_p99, out_max);
+}
+
+//-----------------------------------------------------------------------------
+/// Write the records in a CSV file, in frame number order.
+/// The times are in microseconds from the acquisition start (empty: stage not reached).
+//-----------------------------------------------------------------------------
+void LatencyRecorder::dump(const std::string & in_file_name) ///< [in] path of the CSV file to write
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_file_name);
+
+    vector<const Record *> records;
+
+    for(size_t record_index = 0 ; record_index < m_records.size() ; record_index++)
+    {
+        if(m_records[record_index].frame_nb >= 0)
+            records.push_back(&m_records[record_index]);
+    }
+
+    // the ring can have wrapped around
+    sort(records.begin(), records.end(), isBefore);
+
+    ofstream file(in_file_name.c_str());
+
+    if(!file)
+    {
+        THROW_HW_ERROR(Error) << "Cannot open the latency file: " << in_file_name;
+    }
+
+    file << "frame_nb;queue_depth";
+
+    for(int stage = 0 ; stage < Stage_Nb ; stage++)
+        file << ";" << getStageName(static_cast<Stage>(stage)) << "_us";
+
+    file << "\n" << fixed << setprecision(1);
+
+    for(size_t record_index = 0 ; record_index < records.size() ; record_index++)
+    {
+        const Record & record = *records[record_index];
+
+        file << record.frame_nb << ";" << record.queue_depth;
+
+        for(int stage = 0 ; stage < Stage_Nb ; stage++)
+        {
+            file << ";";
+
+            if(record.times[stage] != 0.0)
+                file << (record.times[stage] - m_start_time) * 1.0e6;
+        }
+
+        file << "\n";
+    }
+
+    if(!file)
+    {
+        THROW_HW_ERROR(Error) << "Cannot write the latency file: " << in_file_name;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Monotonic time with a sub-microsecond resolution (s)
+//-----------------------------------------------------------------------------
+double LatencyRecorder::now(void)
+{
+#if defined(_WIN32)
+    static double period = 0.0;
+
+    LARGE_INTEGER counter;
+
+    if(period == 0.0)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        period = 1.0 / static_cast<double>(frequency.QuadPart);
+    }
+
+    QueryPerformanceCounter(&counter);
+    return static_cast<double>(counter.QuadPart) * period;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1.0e-9;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Get the label of a stage
+//-----------------------------------------------------------------------------
+std::string LatencyRecorder::getStageName(const Stage in_stage) ///< [in] stage
+{
+    switch(in_stage)
+    {
+        case Stage_WaitReturn  : return "wait_return"  ;
+        case Stage_TransferInfo: return "transfer_info";
+        case Stage_Lock        : return "lock"         ;
+        case Stage_CopyEnd     : return "copy_end"     ;
+        case Stage_Delivered   : return "delivered"    ;
+        default                : return "unknown"      ;
+    }
+}
@@ -0,0 +1,689 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "lima/Timestamp.h"
+#include "HamamatsuRawWriter.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <malloc.h>
+#else
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+static const size_t    g_alignment         = 4096; // direct I/O alignment of the buffers, sizes and offsets
+static const long long g_default_file_size = 4LL * 1024 * 1024 * 1024; // 4 GB data files
+static const int       g_default_nb_slots  = 64  ;
+static const intptr_t  g_no_file           = -1  ;
+
+//-----------------------------------------------------------------------------
+// File access (Windows handles or posix descriptors)
+//-----------------------------------------------------------------------------
+static intptr_t file_create(const std::string & path, bool direct)
+{
+#if defined(_WIN32)
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+
+    if(direct)
+        flags |= FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH;
+
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, flags, NULL);
+
+    return (handle == INVALID_HANDLE_VALUE) ? g_no_file : reinterpret_cast<intptr_t>(handle);
+#else
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+#if defined(O_DIRECT)
+    if(direct)
+        flags |= O_DIRECT;
+#endif
+
+    int fd = ::open(path.c_str(), flags, 0644);
+
+    // some file systems (tmpfs...) refuse O_DIRECT
+    if((fd < 0) && direct && (errno == EINVAL))
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    return (fd < 0) ? g_no_file : static_cast<intptr_t>(fd);
+#endif
+}
+
+static bool file_write(intptr_t file, const void * buffer, size_t size, long long offset)
+{
+#if defined(_WIN32)
+    OVERLAPPED position;
+    memset(&position, 0, sizeof(position));
+    position.Offset     = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD written = 0;
+
+    return WriteFile(reinterpret_cast<HANDLE>(file), buffer, static_cast<DWORD>(size), &written, &position) && (written == size);
+#else
+    const char * data = static_cast<const char *>(buffer);
+
+    while(size > 0)
+    {
+        ssize_t written = ::pwrite(static_cast<int>(file), data, size, static_cast<off_t>(offset));
+
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        data   += written;
+        size   -= written;
+        offset += written;
+    }
+
+    return true;
+#endif
+}
+
+static void file_set_size(intptr_t file, long long size, bool preallocate)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER position;
+    position.QuadPart = size;
+
+    if(SetFilePointerEx(reinterpret_cast<HANDLE>(file), position, NULL, FILE_BEGIN))
+        SetEndOfFile(reinterpret_cast<HANDLE>(file));
+#else
+    if(preallocate)
+        posix_fallocate(static_cast<int>(file), 0, static_cast<off_t>(size));
+    else
+        ftruncate(static_cast<int>(file), static_cast<off_t>(size));
+#endif
+}
+
+static void file_close(intptr_t file)
+{
+#if defined(_WIN32)
+    CloseHandle(reinterpret_cast<HANDLE>(file));
+#else
+    ::close(static_cast<int>(file));
+#endif
+}
+
+static std::string last_error_text(void)
+{
+#if defined(_WIN32)
+    char text[32];
+    sprintf(text, "error %lu", GetLastError());
+    return text;
+#else
+    return strerror(errno);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+///  Ctor
+//-----------------------------------------------------------------------------
+RawWriter::RawWriter()
+    : m_thread    (NULL) ,
+      m_open      (false),
+      m_quit      (false),
+      m_writing   (false),
+      m_file_size (g_default_file_size),
+      m_nb_slots  (g_default_nb_slots ),
+      m_direct_io (true) ,
+      m_slot_size (0)    ,
+      m_data_file (g_no_file),
+      m_index_file(g_no_file),
+      m_file_index(0)    ,
+      m_file_offset(0)   ,
+      m_nb_records(0)    ,
+      m_open_time (0.0)
+{
+    DEB_CONSTRUCTOR();
+
+    memset(&m_header, 0, sizeof(m_header));
+
+    m_status.open       = false;
+    m_status.nb_written = 0    ;
+    m_status.nb_dropped = 0    ;
+    m_status.nb_files   = 0    ;
+    m_status.queue_max  = 0    ;
+    m_status.throughput = 0.0  ;
+}
+
+//-----------------------------------------------------------------------------
+///  Dtor
+//-----------------------------------------------------------------------------
+RawWriter::~RawWriter()
+{
+    DEB_DESTRUCTOR();
+
+    close();
+
+    for(size_t slot_index = 0 ; slot_index < m_slots.size() ; slot_index++)
+        freeAligned(m_slots[slot_index].buffer);
+}
+
+//-----------------------------------------------------------------------------
+/// Set the size of a data file (used by the next stream)
+//-----------------------------------------------------------------------------
+void RawWriter::setFileSize(const long long in_size) ///< [in] size of a data file (bytes, rounded to the frame stride)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_size);
+
+    if(in_size <= 0)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect raw data file size: " << in_size;
+    }
+
+    m_file_size = in_size;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the size of a data file
+//-----------------------------------------------------------------------------
+long long RawWriter::getFileSize(void) const
+{
+    return m_file_size;
+}
+
+//-----------------------------------------------------------------------------
+/// Set the number of frames the writer can hold (used by the next stream)
+//-----------------------------------------------------------------------------
+void RawWriter::setNbSlots(const int in_nb_slots) ///< [in] number of frames the writer can hold
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_nb_slots);
+
+    if(in_nb_slots < 1)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect number of raw writer slots: " << in_nb_slots;
+    }
+
+    m_nb_slots = in_nb_slots;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the number of frames the writer can hold
+//-----------------------------------------------------------------------------
+int RawWriter::getNbSlots(void) const
+{
+    return m_nb_slots;
+}
+
+//-----------------------------------------------------------------------------
+/// Bypass the system cache for the data files (used by the next stream).
+/// The writer goes back to buffered writes if the file system refuses it.
+//-----------------------------------------------------------------------------
+void RawWriter::setDirectIoEnabled(const bool in_enabled) ///< [in] true to bypass the system cache
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_enabled);
+
+    m_direct_io = in_enabled;
+}
+
+//-----------------------------------------------------------------------------
+/// Check if the system cache is bypassed for the data files
+//-----------------------------------------------------------------------------
+bool RawWriter::getDirectIoEnabled(void) const
+{
+    return m_direct_io;
+}
+
+//-----------------------------------------------------------------------------
+/// Create the files of a new stream and start the writer thread.
+/// A stream still open is closed first.
+//-----------------------------------------------------------------------------
+void RawWriter::open(const std::string & in_base_name, ///< [in] path of the stream files, without extension
+                     const int           in_width    , ///< [in] pixels of a line
+                     const int           in_height   , ///< [in] lines of a frame
+                     const int           in_depth    ) ///< [in] bytes of a pixel
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR4(in_base_name, in_width, in_height, in_depth);
+
+    close();
+
+    long long frame_size   = static_cast<long long>(in_width) * in_height * in_depth;
+    long long frame_stride = ((frame_size + g_alignment - 1) / g_alignment) * g_alignment;
+    long long per_file     = m_file_size / frame_stride;
+
+    if(per_file < 1)
+        per_file = 1;
+
+    memset(&m_header, 0, sizeof(m_header));
+    strcpy(m_header.magic, "HAMRAW1");
+    m_header.header_size     = sizeof(IndexHeader);
+    m_header.record_size     = sizeof(IndexRecord);
+    m_header.width           = in_width ;
+    m_header.height          = in_height;
+    m_header.depth           = in_depth ;
+    m_header.frames_per_file = static_cast<int>(per_file);
+    m_header.frame_size      = frame_size  ;
+    m_header.frame_stride    = frame_stride;
+    m_header.file_size       = per_file * frame_stride;
+
+    // the slots are kept between the streams of the same frame size
+    if((m_slot_size != static_cast<size_t>(frame_stride)) || (static_cast<int>(m_slots.size()) != m_nb_slots))
+    {
+        for(size_t slot_index = 0 ; slot_index < m_slots.size() ; slot_index++)
+            freeAligned(m_slots[slot_index].buffer);
+
+        m_slots.clear();
+        m_slot_size = 0;
+
+        for(int slot_index = 0 ; slot_index < m_nb_slots ; slot_index++)
+        {
+            Slot slot;
+            slot.buffer = static_cast<char *>(allocAligned(static_cast<size_t>(frame_stride)));
+            slot.state  = Slot_Dropped;
+
+            if(slot.buffer == NULL)
+            {
+                for(size_t freed_index = 0 ; freed_index < m_slots.size() ; freed_index++)
+                    freeAligned(m_slots[freed_index].buffer);
+
+                m_slots.clear();
+                THROW_HW_ERROR(Error) << "Cannot allocate the raw writer slots (" << m_nb_slots << " x " << frame_stride << " bytes)";
+            }
+
+            // the padding after the frame is written as zeros
+            memset(slot.buffer, 0, static_cast<size_t>(frame_stride));
+            m_slots.push_back(slot);
+        }
+
+        m_slot_size = static_cast<size_t>(frame_stride);
+    }
+
+    m_index_file = file_create(in_base_name + ".idx", false);
+
+    if(m_index_file == g_no_file)
+    {
+        THROW_HW_ERROR(Error) << "Cannot create the raw index file " << in_base_name << ".idx: " << last_error_text();
+    }
+
+    if(!file_write(m_index_file, &m_header, sizeof(m_header), 0))
+    {
+        std::string error = last_error_text();
+        closeFiles();
+        THROW_HW_ERROR(Error) << "Cannot write the raw index file " << in_base_name << ".idx: " << error;
+    }
+
+    m_status.open       = true;
+    m_status.base_name  = in_base_name;
+    m_status.nb_written = 0   ;
+    m_status.nb_dropped = 0   ;
+    m_status.nb_files   = 0   ;
+    m_status.queue_max  = 0   ;
+    m_status.throughput = 0.0 ;
+    m_status.error.clear();
+
+    m_nb_records = 0;
+
+    if(!openDataFile(0))
+    {
+        std::string error = m_status.error;
+        closeFiles();
+        m_status.open = false;
+        THROW_HW_ERROR(Error) << error;
+    }
+
+    m_free.clear   ();
+    m_copying.clear();
+    m_filled.clear ();
+
+    for(int slot_index = 0 ; slot_index < static_cast<int>(m_slots.size()) ; slot_index++)
+        m_free.push_back(slot_index);
+
+    m_quit      = false;
+    m_open      = true ;
+    m_open_time = Timestamp::now();
+
+    m_thread = new WriterThread(*this);
+    m_thread->start();
+
+    DEB_ALWAYS() << "Raw stream " << in_base_name << ": " << frame_size << " bytes frames, " << per_file << " frames per file, "
+                 << m_slots.size() << " slots";
+}
+
+//-----------------------------------------------------------------------------
+/// Write the frames still held, stop the writer thread and close the files.
+/// The copies to the slots must be done (FrameCopyPool::waitIdle).
+//-----------------------------------------------------------------------------
+void RawWriter::close(void)
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_thread == NULL)
+        return;
+
+    {
+        AutoMutex lock(m_cond.mutex());
+        m_open = false;
+        m_quit = true ;
+        m_cond.broadcast();
+    }
+
+    m_thread->join();
+    delete m_thread;
+    m_thread = NULL;
+
+    closeFiles();
+
+    AutoMutex lock(m_cond.mutex());
+    m_status.open = false;
+
+    DEB_ALWAYS() << "Raw stream " << m_status.base_name << " closed: " << m_status.nb_written << " frames written, "
+                 << m_status.nb_dropped << " dropped, " << m_status.nb_files << " files, " << m_status.throughput << " MB/s";
+}
+
+//-----------------------------------------------------------------------------
+/// Give a frame to a free slot for the writer thread: the copy threads fill 
+/// the slot, which is written once it and the previous ones are copied.
+/// Called by the acquisition thread, in frame order. Never waits: the frame
+/// is dropped if all the slots are being copied or waiting to be written.
+/// @return false if the frame was dropped
+//-----------------------------------------------------------------------------
+bool RawWriter::push(FrameCopyPool           * io_pool      , ///< [in] copy threads doing the copy (NULL: copied by the caller)
+                     const FrameCopyPool::Job & in_job       , ///< [in] copy of the frame (its destination is replaced by a slot)
+                     const long long           in_frame_nb  , ///< [in] hardware image number
+                     const int                 in_framestamp, ///< [in] DCAM framestamp
+                     const double              in_timestamp ) ///< [in] hardware timestamp in host clock (s)
+{
+    int slot_index;
+
+    {
+        AutoMutex lock(m_cond.mutex());
+
+        if(!m_open)
+            return false;
+
+        if(m_free.empty())
+        {
+            ++m_status.nb_dropped;
+            return false;
+        }
+
+        slot_index = m_free.front();
+        m_free.pop_front();
+
+        m_slots[slot_index].state = Slot_Copying;
+        m_copying.push_back(slot_index);
+    }
+
+    Slot & slot = m_slots[slot_index];
+
+    slot.record.frame_nb   = in_frame_nb  ;
+    slot.record.timestamp  = in_timestamp ;
+    slot.record.framestamp = in_framestamp;
+    slot.record.offset     = 0;
+    slot.record.file_index = 0;
+
+    FrameCopyPool::Job job = in_job;
+    job.dst          = slot.buffer;
+    job.dst_rowbytes = 0;
+    job.frame_size   = 0;
+    job.sink         = this;
+    job.sink_slot    = slot_index;
+
+    if((io_pool != NULL) && (io_pool->getNbThreads() > 0))
+    {
+        io_pool->push(job);
+    }
+    else
+    {
+        FrameCopyPool::copy(job);
+        slotCopied(slot_index, true);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/// A copy to a slot is done (called by a copy thread, any order): the copied 
+/// slots are given to the writer thread in frame order.
+//-----------------------------------------------------------------------------
+void RawWriter::slotCopied(const int  slot_index, ///< [in] slot filled by the copy
+                           const bool copied    ) ///< [in] false if the copy was dropped
+{
+    AutoMutex lock(m_cond.mutex());
+
+    m_slots[slot_index].state = (copied) ? Slot_Copied : Slot_Dropped;
+
+    while((!m_copying.empty()) && (m_slots[m_copying.front()].state != Slot_Copying))
+    {
+        int ready_index = m_copying.front();
+        m_copying.pop_front();
+
+        if(m_slots[ready_index].state == Slot_Dropped)
+        {
+            ++m_status.nb_dropped;
+            m_free.push_back(ready_index);
+            continue;
+        }
+
+        m_filled.push_back(ready_index);
+
+        int queued = static_cast<int>(m_filled.size()) + (m_writing ? 1 : 0);
+
+        if(queued > m_status.queue_max)
+            m_status.queue_max = queued;
+    }
+
+    m_cond.broadcast();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the state of the current (or latest) stream
+//-----------------------------------------------------------------------------
+void RawWriter::getStatus(Status & out_status) ///< [out] state of the current (or latest) stream
+{
+    AutoMutex lock(m_cond.mutex());
+    out_status = m_status;
+}
+
+//-----------------------------------------------------------------------------
+/// Writer thread main loop: writes the filled slots in order, then gives
+/// them back. The slots still filled are written before quitting.
+//-----------------------------------------------------------------------------
+void RawWriter::writerLoop(void)
+{
+    AutoMutex lock(m_cond.mutex());
+
+    while(true)
+    {
+        while((!m_quit) && m_filled.empty())
+            m_cond.wait();
+
+        if(m_filled.empty())
+            break;
+
+        int slot_index = m_filled.front();
+        m_filled.pop_front();
+        m_writing = true;
+
+        lock.unlock();
+        bool written = writeSlot(m_slots[slot_index]);
+        lock.lock();
+
+        m_writing = false;
+        m_free.push_back(slot_index);
+
+        if(written)
+            ++m_status.nb_written;
+        else
+            ++m_status.nb_dropped;
+
+        double elapsed = static_cast<double>(Timestamp::now()) - m_open_time;
+
+        if(elapsed > 0.0)
+            m_status.throughput = (m_status.nb_written * static_cast<double>(m_header.frame_stride)) / (elapsed * 1024.0 * 1024.0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Append a slot to the current data file (next file if it is full) and 
+/// add its record to the index. The record is written after the frame, so
+/// a reader never finds a record of a frame not written yet.
+/// Called by the writer thread only.
+//-----------------------------------------------------------------------------
+bool RawWriter::writeSlot(Slot & slot) ///< [in] frame to write
+{
+    if(m_file_offset + m_header.frame_stride > m_header.file_size)
+    {
+        if(!openDataFile(m_file_index + 1))
+            return false;
+    }
+
+    if(m_data_file == g_no_file)
+        return false;
+
+    if(!file_write(m_data_file, slot.buffer, static_cast<size_t>(m_header.frame_stride), m_file_offset))
+    {
+        AutoMutex lock(m_cond.mutex());
+        m_status.error = "Cannot write the raw data file: " + last_error_text();
+        return false;
+    }
+
+    slot.record.offset     = m_file_offset;
+    slot.record.file_index = m_file_index ;
+    m_file_offset         += m_header.frame_stride;
+
+    long long record_offset = sizeof(IndexHeader) + m_nb_records * static_cast<long long>(sizeof(IndexRecord));
+
+    if(!file_write(m_index_file, &slot.record, sizeof(IndexRecord), record_offset))
+    {
+        AutoMutex lock(m_cond.mutex());
+        m_status.error = "Cannot write the raw index file: " + last_error_text();
+        return false;
+    }
+
+    ++m_nb_records;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Close the current data file (cut to its used size) and create the next 
+/// one, preallocated.
+/// @return false if the file cannot be created (m_status.error is set)
+//-----------------------------------------------------------------------------
+bool RawWriter::openDataFile(const int in_file_index) ///< [in] number of the data file
+{
+    if(m_data_file != g_no_file)
+    {
+        file_set_size(m_data_file, m_file_offset, false);
+        file_close(m_data_file);
+        m_data_file = g_no_file;
+    }
+
+    char suffix[16];
+    sprintf(suffix, "_%04d.raw", in_file_index);
+
+    std::string file_name = m_status.base_name + suffix;
+
+    m_data_file   = file_create(file_name, m_direct_io);
+    m_file_index  = in_file_index;
+    m_file_offset = 0;
+
+    AutoMutex lock(m_cond.mutex());
+
+    if(m_data_file == g_no_file)
+    {
+        m_status.error = "Cannot create the raw data file " + file_name + ": " + last_error_text();
+        return false;
+    }
+
+    file_set_size(m_data_file, m_header.file_size, true);
+    ++m_status.nb_files;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Close the data and index files
+//-----------------------------------------------------------------------------
+void RawWriter::closeFiles(void)
+{
+    if(m_data_file != g_no_file)
+    {
+        file_set_size(m_data_file, m_file_offset, false);
+        file_close(m_data_file);
+        m_data_file = g_no_file;
+    }
+
+    if(m_index_file != g_no_file)
+    {
+        file_close(m_index_file);
+        m_index_file = g_no_file;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Allocate a memory aligned for the direct I/O
+//-----------------------------------------------------------------------------
+void * RawWriter::allocAligned(size_t in_size) ///< [in] bytes to allocate
+{
+#if defined(_WIN32)
+    return _aligned_malloc(in_size, g_alignment);
+#else
+    void * buffer = NULL;
+    return (posix_memalign(&buffer, g_alignment, in_size) == 0) ? buffer : NULL;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Free a memory of allocAligned
+//-----------------------------------------------------------------------------
+void RawWriter::freeAligned(void * in_buffer) ///< [in] memory of allocAligned
+{
+#if defined(_WIN32)
+    _aligned_free(in_buffer);
+#else
+    free(in_buffer);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+///  WriterThread Ctor
+//-----------------------------------------------------------------------------
+RawWriter::WriterThread::WriterThread(RawWriter & writer)
+    : m_writer(writer)
+{
+    DEB_CONSTRUCTOR();
+}
+
+//-----------------------------------------------------------------------------
+///  WriterThread main function
+//-----------------------------------------------------------------------------
+void RawWriter::WriterThread::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    m_writer.writerLoop();
+}
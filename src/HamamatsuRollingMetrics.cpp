@@ -0,0 +1,260 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <math.h>
+#include <string.h>
+#include "HamamatsuRollingMetrics.h"
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+static const double g_bucket_duration = 0.1 ; // time slice of a bucket (s)
+static const double g_max_window      = 60.0; // maximum time covered by the metrics (s)
+static const double g_default_window  = 5.0 ; // default time covered by the metrics (s)
+
+//-----------------------------------------------------------------------------
+///  Ctor
+//-----------------------------------------------------------------------------
+RollingMetrics::RollingMetrics()
+    : m_buckets    (static_cast<size_t>(g_max_window / g_bucket_duration) + 2), // one more bucket than the maximum window so the bucket being filled is never the oldest one read
+      m_window     (g_default_window),
+      m_running    (false),
+      m_start_time (0.0)  ,
+      m_stop_time  (0.0)  ,
+      m_last_wakeup(0.0)
+{
+    DEB_CONSTRUCTOR();
+
+    for(size_t bucket_index = 0 ; bucket_index < m_buckets.size() ; bucket_index++)
+    {
+        memset(&m_buckets[bucket_index].data, 0, sizeof(BucketData));
+        m_buckets[bucket_index].data.id = -1;
+        m_buckets[bucket_index].seq.store(0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/// Set the time covered by the metrics
+//-----------------------------------------------------------------------------
+void RollingMetrics::setWindow(const double in_window) ///< [in] time covered by the metrics (s)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_window);
+
+    if((in_window < g_bucket_duration) || (in_window > g_max_window))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect metrics window: " << in_window << " s (" 
+                              << g_bucket_duration << " to " << g_max_window << " s)";
+    }
+
+    m_window = in_window;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the time covered by the metrics
+//-----------------------------------------------------------------------------
+double RollingMetrics::getWindow(void) const
+{
+    return m_window;
+}
+
+//-----------------------------------------------------------------------------
+/// Clear the metrics of the previous acquisition.
+/// Called by the acquisition thread before the capture start.
+//-----------------------------------------------------------------------------
+void RollingMetrics::start(const double time) ///< [in] time of the acquisition start (s)
+{
+    for(size_t bucket_index = 0 ; bucket_index < m_buckets.size() ; bucket_index++)
+    {
+        beginWrite(m_buckets[bucket_index]);
+        m_buckets[bucket_index].data.id = -1;
+        endWrite  (m_buckets[bucket_index]);
+    }
+
+    m_last_wakeup = 0.0 ;
+    m_start_time.store(time, std::memory_order_release);
+    m_running.store   (true, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+/// Freeze the window at the acquisition end
+//-----------------------------------------------------------------------------
+void RollingMetrics::stop(const double time) ///< [in] time of the acquisition end (s)
+{
+    m_stop_time.store(time , std::memory_order_release);
+    m_running.store  (false, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+/// The writer starts to change a bucket (its sequence becomes odd)
+//-----------------------------------------------------------------------------
+void RollingMetrics::beginWrite(Bucket & bucket) ///< [in] bucket changed by the writer
+{
+    bucket.seq.store(bucket.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+/// The writer has changed a bucket (its sequence becomes even)
+//-----------------------------------------------------------------------------
+void RollingMetrics::endWrite(Bucket & bucket) ///< [in] bucket changed by the writer
+{
+    bucket.seq.store(bucket.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+/// Accumulate a wake-up of the acquisition thread.
+/// Only called by the acquisition thread.
+//-----------------------------------------------------------------------------
+void RollingMetrics::update(const double time     , ///< [in] time of the wake-up (s)
+                            const int    nb_frames, ///< [in] frames given to lima (or to the copy threads)
+                            const double nb_bytes , ///< [in] bytes of these frames
+                            const int    nb_lost  , ///< [in] frames lost since the previous wake-up
+                            const int    occupancy) ///< [in] DCAM frames waiting to be copied
+{
+    long long    id     = static_cast<long long>(time / g_bucket_duration);
+    Bucket &     slot   = m_buckets[static_cast<size_t>(id % static_cast<long long>(m_buckets.size()))];
+    BucketData & bucket = slot.data;
+
+    // the readers skip the bucket while it is changed
+    beginWrite(slot);
+
+    // a new time slice reuses the oldest bucket
+    if(bucket.id != id)
+    {
+        bucket.nb_frames           = 0  ;
+        bucket.nb_bytes            = 0.0;
+        bucket.nb_lost             = 0  ;
+        bucket.nb_wakeups          = 0  ;
+        bucket.occupancy_sum       = 0.0;
+        bucket.occupancy_max       = 0  ;
+        bucket.nb_intervals        = 0  ;
+        bucket.interval_sum        = 0.0;
+        bucket.interval_square_sum = 0.0;
+        bucket.id                  = id ;
+    }
+
+    bucket.nb_frames     += nb_frames;
+    bucket.nb_bytes      += nb_bytes ;
+    bucket.nb_lost       += nb_lost  ;
+    bucket.nb_wakeups    ++;
+    bucket.occupancy_sum += occupancy;
+
+    if(occupancy > bucket.occupancy_max)
+        bucket.occupancy_max = occupancy;
+
+    if(m_last_wakeup != 0.0)
+    {
+        double interval = time - m_last_wakeup;
+
+        bucket.nb_intervals        ++;
+        bucket.interval_sum        += interval;
+        bucket.interval_square_sum += interval * interval;
+    }
+
+    endWrite(slot);
+
+    m_last_wakeup = time;
+}
+
+//-----------------------------------------------------------------------------
+/// Compute the metrics of the window ending now, or at the end of the latest 
+/// acquisition. A stall of the acquisition lowers the rates as time goes on.
+//-----------------------------------------------------------------------------
+void RollingMetrics::get(const double in_now    , ///< [in]  current time (s)
+                         Values &     out_values) ///< [out] metrics of the window ending now (or at the acquisition end)
+{
+    DEB_MEMBER_FUNCT();
+
+    memset(&out_values, 0, sizeof(out_values));
+
+    double start_time = m_start_time.load(std::memory_order_acquire);
+    double end_time   = m_running.load(std::memory_order_acquire) ? in_now : m_stop_time.load(std::memory_order_acquire);
+
+    if((start_time == 0.0) || (end_time <= start_time))
+        return;
+
+    double first_time = ((end_time - m_window) > start_time) ? (end_time - m_window) : start_time;
+    double duration   = end_time - first_time;
+
+    long long first_id = static_cast<long long>(first_time / g_bucket_duration);
+    long long last_id  = static_cast<long long>(end_time   / g_bucket_duration);
+
+    int    nb_frames           = 0  ;
+    double nb_bytes            = 0.0;
+    int    nb_lost             = 0  ;
+    int    nb_wakeups          = 0  ;
+    double occupancy_sum       = 0.0;
+    int    occupancy_max       = 0  ;
+    int    nb_intervals        = 0  ;
+    double interval_sum        = 0.0;
+    double interval_square_sum = 0.0;
+
+    for(long long id = first_id ; id <= last_id ; id++)
+    {
+        const Bucket & slot = m_buckets[static_cast<size_t>(id % static_cast<long long>(m_buckets.size()))];
+        long long      seq  = slot.seq.load(std::memory_order_acquire);
+
+        // being changed by the acquisition thread
+        if(seq & 1)
+            continue;
+
+        BucketData copy = slot.data;
+
+        // changed by the acquisition thread during the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if((slot.seq.load(std::memory_order_relaxed) != seq) || (copy.id != id))
+            continue;
+
+        nb_frames           += copy.nb_frames          ;
+        nb_bytes            += copy.nb_bytes           ;
+        nb_lost             += copy.nb_lost            ;
+        nb_wakeups          += copy.nb_wakeups         ;
+        occupancy_sum       += copy.occupancy_sum      ;
+        nb_intervals        += copy.nb_intervals       ;
+        interval_sum        += copy.interval_sum       ;
+        interval_square_sum += copy.interval_square_sum;
+
+        if(copy.occupancy_max > occupancy_max)
+            occupancy_max = copy.occupancy_max;
+    }
+
+    out_values.window             = duration;
+    out_values.frame_rate         = nb_frames / duration;
+    out_values.throughput         = nb_bytes  / duration / (1024.0 * 1024.0);
+    out_values.lost_frame_rate    = nb_lost   / duration;
+    out_values.ring_occupancy_max = occupancy_max;
+
+    if(nb_wakeups > 0)
+        out_values.ring_occupancy = occupancy_sum / nb_wakeups;
+
+    if(nb_intervals > 1)
+    {
+        double mean     = interval_sum / nb_intervals;
+        double variance = (interval_square_sum / nb_intervals) - (mean * mean);
+
+        out_values.wait_jitter = (variance > 0.0) ? sqrt(variance) : 0.0;
+    }
+
+    DEB_RETURN() << DEB_VAR4(out_values.window, out_values.frame_rate, out_values.throughput, out_values.lost_frame_rate);
+}
@@ -0,0 +1,537 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2012
+// European Synchrotron Radiation Facility
+// BP 220, Grenoble 38043
+// FRANCE
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+#include "HamamatsuSystemTuning.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+using namespace lima;
+using namespace lima::Hamamatsu;
+using namespace std;
+
+#if defined(_WIN32)
+static const int g_group_size = 64; // cpus of a Windows processor group
+#else
+// memory policy values of the Linux kernel (numaif.h, not needed with the system calls)
+static const int      g_mpol_bind    = 2     ; // MPOL_BIND
+static const unsigned g_mpol_mf_move = 1 << 1; // MPOL_MF_MOVE
+static const unsigned g_mpol_f_node  = 1 << 0; // MPOL_F_NODE
+static const unsigned g_mpol_f_addr  = 1 << 1; // MPOL_F_ADDR
+#endif
+
+//-----------------------------------------------------------------------------
+/// Set the scheduling priority of the calling thread
+//-----------------------------------------------------------------------------
+void SystemTuning::setCurrentThreadPriority(Priority in_priority) ///< [in] scheduling priority of the calling thread
+{
+    DEB_STATIC_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_priority);
+
+#if defined(_WIN32)
+    int priority = THREAD_PRIORITY_NORMAL;
+
+    if(in_priority == Priority_High)
+        priority = THREAD_PRIORITY_HIGHEST;
+    else
+    if(in_priority == Priority_Realtime)
+        priority = THREAD_PRIORITY_TIME_CRITICAL;
+
+    if(!SetThreadPriority(GetCurrentThread(), priority))
+    {
+        THROW_HW_ERROR(Error) << "Cannot set the thread priority (error " << GetLastError() << ")";
+    }
+#else
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+
+    int policy = SCHED_OTHER;
+
+    if(in_priority == Priority_High)
+    {
+        policy               = SCHED_RR;
+        param.sched_priority = (sched_get_priority_min(policy) + sched_get_priority_max(policy)) / 2;
+    }
+    else
+    if(in_priority == Priority_Realtime)
+    {
+        policy               = SCHED_FIFO;
+        param.sched_priority = sched_get_priority_max(policy) - 1;
+    }
+
+    int err = pthread_setschedparam(pthread_self(), policy, &param);
+
+    if(err != 0)
+    {
+        THROW_HW_ERROR(Error) << "Cannot set the thread priority: " << strerror(err);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Restrict the calling thread to a set of cpus.
+/// On Windows, the cpus must belong to the same processor group.
+//-----------------------------------------------------------------------------
+void SystemTuning::setCurrentThreadCpus(const std::vector<int> & in_cpus) ///< [in] cpus allowed for the calling thread (empty: all)
+{
+    DEB_STATIC_FUNCT();
+    DEB_PARAM() << DEB_VAR1(getCpusText(in_cpus));
+
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity;
+    memset(&affinity, 0, sizeof(affinity));
+
+    if(in_cpus.empty())
+    {
+        // all the cpus of the current group
+        GetThreadGroupAffinity(GetCurrentThread(), &affinity);
+
+        DWORD nb_cpus = GetActiveProcessorCount(affinity.Group);
+        affinity.Mask = (nb_cpus >= g_group_size) ? ~static_cast<KAFFINITY>(0) : ((static_cast<KAFFINITY>(1) << nb_cpus) - 1);
+    }
+    else
+    {
+        affinity.Group = static_cast<WORD>(in_cpus[0] / g_group_size);
+
+        for(size_t cpu_index = 0 ; cpu_index < in_cpus.size() ; cpu_index++)
+        {
+            if((in_cpus[cpu_index] < 0) || ((in_cpus[cpu_index] / g_group_size) != affinity.Group))
+            {
+                THROW_HW_ERROR(Error) << "Incorrect cpu set " << getCpusText(in_cpus) << " (the cpus must be in the same processor group)";
+            }
+
+            affinity.Mask |= static_cast<KAFFINITY>(1ULL << (in_cpus[cpu_index] % g_group_size));
+        }
+    }
+
+    if(!SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL))
+    {
+        THROW_HW_ERROR(Error) << "Cannot set the cpus " << getCpusText(in_cpus) << " (error " << GetLastError() << ")";
+    }
+#else
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    if(in_cpus.empty())
+    {
+        long nb_cpus = sysconf(_SC_NPROCESSORS_CONF);
+
+        for(long cpu = 0 ; (cpu < nb_cpus) && (cpu < CPU_SETSIZE) ; cpu++)
+            CPU_SET(cpu, &cpu_set);
+    }
+    else
+    {
+        for(size_t cpu_index = 0 ; cpu_index < in_cpus.size() ; cpu_index++)
+        {
+            if((in_cpus[cpu_index] < 0) || (in_cpus[cpu_index] >= CPU_SETSIZE))
+            {
+                THROW_HW_ERROR(Error) << "Incorrect cpu set " << getCpusText(in_cpus);
+            }
+
+            CPU_SET(in_cpus[cpu_index], &cpu_set);
+        }
+    }
+
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+
+    if(err != 0)
+    {
+        THROW_HW_ERROR(Error) << "Cannot set the cpus " << getCpusText(in_cpus) << ": " << strerror(err);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Get the cpus allowed for the calling thread
+//-----------------------------------------------------------------------------
+std::vector<int> SystemTuning::getCurrentThreadCpus(void)
+{
+    vector<int> cpus;
+
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity;
+
+    if(GetThreadGroupAffinity(GetCurrentThread(), &affinity))
+    {
+        for(int bit = 0 ; bit < g_group_size ; bit++)
+        {
+            if(affinity.Mask & (static_cast<KAFFINITY>(1) << bit))
+                cpus.push_back(affinity.Group * g_group_size + bit);
+        }
+    }
+#else
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    if(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0)
+    {
+        for(int cpu = 0 ; cpu < CPU_SETSIZE ; cpu++)
+        {
+            if(CPU_ISSET(cpu, &cpu_set))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+
+    return cpus;
+}
+
+//-----------------------------------------------------------------------------
+/// Describe the effective priority and cpus of the calling thread
+//-----------------------------------------------------------------------------
+std::string SystemTuning::getCurrentThreadSettings(void)
+{
+    ostringstream text;
+
+#if defined(_WIN32)
+    text << "priority " << GetThreadPriority(GetCurrentThread());
+#else
+    int                policy;
+    struct sched_param param ;
+
+    if(pthread_getschedparam(pthread_self(), &policy, &param) == 0)
+    {
+        text << ((policy == SCHED_FIFO) ? "SCHED_FIFO" : ((policy == SCHED_RR) ? "SCHED_RR" : "SCHED_OTHER"))
+             << " priority " << param.sched_priority;
+    }
+#endif
+
+    text << ", cpus " << getCpusText(getCurrentThreadCpus());
+    return text.str();
+}
+
+//-----------------------------------------------------------------------------
+/// Get the cpus of a NUMA node
+//-----------------------------------------------------------------------------
+std::vector<int> SystemTuning::getNumaNodeCpus(int in_node) ///< [in] NUMA node
+{
+    DEB_STATIC_FUNCT();
+    DEB_PARAM() << DEB_VAR1(in_node);
+
+    vector<int> cpus;
+
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity;
+
+    if((in_node < 0) || !GetNumaNodeProcessorMaskEx(static_cast<USHORT>(in_node), &affinity))
+    {
+        THROW_HW_ERROR(Error) << "Incorrect NUMA node: " << in_node;
+    }
+
+    for(int bit = 0 ; bit < g_group_size ; bit++)
+    {
+        if(affinity.Mask & (static_cast<KAFFINITY>(1) << bit))
+            cpus.push_back(affinity.Group * g_group_size + bit);
+    }
+#else
+    // cpu list of the node, e.g. "0-7,16-23"
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "/sys/devices/system/node/node%d/cpulist", in_node);
+
+    FILE * file = (in_node >= 0) ? fopen(file_name, "r") : NULL;
+
+    if(file == NULL)
+    {
+        THROW_HW_ERROR(Error) << "Incorrect NUMA node: " << in_node;
+    }
+
+    int  first = 0;
+    int  last  = 0;
+    char separator;
+
+    while(fscanf(file, "%d", &first) == 1)
+    {
+        last = first;
+
+        if((fscanf(file, "%c", &separator) == 1) && (separator == '-'))
+        {
+            if(fscanf(file, "%d", &last) != 1)
+                break;
+
+            if(fscanf(file, "%c", &separator) != 1)
+                separator = '\n';
+        }
+
+        for(int cpu = first ; cpu <= last ; cpu++)
+            cpus.push_back(cpu);
+
+        if(separator != ',')
+            break;
+    }
+
+    fclose(file);
+#endif
+
+    if(cpus.empty())
+    {
+        THROW_HW_ERROR(Error) << "NUMA node " << in_node << " has no cpu";
+    }
+
+    return cpus;
+}
+
+//-----------------------------------------------------------------------------
+/// Get the size of a memory page
+//-----------------------------------------------------------------------------
+size_t SystemTuning::getPageSize(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwPageSize);
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Write each page of a memory area, so the pages are mapped now (on the NUMA
+/// node of the calling thread if they were not touched yet) and not during 
+/// the acquisition. The content of the memory is not kept.
+//-----------------------------------------------------------------------------
+void SystemTuning::touchPages(char * in_address, ///< [in] first byte of the memory
+                              size_t in_size   ) ///< [in] size of the memory
+{
+    if(in_size == 0)
+        return;
+
+    size_t page_size = getPageSize();
+
+    for(size_t offset = 0 ; offset < in_size ; offset += page_size)
+        static_cast<volatile char *>(in_address)[offset] = 0;
+
+    static_cast<volatile char *>(in_address)[in_size - 1] = 0;
+}
+
+//-----------------------------------------------------------------------------
+/// Ask the system to back a memory area with huge pages (transparent huge 
+/// pages on Linux). Only the pages not touched yet are concerned.
+/// Windows can only give large pages to a new allocation, so nothing is done.
+//-----------------------------------------------------------------------------
+bool SystemTuning::adviseHugePages(char * in_address, ///< [in] first byte of the memory
+                                   size_t in_size   ) ///< [in] size of the memory
+{
+#if defined(_WIN32) || !defined(MADV_HUGEPAGE)
+    return false;
+#else
+    // madvise needs an address aligned on a page
+    size_t page_size = getPageSize();
+    size_t start     = (reinterpret_cast<size_t>(in_address) + page_size - 1) & ~(page_size - 1);
+    size_t end       = (reinterpret_cast<size_t>(in_address) + in_size) & ~(page_size - 1);
+
+    if(end <= start)
+        return false;
+
+    return (madvise(reinterpret_cast<void *>(start), end - start, MADV_HUGEPAGE) == 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Place a memory area on a NUMA node: the pages already mapped are moved to
+/// the node and the next ones are allocated on it (Linux mbind). Windows can 
+/// only place a new allocation (VirtualAllocExNuma) and the lima buffers are
+/// allocated by Lima, so nothing is done: only the pages not mapped yet follow
+/// the node of the thread which touches them first.
+//-----------------------------------------------------------------------------
+bool SystemTuning::bindMemoryToNode(char * in_address, ///< [in] first byte of the memory
+                                    size_t in_size   , ///< [in] size of the memory
+                                    int    in_node   ) ///< [in] NUMA node
+{
+#if defined(_WIN32) || !defined(SYS_mbind)
+    return false;
+#else
+    if(in_node < 0)
+        return false;
+
+    // mbind needs an address aligned on a page, the first and last partial pages are shared with other memory
+    size_t page_size = getPageSize();
+    size_t start     = (reinterpret_cast<size_t>(in_address) + page_size - 1) & ~(page_size - 1);
+    size_t end       = (reinterpret_cast<size_t>(in_address) + in_size) & ~(page_size - 1);
+
+    if(end <= start)
+        return false;
+
+    const size_t          long_bits = sizeof(unsigned long) * 8;
+    vector<unsigned long> node_mask((static_cast<size_t>(in_node) / long_bits) + 1, 0);
+
+    node_mask[static_cast<size_t>(in_node) / long_bits] = 1UL << (static_cast<size_t>(in_node) % long_bits);
+
+    return (syscall(SYS_mbind, start, end - start, g_mpol_bind, &node_mask[0], 
+                    node_mask.size() * long_bits + 1, g_mpol_mf_move) == 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Get the NUMA node of a mapped page (-1 if unknown)
+//-----------------------------------------------------------------------------
+int SystemTuning::getMemoryNode(const char * in_address) ///< [in] byte of a mapped page
+{
+#if defined(_WIN32)
+    PSAPI_WORKING_SET_EX_INFORMATION info;
+    memset(&info, 0, sizeof(info));
+    info.VirtualAddress = const_cast<char *>(in_address);
+
+    if(!QueryWorkingSetEx(GetCurrentProcess(), &info, sizeof(info)) || !info.VirtualAttributes.Valid)
+        return -1;
+
+    return static_cast<int>(info.VirtualAttributes.Node);
+#elif defined(SYS_get_mempolicy)
+    int node = -1;
+
+    if(syscall(SYS_get_mempolicy, &node, NULL, 0, in_address, g_mpol_f_node | g_mpol_f_addr) != 0)
+        return -1;
+
+    return node;
+#else
+    return -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Make room for the memory which will be locked: on Windows the locked pages
+/// are limited by the minimum working set of the process, which is increased.
+/// On Linux, checks the locked memory limit of the process.
+//-----------------------------------------------------------------------------
+bool SystemTuning::reserveLockedMemory(size_t in_size) ///< [in] memory which will be locked
+{
+    DEB_STATIC_FUNCT();
+
+#if defined(_WIN32)
+    SIZE_T min_size = 0;
+    SIZE_T max_size = 0;
+
+    if(!GetProcessWorkingSetSize(GetCurrentProcess(), &min_size, &max_size))
+        return false;
+
+    if(!SetProcessWorkingSetSize(GetCurrentProcess(), min_size + in_size, max_size + in_size))
+    {
+        DEB_WARNING() << "Cannot increase the working set of " << in_size << " bytes (error " << GetLastError() << ")";
+        return false;
+    }
+
+    return true;
+#else
+    struct rlimit limit;
+
+    if((getrlimit(RLIMIT_MEMLOCK, &limit) == 0) && (limit.rlim_cur != RLIM_INFINITY) && (limit.rlim_cur < in_size))
+    {
+        DEB_WARNING() << "The locked memory limit (" << limit.rlim_cur << " bytes) is lower than " << in_size << " bytes";
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Give back the room reserved for memory which is no longer locked: on Windows
+/// the minimum working set of the process is decreased. Nothing to do on Linux.
+//-----------------------------------------------------------------------------
+void SystemTuning::releaseLockedMemory(size_t in_size) ///< [in] memory which is no longer locked
+{
+    DEB_STATIC_FUNCT();
+
+#if defined(_WIN32)
+    SIZE_T min_size = 0;
+    SIZE_T max_size = 0;
+
+    if((in_size == 0) || !GetProcessWorkingSetSize(GetCurrentProcess(), &min_size, &max_size))
+        return;
+
+    if((min_size < in_size) || (max_size < in_size) || 
+       !SetProcessWorkingSetSize(GetCurrentProcess(), min_size - in_size, max_size - in_size))
+    {
+        DEB_WARNING() << "Cannot decrease the working set of " << in_size << " bytes (error " << GetLastError() << ")";
+    }
+#else
+    (void)in_size;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Lock a memory area in physical memory (no page fault, never paged out)
+//-----------------------------------------------------------------------------
+bool SystemTuning::lockMemory(char * in_address, ///< [in] first byte of the memory
+                              size_t in_size   ) ///< [in] size of the memory
+{
+#if defined(_WIN32)
+    return (VirtualLock(in_address, in_size) != 0);
+#else
+    return (mlock(in_address, in_size) == 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Unlock a memory area locked by lockMemory
+//-----------------------------------------------------------------------------
+bool SystemTuning::unlockMemory(char * in_address, ///< [in] first byte of the memory
+                                size_t in_size   ) ///< [in] size of the memory
+{
+#if defined(_WIN32)
+    return (VirtualUnlock(in_address, in_size) != 0);
+#else
+    return (munlock(in_address, in_size) == 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/// Describe a set of cpus (e.g. "0-3,8")
+//-----------------------------------------------------------------------------
+std::string SystemTuning::getCpusText(const std::vector<int> & in_cpus) ///< [in] cpus to describe
+{
+    if(in_cpus.empty())
+        return "all";
+
+    ostringstream text;
+    size_t        cpu_index = 0;
+
+    while(cpu_index < in_cpus.size())
+    {
+        size_t last_index = cpu_index;
+
+        while((last_index + 1 < in_cpus.size()) && (in_cpus[last_index + 1] == in_cpus[last_index] + 1))
+            last_index++;
+
+        if(cpu_index > 0)
+            text << ",";
+
+        text << in_cpus[cpu_index];
+
+        if(last_index > cpu_index)
+            text << "-" << in_cpus[last_index];
+
+        cpu_index = last_index + 1;
+    }
+
+    return text.str();
+}